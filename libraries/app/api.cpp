@@ -27,6 +27,7 @@
 #include <sigmaengine/app/api_access.hpp>
 #include <sigmaengine/app/application.hpp>
 #include <sigmaengine/app/impacted.hpp>
+#include <sigmaengine/app/transaction_confirmations.hpp>
 
 #include <sigmaengine/protocol/get_config.hpp>
 
@@ -76,6 +77,10 @@ namespace sigmaengine { namespace app {
        std::shared_ptr< api_session_data > session = _ctx.session.lock();
        FC_ASSERT( session );
 
+       // A login never outlived its HTTP request, and the shared HTTP session must not grant APIs to every caller
+       if( session->stateless )
+          return true;
+
        std::map< std::string, api_ptr >& _api_map = session->api_map;
 
        for( const std::string& api_name : acc->allowed_apis )
@@ -119,17 +124,18 @@ namespace sigmaengine { namespace app {
 
     network_broadcast_api::network_broadcast_api(const api_context& a):_app(a.app)
     {
-       /// NOTE: cannot register callbacks in constructor because shared_from_this() is not valid.
        _app.get_max_block_age( _max_block_age );
     }
 
-    void network_broadcast_api::on_api_startup()
+    network_broadcast_api::~network_broadcast_api()
     {
-       /// note cannot capture shared pointer here, because _applied_block_connection will never
-       /// be freed if the lambda holds a reference to it.
-       _applied_block_connection = connect_signal( _app.chain_database()->applied_block, *this, &network_broadcast_api::on_applied_block );
+       // callbacks still waiting would call into a connection that is gone
+       if( auto confirmations = _app.pending_confirmations() )
+          confirmations->remove_owner( this );
     }
 
+    void network_broadcast_api::on_api_startup() {}
+
     bool network_broadcast_api::check_max_block_age( int32_t max_block_age )
     {
        return _app.chain_database()->with_read_lock( [&]()
@@ -150,54 +156,6 @@ namespace sigmaengine { namespace app {
        _max_block_age = max_block_age;
     }
 
-    void network_broadcast_api::on_applied_block( const signed_block& b )
-    {
-       /// we need to ensure the database_api is not deleted for the life of the async operation
-       auto capture_this = shared_from_this();
-
-       fc::async( [this,capture_this,b]() {
-          int32_t block_num = int32_t(b.block_num());
-          if( _callbacks.size() )
-          {
-             for( size_t trx_num = 0; trx_num < b.transactions.size(); ++trx_num )
-             {
-                const auto& trx = b.transactions[trx_num];
-                auto id = trx.id();
-                auto itr = _callbacks.find(id);
-                if( itr == _callbacks.end() ) continue;
-                confirmation_callback callback = itr->second;
-                itr->second = [](variant){};
-                callback( fc::variant(transaction_confirmation( id, block_num, int32_t(trx_num), false )) );
-             }
-          }
-
-          /// clear all expirations
-          while( true )
-          {
-             auto exp_it = _callbacks_expirations.begin();
-             if( exp_it == _callbacks_expirations.end() )
-                break;
-             if( exp_it->first >= b.timestamp )
-                break;
-             for( const transaction_id_type& txid : exp_it->second )
-             {
-                auto cb_it = _callbacks.find( txid );
-                // If it's empty, that means the transaction has been confirmed and has been deleted by the above check.
-                if( cb_it == _callbacks.end() )
-                   continue;
-
-                confirmation_callback callback = cb_it->second;
-                transaction_id_type txid_byval = txid;    // can't pass in by reference as it's going to be deleted
-                callback( fc::variant(transaction_confirmation{ txid_byval, block_num, -1, true}) );
-
-                _callbacks.erase( cb_it );
-             }
-             _callbacks_expirations.erase( exp_it );
-          }
-       }); /// fc::async
-
-    }
-
     void network_broadcast_api::broadcast_transaction(const signed_transaction& trx)
     {
        trx.validate();
@@ -237,7 +195,8 @@ namespace sigmaengine { namespace app {
        else
        {
           promise<fc::variant>::ptr prom( new fc::promise<fc::variant>() );
-          broadcast_transaction_with_callback( [=]( const fc::variant& v ){
+          // owned by the call rather than the connection, which every HTTP caller shares
+          broadcast_with_confirmation( prom.get(), [=]( const fc::variant& v ){
              prom->set_value(v);
           }, trx );
           return future<fc::variant>(prom).wait();
@@ -279,14 +238,32 @@ namespace sigmaengine { namespace app {
        }
        else
        {
-          FC_ASSERT( !check_max_block_age( _max_block_age ) );
-          trx.validate();
-          _callbacks[trx.id()] = cb;
-          _callbacks_expirations[trx.expiration].push_back(trx.id());
+          broadcast_with_confirmation( this, cb, trx );
+       }
+    }
 
+    void network_broadcast_api::broadcast_with_confirmation( const void* owner, confirmation_callback cb, const signed_transaction& trx )
+    {
+       FC_ASSERT( !check_max_block_age( _max_block_age ) );
+       trx.validate();
+       transaction_id_type id = trx.id();
+       // registered before the push so that a block containing it can not be missed
+       uint64_t handle = _app.pending_confirmations()->add( owner, id, trx.expiration,
+          [cb,id]( int32_t block_num, int32_t trx_num, bool expired ) {
+             cb( fc::variant( transaction_confirmation( id, block_num, trx_num, expired ) ) );
+          } );
+
+       try
+       {
           _app.chain_database()->push_transaction(trx);
-          _app.p2p_node()->broadcast_transaction(trx);
        }
+       catch( ... )
+       {
+          // only this registration; an earlier one for the same transaction is still waiting
+          _app.pending_confirmations()->remove( handle );
+          throw;
+       }
+       _app.p2p_node()->broadcast_transaction(trx);
     }
 
     network_node_api::network_node_api( const api_context& a ) : _app( a.app )
@@ -317,6 +294,24 @@ namespace sigmaengine { namespace app {
        return _app.p2p_node()->get_potential_peers();
     }
 
+    rpc_stats network_node_api::get_rpc_stats() const
+    {
+       return _app.get_rpc_stats();
+    }
+
+    graphene::net::network_metrics network_node_api::get_network_metrics() const
+    {
+       return _app.p2p_node()->get_network_metrics();
+    }
+
+    std::vector< chain::due_processor_metrics > network_node_api::get_due_processor_metrics() const
+    {
+       return _app.chain_database()->with_read_lock( [&]()
+       {
+          return _app.chain_database()->get_due_processor_metrics();
+       });
+    }
+
     fc::variant_object network_node_api::get_advanced_node_parameters() const
     {
        return _app.p2p_node()->get_advanced_node_parameters();
@@ -25,6 +25,7 @@
 #include <sigmaengine/app/api_access.hpp>
 #include <sigmaengine/app/application.hpp>
 #include <sigmaengine/app/plugin.hpp>
+#include <sigmaengine/app/transaction_confirmations.hpp>
 
 #include <sigmaengine/chain/sigmaengine_objects.hpp>
 #include <sigmaengine/chain/sigmaengine_object_types.hpp>
@@ -41,7 +42,9 @@
 
 #include <fc/io/fstream.hpp>
 #include <fc/rpc/api_connection.hpp>
+#include <fc/rpc/request_log.hpp>
 #include <fc/rpc/websocket_api.hpp>
+#include <fc/network/http/server.hpp>
 #include <fc/network/resolve.hpp>
 #include <fc/stacktrace.hpp>
 #include <fc/string.hpp>
@@ -80,6 +83,19 @@ api_context::api_context( application& _app, const std::string& _api_name, std::
 
 namespace detail {
 
+   /**
+    * The connection behind the shared HTTP session.  HTTP replies are returned
+    * from on_http, and there is no channel to push callbacks or notices on.
+    */
+   class http_session_connection : public fc::http::websocket_connection
+   {
+      public:
+         virtual void send_message( const std::string& message )override
+         {
+            dlog( "Dropping message for HTTP session: ${m}", ("m", message) );
+         }
+   };
+
    class application_impl : public graphene::net::node_delegate
    {
    public:
@@ -133,6 +149,10 @@ namespace detail {
             ilog("Setting p2p max connections to ${n}", ("n", node_param["maximum_number_of_connections"]));
          }
 
+         _p2p_network->set_advanced_node_parameters( fc::mutable_variant_object()
+            ( "enable_compact_blocks", _options->at("p2p-compact-blocks").as<bool>() )
+            ( "enable_aead_channel", _options->at("p2p-aead-encryption").as<bool>() ) );
+
          _p2p_network->listen_to_p2p_network();
          ilog("Configured p2p node to listen on ${ip}", ("ip", _p2p_network->get_actual_listening_endpoint()));
 
@@ -148,6 +168,28 @@ namespace detail {
                                  std::vector<uint32_t>());
       } FC_CAPTURE_AND_RETHROW() }
 
+      /// Serves the p2p metrics to Prometheus, plain HTTP on any path
+      void reset_p2p_metrics_server()
+      { try {
+         if( !_options->count("p2p-metrics-endpoint") )
+            return;
+
+         _p2p_metrics_server = std::make_shared<fc::http::server>();
+         _p2p_metrics_server->on_request( [this]( const fc::http::request& req, const fc::http::server::response& resp )
+         {
+            std::string body = graphene::net::to_prometheus_text( _p2p_network->get_network_metrics() );
+            resp.add_header( "Content-Type", "text/plain; version=0.0.4" );
+            resp.set_status( fc::http::reply::OK );
+            resp.set_length( body.size() );
+            resp.write( body.c_str(), body.size() );
+         } );
+         auto metrics_endpoint = _options->at("p2p-metrics-endpoint").as<string>();
+         auto endpoints = resolve_string_to_ip_endpoints( metrics_endpoint );
+         FC_ASSERT( endpoints.size(), "p2p-metrics-endpoint ${hostname} did not resolve", ("hostname", metrics_endpoint) );
+         _p2p_metrics_server->listen( endpoints[0] );
+         ilog("Serving p2p metrics on ${ip}", ("ip", metrics_endpoint));
+      } FC_CAPTURE_AND_RETHROW() }
+
       std::vector<fc::ip::endpoint> resolve_string_to_ip_endpoints(const std::string& endpoint_string)
       {
          try
@@ -183,6 +225,9 @@ namespace detail {
          _websocket_server = std::make_shared<fc::http::websocket_server>();
 
          _websocket_server->on_connection([&]( const fc::http::websocket_connection_ptr& c ){ on_connection(c); } );
+         _websocket_server->on_http([this]( const std::string& body ){ return on_http_request( body ); } );
+         _websocket_server->set_worker_pool( _rpc_worker_threads, _rpc_max_pending );
+         _websocket_server->set_compression( _rpc_compress_min_size, _rpc_compression_level );
          auto rpc_endpoint = _options->at("rpc-endpoint").as<string>();
          ilog("Configured websocket rpc to listen on ${ip}", ("ip", rpc_endpoint));
          auto endpoints = resolve_string_to_ip_endpoints( rpc_endpoint );
@@ -206,6 +251,9 @@ namespace detail {
          _websocket_tls_server = std::make_shared<fc::http::websocket_tls_server>( _options->at("server-pem").as<string>(), password );
 
          _websocket_tls_server->on_connection([this]( const fc::http::websocket_connection_ptr& c ){ on_connection(c); } );
+         _websocket_tls_server->on_http([this]( const std::string& body ){ return on_http_request( body ); } );
+         _websocket_tls_server->set_worker_pool( _rpc_worker_threads, _rpc_max_pending );
+         _websocket_tls_server->set_compression( _rpc_compress_min_size, _rpc_compression_level );
          auto rpc_tls_endpoint = _options->at("rpc-tls-endpoint").as<string>();
          ilog("Configured websocket TLS rpc to listen on ${ip}", ("ip", rpc_tls_endpoint));
          auto endpoints = resolve_string_to_ip_endpoints( rpc_tls_endpoint );
@@ -214,10 +262,21 @@ namespace detail {
          _websocket_tls_server->start_accept();
       } FC_CAPTURE_AND_RETHROW() }
 
-      void on_connection( const fc::http::websocket_connection_ptr& c )
+      void on_connection( const fc::http::websocket_connection_ptr& c, bool stateless = false )
       {
          std::shared_ptr< api_session_data > session = std::make_shared<api_session_data>();
+         session->stateless = stateless;
          session->wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c);
+         // the shared HTTP session can never deliver a callback
+         session->wsc->set_callbacks_enabled( !stateless );
+         session->wsc->set_max_batch_size( _rpc_max_batch_size );
+         session->wsc->set_request_log( _rpc_request_log );
+
+         std::weak_ptr< api_session_data > weak_session = session;
+         session->wsc->set_call_dispatcher( [this,weak_session]( fc::api_id_type api_id, const std::string& method, const std::function< void() >& call )
+         {
+            dispatch_call( weak_session, api_id, method, call );
+         } );
 
          for( const std::string& name : _public_apis )
          {
@@ -229,11 +288,100 @@ namespace detail {
                continue;
             }
             session->api_map[name] = api;
-            api->register_api( *session->wsc );
+            session->api_names[ api->register_api( *session->wsc ) ] = name;
          }
          c->set_session_data( session );
       }
 
+      /**
+       * Plain HTTP requests have no session, so they all share one set of API
+       * instances.  It is built on the first request, after plugins have registered
+       * their API factories, and lives as long as the application.
+       */
+      std::string on_http_request( const std::string& body )
+      {
+         fc::http::websocket_connection_ptr con;
+         {
+            // HTTP requests may arrive on several RPC workers at once
+            boost::lock_guard< boost::mutex > lock( _http_connection_mutex );
+            if( !_http_connection )
+            {
+               auto new_con = std::make_shared< detail::http_session_connection >();
+               on_connection( new_con, true );
+               _http_connection = new_con;
+            }
+            con = _http_connection;
+         }
+         return con->on_http( body );
+      }
+
+      /**
+       * Runs an API call for a connection.  Calls to APIs listed in rpc-worker-api run
+       * on the RPC worker that received them; anything else may touch state that is
+       * not thread safe and is handed to the RPC server thread.  So are methods that
+       * register callbacks or APIs on the connection, whichever API they belong to.
+       */
+      void dispatch_call( const std::weak_ptr< api_session_data >& weak_session, fc::api_id_type api_id,
+                          const std::string& method, const std::function< void() >& call )
+      {
+         std::string api_name;
+         if( auto session = weak_session.lock() )
+         {
+            auto itr = session->api_names.find( api_id );
+            if( itr != session->api_names.end() )
+               api_name = itr->second;
+         }
+
+         auto start = fc::time_point::now();
+         bool ok = false;
+         try
+         {
+            if( _rpc_thread == nullptr || &fc::thread::current() == _rpc_thread
+                || ( _rpc_worker_apis.count( api_name ) && !_rpc_thread_methods.count( method ) ) )
+               call();
+            else
+               _rpc_thread->async( [&]() { call(); }, "rpc call" ).wait();
+            ok = true;
+         }
+         catch( ... )
+         {
+            record_rpc_call( api_name, method, fc::time_point::now() - start, ok );
+            throw;
+         }
+         record_rpc_call( api_name, method, fc::time_point::now() - start, ok );
+      }
+
+      void record_rpc_call( const std::string& api_name, const std::string& method, const fc::microseconds& elapsed, bool ok )
+      {
+         const uint64_t us = elapsed.count();
+         boost::lock_guard< boost::mutex > lock( _rpc_stats_mutex );
+         auto& s = _rpc_method_stats[ ( api_name.empty() ? std::string( "unknown" ) : api_name ) + "." + method ];
+         ++s.calls;
+         if( !ok )
+            ++s.errors;
+         s.total_us += us;
+         s.max_us = std::max( s.max_us, us );
+      }
+
+      rpc_stats get_rpc_stats()const
+      {
+         rpc_stats result;
+         for( const auto& s : { _websocket_server ? _websocket_server->get_stats() : fc::http::websocket_server_stats(),
+                                _websocket_tls_server ? _websocket_tls_server->get_stats() : fc::http::websocket_server_stats() } )
+         {
+            result.worker_threads = std::max( result.worker_threads, s.worker_threads );
+            result.queued_messages += s.queued_messages;
+            result.max_queue_depth = std::max( result.max_queue_depth, s.max_queue_depth );
+            result.processed_messages += s.processed_messages;
+            result.http_requests += s.http_requests;
+            result.backpressure_waits += s.backpressure_waits;
+         }
+
+         boost::lock_guard< boost::mutex > lock( _rpc_stats_mutex );
+         result.methods = _rpc_method_stats;
+         return result;
+      }
+
       application_impl(application* self)
          : _self(self),
            //_pending_trx_db(std::make_shared<graphene::db::object_database>()),
@@ -267,6 +415,19 @@ namespace detail {
          if( _options->count("check-locks") )
             _chain_db->set_require_locking( true );
 
+         {
+            chainbase::mapping_options mapping;
+            const auto huge_pages = _options->at( "shared-file-huge-pages" ).as< string >();
+            if( huge_pages == "transparent" )
+               mapping.huge_pages = chainbase::mapping_options::huge_pages_transparent;
+            else
+               FC_ASSERT( huge_pages == "none", "shared-file-huge-pages must be 'none' or 'transparent'", ("value", huge_pages) );
+            mapping.prefault = _options->at( "shared-file-prefault" ).as< bool >();
+            mapping.lock = _options->at( "shared-file-lock" ).as< bool >();
+            mapping.numa_node = _options->at( "shared-file-numa-node" ).as< int32_t >();
+            _chain_db->set_mapping_options( mapping );
+         }
+
          if( _options->count("shared-file-dir") )
             _shared_dir = fc::path( _options->at("shared-file-dir").as<string>() );
          else
@@ -285,6 +446,15 @@ namespace detail {
                _chain_db->wipe(_data_dir / "blockchain", _shared_dir, true);
 
             _chain_db->set_flush_interval( _options->at("flush").as<uint32_t>() );
+            _chain_db->set_background_flush( _options->at( "flush-in-background" ).as< bool >() );
+            _chain_db->set_max_pending_transactions_size( fc::parse_size( _options->at( "max-pending-transactions-size" ).as< string >() ) );
+            _chain_db->set_store_recent_transactions( _options->at( "store-recent-transactions" ).as< bool >() );
+            _chain_db->set_block_log_queue_size( _options->at( "block-log-queue-size" ).as< uint32_t >() );
+
+            _transaction_confirmations = std::make_shared< transaction_confirmations >(
+               _options->at( "max-pending-confirmations-per-connection" ).as< uint32_t >(),
+               _options->at( "max-pending-confirmations" ).as< uint32_t >() );
+            _chain_db->applied_block.connect( [this]( const signed_block& b ){ _transaction_confirmations->on_applied_block( b ); } );
 
             flat_map<uint32_t,block_id_type> loaded_checkpoints;
             if( _options->count("checkpoint") )
@@ -399,12 +569,53 @@ ilog( "_options->count(black-list) : ${ccc}", ("ccc", _options->count("black-lis
          if( !read_only )
          {
             reset_p2p_node(_data_dir);
+            reset_p2p_metrics_server();
+         }
+
+         _rpc_thread = &fc::thread::current();
+         _rpc_worker_threads = _options->at( "rpc-worker-threads" ).as< uint32_t >();
+         _rpc_max_pending = _options->at( "rpc-max-pending-per-connection" ).as< uint32_t >();
+         _rpc_max_batch_size = _options->at( "rpc-max-batch-size" ).as< uint32_t >();
+         _rpc_compress_min_size = _options->at( "rpc-compress-min-size" ).as< uint32_t >();
+         _rpc_compression_level = _options->at( "rpc-compression-level" ).as< int32_t >();
+         FC_ASSERT( _rpc_compression_level >= 1 && _rpc_compression_level <= 9, "rpc-compression-level must be between 1 and 9" );
+         reset_rpc_request_log();
+         for( const std::string& arg : _options->at( "rpc-worker-api" ).as< std::vector< std::string > >() )
+         {
+            std::vector< std::string > names;
+            boost::split( names, arg, boost::is_any_of( " \t," ) );
+            for( const std::string& name : names )
+               if( !name.empty() )
+                  _rpc_worker_apis.insert( name );
          }
 
          reset_websocket_server();
          reset_websocket_tls_server();
       } FC_LOG_AND_RETHROW() }
 
+      void reset_rpc_request_log()
+      { try {
+         auto request_log = std::make_shared< fc::rpc::request_log >();
+         request_log->set_sample_rate( _options->at( "rpc-log-sample-rate" ).as< double >() );
+         if( _options->count( "rpc-log-method-sample-rate" ) )
+         {
+            for( const std::string& arg : _options->at( "rpc-log-method-sample-rate" ).as< std::vector< std::string > >() )
+            {
+               auto eq = arg.find( '=' );
+               FC_ASSERT( eq != std::string::npos, "Expected api.method=rate, got ${arg}", ("arg", arg) );
+               request_log->set_method_sample_rate( boost::trim_copy( arg.substr( 0, eq ) ),
+                                                    boost::lexical_cast< double >( boost::trim_copy( arg.substr( eq + 1 ) ) ) );
+            }
+         }
+         if( _options->count( "rpc-slow-call-warn-ms" ) || _options->count( "rpc-slow-call-error-ms" ) )
+         {
+            request_log->set_slow_call_thresholds(
+               fc::milliseconds( _options->count( "rpc-slow-call-warn-ms" ) ? _options->at( "rpc-slow-call-warn-ms" ).as< uint32_t >() : 0 ),
+               fc::milliseconds( _options->count( "rpc-slow-call-error-ms" ) ? _options->at( "rpc-slow-call-error-ms" ).as< uint32_t >() : 0 ) );
+         }
+         _rpc_request_log = request_log;
+      } FC_CAPTURE_AND_RETHROW() }
+
       optional< api_access_info > get_api_access_info(const string& username)const
       {
          optional< api_access_info > result;
@@ -925,8 +1136,34 @@ ilog( "_options->count(black-list) : ${ccc}", ("ccc", _options->count("black-lis
       //std::shared_ptr<graphene::db::object_database>   _pending_trx_db;
       std::shared_ptr<sigmaengine::chain::database>        _chain_db;
       std::shared_ptr<graphene::net::node>             _p2p_network;
+      std::shared_ptr<transaction_confirmations>       _transaction_confirmations;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
+      std::shared_ptr<fc::http::server>                _p2p_metrics_server;
+      fc::http::websocket_connection_ptr               _http_connection;
+      boost::mutex                                     _http_connection_mutex;
+
+      /// Thread the websocket servers were created on, which runs calls not handled by RPC workers
+      fc::thread*                                      _rpc_thread = nullptr;
+      uint32_t                                         _rpc_worker_threads = 0;
+      uint32_t                                         _rpc_max_pending = 0;
+      uint32_t                                         _rpc_max_batch_size = 0;
+      uint32_t                                         _rpc_compress_min_size = 0;
+      int32_t                                          _rpc_compression_level = 6;
+      std::set< std::string >                          _rpc_worker_apis;
+      /// Methods that change the connection's own state, which is not synchronized, or push to the chain
+      const std::set< std::string >                    _rpc_thread_methods = {
+         "set_block_applied_callback",
+         "broadcast_transaction_with_callback",
+         "subscribe",
+         "unsubscribe",
+         "login",
+         "get_api_by_name",
+         "push_raw_block"
+      };
+      std::shared_ptr< const fc::rpc::request_log >    _rpc_request_log;
+      mutable boost::mutex                             _rpc_stats_mutex;
+      std::map< std::string, rpc_method_stats >        _rpc_method_stats;
 
       std::map<string, std::shared_ptr<abstract_plugin> > _plugins_available;
       std::map<string, std::shared_ptr<abstract_plugin> > _plugins_enabled;
@@ -974,8 +1211,21 @@ void application::set_program_options(boost::program_options::options_descriptio
    default_apis.push_back( "dapp_api" );
    default_apis.push_back( "token_api" );
    default_apis.push_back( "dapp_history_api" );
+   default_apis.push_back( "event_subscription_api" );
    std::string str_default_apis = boost::algorithm::join( default_apis, " " );
 
+   // Read-only APIs, which only touch chain state under its read lock
+   std::vector< std::string > default_worker_apis;
+   default_worker_apis.push_back( "database_api" );
+   default_worker_apis.push_back( "login_api" );
+   default_worker_apis.push_back( "account_by_key_api" );
+   default_worker_apis.push_back( "dapp_api" );
+   default_worker_apis.push_back( "token_api" );
+   default_worker_apis.push_back( "dapp_history_api" );
+   default_worker_apis.push_back( "block_info_api" );
+   default_worker_apis.push_back( "raw_block_api" );
+   std::string str_default_worker_apis = boost::algorithm::join( default_worker_apis, " " );
+
    std::vector< std::string > default_plugins;
    default_plugins.push_back( "bobserver" );
    default_plugins.push_back( "account_history" );
@@ -983,15 +1233,23 @@ void application::set_program_options(boost::program_options::options_descriptio
    default_plugins.push_back( "dapp" );
    default_plugins.push_back( "token" );
    default_plugins.push_back( "dapp_history" );
+   default_plugins.push_back( "event_subscription" );
    std::string str_default_plugins = boost::algorithm::join( default_plugins, " " );
 
    configuration_file_options.add_options()
          ("p2p-endpoint", bpo::value<string>(), "Endpoint for P2P node to listen on")
          ("p2p-max-connections", bpo::value<uint32_t>(), "Maxmimum number of incoming connections on P2P endpoint")
+         ("p2p-compact-blocks", bpo::value<bool>()->default_value(true), "Relay new blocks to peers that support it as a header and short transaction ids, which they rebuild from the transactions they have seen")
+         ("p2p-aead-encryption", bpo::value<bool>()->default_value(true), "Encrypt connections to peers that support it with AES-256-GCM instead of AES-256-CBC")
+         ("p2p-metrics-endpoint", bpo::value<string>(), "Endpoint to serve p2p traffic, sync and block timing metrics on, in the Prometheus text format")
          ("seed-node,s", bpo::value<vector<string>>()->composing(), "P2P nodes to connect to on startup (may specify multiple times)")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("shared-file-dir", bpo::value<string>(), "Location of the shared memory file. Defaults to data_dir/blockchain")
          ("shared-file-size", bpo::value<string>()->default_value("54G"), "Size of the shared memory file. Default: 54G")
+         ("shared-file-huge-pages", bpo::value<string>()->default_value("none"), "Huge pages for the shared memory file: none or transparent. Put shared-file-dir on hugetlbfs for explicit huge pages")
+         ("shared-file-prefault", bpo::value<bool>()->default_value(false), "Fault the shared memory file into memory on startup")
+         ("shared-file-lock", bpo::value<bool>()->default_value(false), "Lock the shared memory file in memory. Requires a sufficient RLIMIT_MEMLOCK")
+         ("shared-file-numa-node", bpo::value<int32_t>()->default_value(-1), "Prefer memory on this NUMA node for the shared memory file. -1 uses the default policy")
          ("rpc-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:5020"), "Endpoint for websocket RPC to listen on")
          ("rpc-tls-endpoint", bpo::value<string>()->implicit_value("127.0.0.1:8089"), "Endpoint for TLS websocket RPC to listen on")
          ("read-forward-rpc", bpo::value<string>(), "Endpoint to forward write API calls to for a read node" )
@@ -999,9 +1257,25 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("server-pem-password,P", bpo::value<string>()->implicit_value(""), "Password for this certificate")
          ("api-user", bpo::value< vector<string> >()->composing(), "API user specification, may be specified multiple times")
          ("public-api", bpo::value< vector<string> >()->composing()->default_value(default_apis, str_default_apis), "Set an API to be publicly available, may be specified multiple times")
+         ("rpc-worker-threads", bpo::value< uint32_t >()->default_value(4), "Threads that parse, execute and serialize RPC requests. 0 handles them all on the main thread")
+         ("rpc-max-pending-per-connection", bpo::value< uint32_t >()->default_value(100), "Requests queued per RPC connection before reading from it is paused")
+         ("rpc-max-batch-size", bpo::value< uint32_t >()->default_value(100), "Maximum number of requests in one JSON-RPC batch. 0 disables batch requests")
+         ("rpc-compress-min-size", bpo::value< uint32_t >()->default_value(1024), "Compress RPC responses of at least this many bytes, with permessage-deflate on websockets and gzip over HTTP, when the client supports it. 0 disables")
+         ("rpc-compression-level", bpo::value< int32_t >()->default_value(6), "zlib compression level, 1 (fastest) to 9 (smallest), of gzipped HTTP RPC responses")
+         ("rpc-log-sample-rate", bpo::value< double >()->default_value(0), "Fraction of RPC requests, from 0 to 1, written to the \"rpc\" logger at info level")
+         ("rpc-log-method-sample-rate", bpo::value< vector<string> >()->composing(), "Sample rate for one RPC method as api.method=rate, overriding rpc-log-sample-rate, may be specified multiple times")
+         ("rpc-slow-call-warn-ms", bpo::value< uint32_t >(), "Log a warning for RPC calls taking longer than this many milliseconds. 0 disables")
+         ("rpc-slow-call-error-ms", bpo::value< uint32_t >(), "Log an error for RPC calls taking longer than this many milliseconds. 0 disables")
+         ("rpc-worker-api", bpo::value< vector<string> >()->composing()->default_value(default_worker_apis, str_default_worker_apis), "An API whose calls may run on RPC worker threads, may be specified multiple times. Other APIs run on the main thread")
          ("enable-plugin", bpo::value< vector<string> >()->composing()->default_value(default_plugins, str_default_plugins), "Plugin(s) to enable, may be specified multiple times")
          ("max-block-age", bpo::value< int32_t >()->default_value(200), "Maximum age of head block when broadcasting tx via API")
+         ("max-pending-confirmations-per-connection", bpo::value< uint32_t >()->default_value(1000), "Transactions one API connection may be waiting on through broadcast_transaction_with_callback at a time. Synchronous broadcasts are bounded by rpc-max-pending-per-connection instead")
+         ("max-pending-confirmations", bpo::value< uint32_t >()->default_value(100000), "Broadcast transactions all API connections together may be waiting to see confirmed at a time")
          ("flush", bpo::value< uint32_t >()->default_value(100000), "Flush shared memory file to disk this many blocks")
+         ("flush-in-background", bpo::value< bool >()->default_value(true), "Write back the shared memory file on a background thread so that periodic flushes do not stall block application")
+         ("max-pending-transactions-size", bpo::value<string>()->default_value("64M"), "Maximum total size of pending transactions kept in memory. Lowest fee transactions are evicted first")
+         ("store-recent-transactions", bpo::value<bool>()->default_value(false), "Keep a copy of each unexpired transaction in shared memory so that peers can fetch transactions already in blocks. Pending transactions are always served")
+         ("block-log-queue-size", bpo::value< uint32_t >()->default_value(1000), "Irreversible blocks queued for the background block log writer. 0 appends synchronously. Queued blocks are journaled and appended on the next start after a crash")
          ("backtrace", bpo::value<string>()->default_value("yes"), "Whether to print backtrace on SIGSEGV")
          ("black-list", bpo::value<vector<string>>()->composing(), "black-list account")
          ;
@@ -1057,6 +1331,11 @@ std::shared_ptr<chain::database> application::chain_database() const
 {
    return my->_chain_db;
 }
+
+std::shared_ptr<transaction_confirmations> application::pending_confirmations() const
+{
+   return my->_transaction_confirmations;
+}
 /*std::shared_ptr<graphene::db::object_database> application::pending_trx_database() const
 {
    return my->_pending_trx_db;
@@ -1092,6 +1371,11 @@ void application::get_max_block_age( int32_t& result )
    my->get_max_block_age( result );
 }
 
+rpc_stats application::get_rpc_stats()const
+{
+   return my->get_rpc_stats();
+}
+
 void application::connect_to_write_node()
 {
    if( _remote_endpoint )
@@ -1487,5 +1487,22 @@ uint32_t database_api::get_free_memory()
    return my->_db.get_free_memory_gb();
 }
 
+shared_memory_flush_info database_api::get_shared_memory_flush_info()const
+{
+   const auto stats = my->_db.get_flush_stats();
+
+   shared_memory_flush_info result;
+   result.flush_count = stats.flush_count;
+   result.last_flush_us = stats.last_flush_us;
+   result.max_flush_us = stats.max_flush_us;
+   result.avg_flush_us = stats.flush_count ? stats.total_flush_us / stats.flush_count : 0;
+   result.bytes_synced = stats.bytes_synced;
+   result.coalesced_requests = stats.coalesced_requests;
+   result.dirty_bytes_before_last_flush = stats.dirty_bytes_before_last_flush;
+   result.dirty_bytes = my->_db.get_dirty_bytes();
+   result.background = my->_db.has_background_flush();
+   return result;
+}
+
 
 } } // sigmaengine::app
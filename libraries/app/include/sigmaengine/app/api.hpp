@@ -24,6 +24,7 @@
 #pragma once
 
 #include <sigmaengine/app/api_context.hpp>
+#include <sigmaengine/app/application.hpp>
 #include <sigmaengine/app/database_api.hpp>
 #include <sigmaengine/protocol/types.hpp>
 
@@ -56,6 +57,7 @@ namespace sigmaengine { namespace app {
    {
       public:
          network_broadcast_api(const api_context& a);
+         ~network_broadcast_api();
 
          struct transaction_confirmation
          {
@@ -81,12 +83,15 @@ namespace sigmaengine { namespace app {
 
          /** this version of broadcast transaction registers a callback method that will be called when the transaction is
           * included into a block.  The callback method includes the transaction id, block number, and transaction number in the
-          * block.
+          * block.  A connection may only have max-pending-confirmations-per-connection callbacks waiting at a time.
+          * Callbacks can not be delivered over plain HTTP, where broadcast_transaction_synchronous is used instead.
           */
          void broadcast_transaction_with_callback( confirmation_callback cb, const signed_transaction& trx);
 
          /**
-          * This call will not return until the transaction is included in a block.
+          * This call will not return until the transaction is included in a block.  Each call waits on its own,
+          * so it counts against max-pending-confirmations but not the per-connection limit; the calls a
+          * connection can have running are bounded by rpc-max-pending-per-connection.
           */
          fc::variant broadcast_transaction_synchronous( const signed_transaction& trx);
 
@@ -97,24 +102,11 @@ namespace sigmaengine { namespace app {
          // implementation detail, not reflected
          bool check_max_block_age( int32_t max_block_age );
 
-         /**
-          * @brief Not reflected, thus not accessible to API clients.
-          *
-          * This function is registered to receive the applied_block
-          * signal from the chain database when a block is received.
-          * It then dispatches callbacks to clients who have requested
-          * to be notified when a particular txid is included in a block.
-          */
-         void on_applied_block( const signed_block& b );
-
          /// internal method, not exposed via JSON RPC
          void on_api_startup();
 
       private:
-         boost::signals2::scoped_connection             _applied_block_connection;
-
-         map<transaction_id_type,confirmation_callback>     _callbacks;
-         map<time_point_sec, vector<transaction_id_type> >  _callbacks_expirations;
+         void broadcast_with_confirmation( const void* owner, confirmation_callback cb, const signed_transaction& trx );
 
          int32_t                                        _max_block_age = -1;
 
@@ -163,6 +155,23 @@ namespace sigmaengine { namespace app {
           */
          std::vector<graphene::net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Get RPC worker queue depths and per-method call latency
+          */
+         rpc_stats get_rpc_stats() const;
+
+         /**
+          * @brief Get bytes and messages by type and by peer, send queue depths, sync progress
+          *        and block propagation and validation times
+          */
+         graphene::net::network_metrics get_network_metrics() const;
+
+         /**
+          * @brief Get how often each module's per-block processing of due items ran, how many
+          *        items it processed and how long it took
+          */
+         std::vector< chain::due_processor_metrics > get_due_processor_metrics() const;
+
          /// internal method, not exposed via JSON RPC
          void on_api_startup();
 
@@ -234,6 +243,9 @@ FC_API(sigmaengine::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_rpc_stats)
+       (get_network_metrics)
+       (get_due_processor_metrics)
      )
 FC_API(sigmaengine::app::login_api,
        (login)
@@ -25,6 +25,10 @@ struct api_session_data
 {
    std::shared_ptr< fc::rpc::websocket_api_connection >        wsc;
    std::map< std::string, fc::api_ptr >                        api_map;
+   /// Shared by every HTTP request, so it must not be modified by any one caller
+   bool                                                        stateless = false;
+   /// Names of the APIs registered on wsc, by the id clients call them with
+   std::map< fc::api_id_type, std::string >                    api_names;
 };
 
 /**
@@ -45,6 +45,30 @@ namespace sigmaengine { namespace app {
 
    class network_broadcast_api;
    class login_api;
+   class transaction_confirmations;
+
+   struct rpc_method_stats
+   {
+      uint64_t    calls = 0;
+      uint64_t    errors = 0;
+      uint64_t    total_us = 0;
+      uint64_t    max_us = 0;
+   };
+
+   /**
+    * RPC server load: the worker queues of the websocket servers and the latency
+    * of each API method, keyed by "api_name.method".
+    */
+   struct rpc_stats
+   {
+      uint32_t                                  worker_threads = 0;
+      uint64_t                                  queued_messages = 0;
+      uint64_t                                  max_queue_depth = 0;
+      uint64_t                                  processed_messages = 0;
+      uint64_t                                  http_requests = 0;
+      uint64_t                                  backpressure_waits = 0;
+      std::map< std::string, rpc_method_stats > methods;
+   };
 
    class application
    {
@@ -84,6 +108,8 @@ namespace sigmaengine { namespace app {
 
          graphene::net::node_ptr                    p2p_node();
          std::shared_ptr<chain::database> chain_database()const;
+         /// Callbacks of broadcast transactions waiting to be included in a block, null in read only mode
+         std::shared_ptr<transaction_confirmations> pending_confirmations()const;
          //std::shared_ptr<graphene::db::object_database> pending_trx_database() const;
 
          void set_block_production(bool producing_blocks);
@@ -119,6 +145,8 @@ namespace sigmaengine { namespace app {
 
          void get_max_block_age( int32_t& result );
 
+         rpc_stats get_rpc_stats()const;
+
          void connect_to_write_node();
 
          bool _read_only = true;
@@ -154,3 +182,7 @@ namespace sigmaengine { namespace app {
    }
 
 } } // sigmaengine::app
+
+FC_REFLECT( sigmaengine::app::rpc_method_stats, (calls)(errors)(total_us)(max_us) )
+FC_REFLECT( sigmaengine::app::rpc_stats,
+            (worker_threads)(queued_messages)(max_queue_depth)(processed_messages)(http_requests)(backpressure_waits)(methods) )
@@ -36,6 +36,19 @@ struct scheduled_hardfork
    fc::time_point_sec   live_time;
 };
 
+struct shared_memory_flush_info
+{
+   uint64_t             flush_count = 0;
+   uint64_t             last_flush_us = 0;
+   uint64_t             max_flush_us = 0;
+   uint64_t             avg_flush_us = 0;
+   uint64_t             bytes_synced = 0;
+   uint64_t             coalesced_requests = 0;
+   uint64_t             dirty_bytes_before_last_flush = 0;
+   uint64_t             dirty_bytes = 0;
+   bool                 background = false;
+};
+
 class database_api_impl;
 
 /**
@@ -275,6 +288,12 @@ class database_api
 
       uint32_t get_free_memory();
 
+      /**
+       * @brief Get writeback statistics for the shared memory file
+       * @return flush timings and the number of bytes of state not yet written to disk
+       */
+      shared_memory_flush_info get_shared_memory_flush_info()const;
+
    private:
       std::shared_ptr< database_api_impl >   my;
 };
@@ -282,6 +301,9 @@ class database_api
 } }
 
 FC_REFLECT( sigmaengine::app::scheduled_hardfork, (hf_version)(live_time) );
+FC_REFLECT( sigmaengine::app::shared_memory_flush_info,
+            (flush_count)(last_flush_us)(max_flush_us)(avg_flush_us)(bytes_synced)
+            (coalesced_requests)(dirty_bytes_before_last_flush)(dirty_bytes)(background) );
 
 FC_API(sigmaengine::app::database_api,
    // Subscriptions
@@ -357,4 +379,5 @@ FC_API(sigmaengine::app::database_api,
    (get_block_range)
 
    (get_free_memory)
+   (get_shared_memory_flush_info)
 )
@@ -0,0 +1,87 @@
+#pragma once
+#include <sigmaengine/protocol/block.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <functional>
+#include <unordered_map>
+
+namespace sigmaengine { namespace app {
+   using boost::multi_index_container;
+   using namespace boost::multi_index;
+
+   using sigmaengine::protocol::signed_block;
+   using sigmaengine::protocol::transaction_id_type;
+
+   /**
+    *  Callbacks waiting for broadcast transactions to be included in a block, shared
+    *  by every API connection of the node.
+    *
+    *  Each applied block is matched once against all of the callbacks, by transaction
+    *  id, and callbacks whose transaction expired before the block are dropped in
+    *  expiration order.  The callbacks due for a block are then called together from
+    *  a single task.  Callbacks are registered on behalf of an owner, usually the API
+    *  object of a connection, which is limited in how many it may have pending and
+    *  can drop all of its callbacks when it goes away.
+    */
+   class transaction_confirmations
+   {
+      public:
+         /// trx_num is the position of the transaction in block_num, or -1 when it expired
+         typedef std::function< void( int32_t block_num, int32_t trx_num, bool expired ) > callback;
+
+         transaction_confirmations( uint32_t max_per_owner, uint32_t max_total );
+
+         /**
+          *  Throws when owner or the node already has as many callbacks pending as allowed.
+          *  @return a handle to remove this one callback with
+          */
+         uint64_t add( const void* owner, const transaction_id_type& trx_id, fc::time_point_sec expiration, callback cb );
+         /** Drops the callback add returned handle for, e.g. when the transaction was rejected */
+         void     remove( uint64_t handle );
+         void     remove_owner( const void* owner );
+
+         void     on_applied_block( const signed_block& b );
+
+         size_t   size()const;
+
+      private:
+         struct pending_callback
+         {
+            uint64_t             handle;
+            const void*          owner;
+            transaction_id_type  trx_id;
+            fc::time_point_sec   expiration;
+            callback             cb;
+         };
+
+         struct by_handle;
+         struct by_trx_id;
+         struct by_expiration;
+         struct by_owner;
+         typedef multi_index_container<
+            pending_callback,
+            indexed_by<
+               hashed_unique< tag< by_handle >, member< pending_callback, uint64_t, &pending_callback::handle > >,
+               hashed_non_unique< tag< by_trx_id >, member< pending_callback, transaction_id_type, &pending_callback::trx_id >, std::hash< fc::ripemd160 > >,
+               ordered_non_unique< tag< by_expiration >, member< pending_callback, fc::time_point_sec, &pending_callback::expiration > >,
+               hashed_non_unique< tag< by_owner >, member< pending_callback, const void*, &pending_callback::owner > >
+            >
+         > pending_callback_index_type;
+
+         void release( const void* owner );
+
+         mutable boost::mutex                         _mutex;
+         pending_callback_index_type                  _pending;
+         std::unordered_map< const void*, uint32_t >  _pending_by_owner;
+         uint32_t                                     _max_per_owner;
+         uint32_t                                     _max_total;
+         uint64_t                                     _next_handle = 0;
+   };
+
+} } // sigmaengine::app
@@ -0,0 +1,108 @@
+#include <sigmaengine/app/transaction_confirmations.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <vector>
+
+namespace sigmaengine { namespace app {
+
+transaction_confirmations::transaction_confirmations( uint32_t max_per_owner, uint32_t max_total )
+   : _max_per_owner( max_per_owner ), _max_total( max_total ) {}
+
+uint64_t transaction_confirmations::add( const void* owner, const transaction_id_type& trx_id, fc::time_point_sec expiration, callback cb )
+{
+   boost::lock_guard< boost::mutex > lock( _mutex );
+   FC_ASSERT( _pending.size() < _max_total,
+      "Too many transactions are waiting for confirmation on this node", ("max", _max_total) );
+   uint32_t& owner_count = _pending_by_owner[ owner ];
+   FC_ASSERT( owner_count < _max_per_owner,
+      "Too many transactions are waiting for confirmation on this connection", ("max", _max_per_owner) );
+   uint64_t handle = _next_handle++;
+   _pending.insert( pending_callback{ handle, owner, trx_id, expiration, std::move( cb ) } );
+   ++owner_count;
+   return handle;
+}
+
+void transaction_confirmations::remove( uint64_t handle )
+{
+   boost::lock_guard< boost::mutex > lock( _mutex );
+   auto& by_h = _pending.get< by_handle >();
+   auto itr = by_h.find( handle );
+   if( itr == by_h.end() )
+      return;
+   release( itr->owner );
+   by_h.erase( itr );
+}
+
+void transaction_confirmations::remove_owner( const void* owner )
+{
+   boost::lock_guard< boost::mutex > lock( _mutex );
+   _pending.get< by_owner >().erase( owner );
+   _pending_by_owner.erase( owner );
+}
+
+void transaction_confirmations::release( const void* owner )
+{
+   auto itr = _pending_by_owner.find( owner );
+   if( itr != _pending_by_owner.end() && --itr->second == 0 )
+      _pending_by_owner.erase( itr );
+}
+
+void transaction_confirmations::on_applied_block( const signed_block& b )
+{
+   std::vector< std::function< void() > > due;
+   {
+      boost::lock_guard< boost::mutex > lock( _mutex );
+      if( _pending.empty() )
+         return;
+
+      int32_t block_num = int32_t( b.block_num() );
+      auto& by_id = _pending.get< by_trx_id >();
+      for( size_t trx_num = 0; trx_num < b.transactions.size() && !by_id.empty(); ++trx_num )
+      {
+         auto range = by_id.equal_range( b.transactions[ trx_num ].id() );
+         for( auto itr = range.first; itr != range.second; ++itr )
+         {
+            due.push_back( std::bind( itr->cb, block_num, int32_t( trx_num ), false ) );
+            release( itr->owner );
+         }
+         by_id.erase( range.first, range.second );
+      }
+
+      auto& by_exp = _pending.get< by_expiration >();
+      while( !by_exp.empty() && by_exp.begin()->expiration < b.timestamp )
+      {
+         due.push_back( std::bind( by_exp.begin()->cb, block_num, -1, true ) );
+         release( by_exp.begin()->owner );
+         by_exp.erase( by_exp.begin() );
+      }
+   }
+
+   if( due.empty() )
+      return;
+
+   // not while the block is being applied, and without holding up the other callbacks if one fails
+   fc::async( [due]()
+   {
+      for( const auto& call : due )
+      {
+         try
+         {
+            call();
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "Transaction confirmation callback failed: ${e}", ("e", e.to_detail_string()) );
+         }
+      }
+   }, "transaction confirmations" );
+}
+
+size_t transaction_confirmations::size()const
+{
+   boost::lock_guard< boost::mutex > lock( _mutex );
+   return _pending.size();
+}
+
+} } // sigmaengine::app
@@ -1,13 +1,33 @@
 #include <sigmaengine/chain/block_log.hpp>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <fc/io/raw.hpp>
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
 
 namespace sigmaengine { namespace chain {
 
    namespace detail {
+      struct queued_block
+      {
+         uint32_t                block_num = 0;
+         uint64_t                pos = 0;
+         std::vector< char >     data;
+      };
+      typedef std::shared_ptr< queued_block > queued_block_ptr;
+
       class block_log_impl {
          public:
             optional< signed_block > head;
@@ -18,6 +38,81 @@ namespace sigmaengine { namespace chain {
             fc::path                 index_file;
             bool                     block_write = false;
             bool                     index_write = false;
+            /// Guards the shared streams and head, which API threads read while blocks are appended
+            boost::recursive_mutex   stream_mutex;
+
+            /// Background writer state. Queued blocks stay readable until they are on disk.
+            std::unique_ptr< boost::thread >    writer;
+            boost::mutex                        queue_mutex;
+            boost::condition_variable           work_ready;
+            boost::condition_variable           work_done;
+            std::deque< queued_block_ptr >      queue;
+            uint32_t                            max_queue_size = 0;
+            bool                                stopping = false;
+            optional< fc::exception >           write_error;
+            /// End of the main file once every queued block is written
+            uint64_t                            end_pos = 0;
+
+            /// Holds at least every queued block, replayed by open() after a crash
+            fc::path                            journal_file;
+            std::ofstream                       journal;
+            uint64_t                            journal_size = 0;
+            /// Past this size the journal is rewritten with just the blocks still queued
+            static const uint64_t               journal_rewrite_size = 64 * 1024 * 1024;
+
+            void writer_loop();
+
+            /// Caller must hold stream_mutex
+            void journal_block( const queued_block_ptr& b )
+            {
+               std::vector< queued_block_ptr > pending;
+               bool rewrite = !journal.is_open();
+               {
+                  boost::unique_lock< boost::mutex > lock( queue_mutex );
+                  // Blocks leave the queue only once they are synced, so everything else in the journal is in the log
+                  if( queue.empty() || journal_size >= journal_rewrite_size )
+                  {
+                     rewrite = true;
+                     pending.assign( queue.begin(), queue.end() );
+                  }
+               }
+
+               if( rewrite )
+               {
+                  journal.close();
+                  journal.open( journal_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+                  journal_size = 0;
+                  for( const auto& p : pending )
+                  {
+                     journal.write( p->data.data(), p->data.size() );
+                     journal_size += p->data.size();
+                  }
+               }
+
+               journal.write( b->data.data(), b->data.size() );
+               journal_size += b->data.size();
+               journal.flush();
+            }
+
+            /// Caller must hold queue_mutex
+            queued_block_ptr find_queued_by_num( uint32_t block_num )const
+            {
+               if( queue.empty() || block_num < queue.front()->block_num )
+                  return queued_block_ptr();
+               size_t offset = block_num - queue.front()->block_num;
+               return offset < queue.size() ? queue[ offset ] : queued_block_ptr();
+            }
+
+            /// Caller must hold queue_mutex
+            queued_block_ptr find_queued_by_pos( uint64_t pos )const
+            {
+               if( queue.empty() || pos < queue.front()->pos )
+                  return queued_block_ptr();
+               auto itr = std::lower_bound( queue.begin(), queue.end(), pos,
+                  []( const queued_block_ptr& b, uint64_t p ) { return b->pos < p; } );
+               FC_ASSERT( itr != queue.end() && (*itr)->pos == pos, "Requested position is not the start of a queued block", ("pos", pos) );
+               return *itr;
+            }
 
             inline void check_block_read()
             {
@@ -81,6 +176,88 @@ namespace sigmaengine { namespace chain {
                FC_LOG_AND_RETHROW()
             }
       };
+
+      void block_log_impl::writer_loop()
+      {
+         std::ofstream block_out;
+         std::ofstream index_out;
+#ifndef WIN32
+         int block_fd = -1;
+         int index_fd = -1;
+#endif
+
+         try
+         {
+            block_out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+            index_out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+            block_out.open( block_file.generic_string().c_str(), LOG_WRITE );
+            index_out.open( index_file.generic_string().c_str(), LOG_WRITE );
+#ifndef WIN32
+            block_fd = ::open( block_file.generic_string().c_str(), O_RDONLY );
+            index_fd = ::open( index_file.generic_string().c_str(), O_RDONLY );
+            FC_ASSERT( block_fd >= 0 && index_fd >= 0, "Could not open block log for syncing" );
+#endif
+
+            std::vector< queued_block_ptr > batch;
+            while( true )
+            {
+               {
+                  boost::unique_lock< boost::mutex > lock( queue_mutex );
+                  while( queue.empty() && !stopping )
+                     work_ready.wait( lock );
+                  if( queue.empty() )
+                     break;
+                  batch.assign( queue.begin(), queue.end() );
+               }
+
+               // Blocks must be durable before the index refers to them, so that open() can
+               // always recover a torn main file from the index.
+               for( const auto& b : batch )
+               {
+                  block_out.write( b->data.data(), b->data.size() );
+                  block_out.write( (const char*)&b->pos, sizeof( b->pos ) );
+               }
+               block_out.flush();
+#ifndef WIN32
+               ::fdatasync( block_fd );
+#endif
+
+               for( const auto& b : batch )
+                  index_out.write( (const char*)&b->pos, sizeof( b->pos ) );
+               index_out.flush();
+#ifndef WIN32
+               ::fdatasync( index_fd );
+#endif
+
+               {
+                  boost::unique_lock< boost::mutex > lock( queue_mutex );
+                  queue.erase( queue.begin(), queue.begin() + batch.size() );
+               }
+               batch.clear();
+               work_done.notify_all();
+            }
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Block log writer failed: ${e}", ("e", e.to_detail_string()) );
+            boost::unique_lock< boost::mutex > lock( queue_mutex );
+            write_error = e;
+         }
+         catch( const std::exception& e )
+         {
+            elog( "Block log writer failed: ${e}", ("e", e.what()) );
+            boost::unique_lock< boost::mutex > lock( queue_mutex );
+            write_error = fc::unhandled_exception( FC_LOG_MESSAGE( error, "Block log writer failed: ${e}", ("e", e.what()) ) );
+         }
+
+#ifndef WIN32
+         if( block_fd >= 0 )
+            ::close( block_fd );
+         if( index_fd >= 0 )
+            ::close( index_fd );
+#endif
+         work_done.notify_all();
+      }
    }
 
    block_log::block_log()
@@ -88,15 +265,18 @@ namespace sigmaengine { namespace chain {
    {
       my->block_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
       my->index_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+      my->journal.exceptions( std::ofstream::failbit | std::ofstream::badbit );
    }
 
    block_log::~block_log()
    {
+      stop_writer();
       flush();
    }
 
    void block_log::open( const fc::path& file )
    {
+      boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
       if( my->block_stream.is_open() )
          my->block_stream.close();
       if( my->index_stream.is_open() )
@@ -104,6 +284,7 @@ namespace sigmaengine { namespace chain {
 
       my->block_file = file;
       my->index_file = fc::path( file.generic_string() + ".index" );
+      my->journal_file = fc::path( file.generic_string() + ".journal" );
 
       my->block_stream.open( my->block_file.generic_string().c_str(), LOG_WRITE );
       my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
@@ -134,6 +315,7 @@ namespace sigmaengine { namespace chain {
       if( log_size )
       {
          ilog( "Log is nonempty" );
+         recover_torn_tail();
          my->head = read_head();
          my->head_id = my->head->id();
 
@@ -176,15 +358,75 @@ namespace sigmaengine { namespace chain {
          my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
          my->index_write = true;
       }
+
+      recover_journal();
    }
 
    void block_log::close()
    {
+      stop_writer();
       my.reset( new detail::block_log_impl() );
    }
 
+   void block_log::start_writer( uint32_t max_queue_size )
+   {
+      try
+      {
+         FC_ASSERT( !my->writer, "Block log writer is already running" );
+         FC_ASSERT( max_queue_size > 0 );
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+
+         // Readers keep the shared streams; the writer appends through its own
+         flush();
+         my->check_block_read();
+         my->check_index_read();
+
+         my->max_queue_size = max_queue_size;
+         my->stopping = false;
+         my->write_error.reset();
+         my->end_pos = fc::file_size( my->block_file );
+         my->journal_size = 0;
+         my->writer.reset( new boost::thread( [this]() { my->writer_loop(); } ) );
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   void block_log::stop_writer()
+   {
+      if( !my->writer )
+         return;
+
+      {
+         boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+         my->stopping = true;
+      }
+      my->work_ready.notify_all();
+      my->writer->join();
+      my->writer.reset();
+
+      my->journal.close();
+      if( !my->queue.empty() )
+         elog( "Block log writer stopped with ${n} blocks unwritten, they are kept in the journal", ("n", my->queue.size()) );
+      else
+         fc::remove_all( my->journal_file );
+      my->queue.clear();
+   }
+
+   void block_log::wait_for_writes()
+   {
+      if( !my->writer )
+         return;
+
+      boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+      while( !my->queue.empty() && !my->write_error )
+         my->work_done.wait( lock );
+      if( my->write_error )
+         my->write_error->dynamic_rethrow_exception();
+   }
+
    bool block_log::is_open()const
    {
+      boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
       return my->block_stream.is_open();
    }
 
@@ -192,6 +434,37 @@ namespace sigmaengine { namespace chain {
    {
       try
       {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+         if( my->writer )
+         {
+            uint32_t expected_num = my->head.valid() ? my->head->block_num() + 1 : 1;
+            FC_ASSERT( b.block_num() == expected_num, "Append to block log occuring at wrong position.", ("block_num", b.block_num())("expected", expected_num) );
+
+            auto entry = std::make_shared< detail::queued_block >();
+            entry->block_num = b.block_num();
+            entry->pos = my->end_pos;
+            entry->data = fc::raw::pack( b );
+
+            {
+               boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+               while( my->queue.size() >= my->max_queue_size && !my->write_error )
+                  my->work_done.wait( lock );
+               if( my->write_error )
+                  my->write_error->dynamic_rethrow_exception();
+            }
+            my->journal_block( entry );
+            {
+               boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+               my->queue.push_back( entry );
+            }
+            my->work_ready.notify_one();
+
+            my->end_pos += entry->data.size() + sizeof( uint64_t );
+            my->head = b;
+            my->head_id = b.id();
+            return entry->pos;
+         }
+
          my->check_block_write();
          my->check_index_write();
 
@@ -212,6 +485,13 @@ namespace sigmaengine { namespace chain {
 
    void block_log::flush()
    {
+      boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+      if( my->writer )
+      {
+         my->work_ready.notify_one();
+         return;
+      }
+
       my->block_stream.flush();
       my->index_stream.flush();
    }
@@ -220,6 +500,23 @@ namespace sigmaengine { namespace chain {
    {
       try
       {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+         if( my->writer )
+         {
+            detail::queued_block_ptr queued;
+            {
+               boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+               queued = my->find_queued_by_pos( pos );
+            }
+            if( queued )
+            {
+               std::pair<signed_block,uint64_t> result;
+               result.first = fc::raw::unpack< signed_block >( queued->data );
+               result.second = pos + queued->data.size() + 8;
+               return result;
+            }
+         }
+
          my->check_block_read();
 
          my->block_stream.seekg( pos );
@@ -235,6 +532,7 @@ namespace sigmaengine { namespace chain {
    {
       try
       {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
       optional< signed_block > b;
       uint64_t pos = get_block_pos( block_num );
       if( pos != npos )
@@ -247,14 +545,130 @@ namespace sigmaengine { namespace chain {
       FC_LOG_AND_RETHROW()
    }
 
-   uint64_t block_log::get_block_pos( uint32_t block_num ) const
+   uint32_t block_log::read_block_data( uint32_t first_block_num, uint32_t count, std::vector< char >& out )const
    {
       try
       {
-         my->check_index_read();
+         // The bulk reads below use their own streams, only the head and the flush need the lock
+         boost::unique_lock< boost::recursive_mutex > stream_lock( my->stream_mutex );
+         if( !my->head.valid() || first_block_num == 0 || count == 0 )
+            return 0;
+         uint32_t head_num = protocol::block_header::num_from_id( my->head_id );
+         if( first_block_num > head_num )
+            return 0;
+         uint32_t last_block_num = first_block_num + std::min( count - 1, head_num - first_block_num );
+
+         // Blocks the background writer has not written yet are served from memory
+         std::vector< detail::queued_block_ptr > queued;
+         uint32_t last_on_disk = last_block_num;
+         optional< uint64_t > queue_front_pos;
+         if( my->writer )
+         {
+            boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+            uint32_t front_num = my->queue.empty() ? 0 : my->queue.front()->block_num;
+            if( front_num && front_num <= last_block_num + 1 )
+               queue_front_pos = my->queue.front()->pos;
+            if( front_num && front_num <= last_block_num )
+            {
+               last_on_disk = front_num - 1;
+               for( uint32_t num = std::max( first_block_num, front_num ); num <= last_block_num; ++num )
+               {
+                  auto b = my->find_queued_by_num( num );
+                  if( !b )
+                     break;
+                  queued.push_back( b );
+               }
+            }
+         }
+         else
+         {
+            my->block_stream.flush();
+            my->index_stream.flush();
+         }
+         stream_lock.unlock();
+
+         uint32_t result = 0;
+         if( first_block_num <= last_on_disk )
+         {
+            // The start of each block, and of the one after the last, bounds its bytes
+            uint32_t disk_count = last_on_disk - first_block_num + 1;
+            uint64_t indexed = fc::file_size( my->index_file ) / sizeof( uint64_t );
+            uint64_t wanted = std::min< uint64_t >( disk_count + 1, indexed - ( first_block_num - 1 ) );
+            FC_ASSERT( indexed >= first_block_num, "Block log index is behind its head", ("indexed", indexed)("block_num", first_block_num) );
+            std::vector< uint64_t > positions( wanted );
+
+            std::ifstream index_in;
+            index_in.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+            index_in.open( my->index_file.generic_string().c_str(), LOG_READ );
+            index_in.seekg( sizeof( uint64_t ) * ( first_block_num - 1 ) );
+            index_in.read( (char*)positions.data(), sizeof( uint64_t ) * wanted );
+
+            if( positions.size() == disk_count && queue_front_pos )
+               positions.push_back( *queue_front_pos );
+            // The head of the log has no successor to bound it; it is read below
+            uint32_t bounded = positions.size() - 1;
+
+            if( bounded )
+            {
+               size_t offset = out.size();
+               uint64_t begin = positions.front();
+               out.resize( offset + ( positions.back() - begin ) );
+
+               std::ifstream block_in;
+               block_in.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+               block_in.open( my->block_file.generic_string().c_str(), LOG_READ );
+               block_in.seekg( begin );
+               block_in.read( out.data() + offset, positions.back() - begin );
+
+               // Squeeze out the position trailers
+               size_t end = offset;
+               for( uint32_t i = 0; i < bounded; ++i )
+               {
+                  size_t size = positions[ i + 1 ] - positions[ i ] - sizeof( uint64_t );
+                  memmove( out.data() + end, out.data() + offset + ( positions[ i ] - begin ), size );
+                  end += size;
+               }
+               out.resize( end );
+               result += bounded;
+            }
 
+            if( bounded < disk_count )
+            {
+               auto data = fc::raw::pack( read_block( positions[ bounded ] ).first );
+               out.insert( out.end(), data.begin(), data.end() );
+               ++result;
+               if( bounded + 1 < disk_count )
+                  return result;
+            }
+         }
+
+         for( const auto& b : queued )
+         {
+            out.insert( out.end(), b->data.begin(), b->data.end() );
+            ++result;
+         }
+         return result;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   uint64_t block_log::get_block_pos( uint32_t block_num ) const
+   {
+      try
+      {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
          if( !( my->head.valid() && block_num <= protocol::block_header::num_from_id( my->head_id ) && block_num > 0 ) )
             return npos;
+
+         if( my->writer )
+         {
+            boost::unique_lock< boost::mutex > lock( my->queue_mutex );
+            auto queued = my->find_queued_by_num( block_num );
+            if( queued )
+               return queued->pos;
+         }
+
+         my->check_index_read();
          my->index_stream.seekg( sizeof( uint64_t ) * ( block_num - 1 ) );
          uint64_t pos;
          my->index_stream.read( (char*)&pos, sizeof( pos ) );
@@ -267,6 +681,7 @@ namespace sigmaengine { namespace chain {
    {
       try
       {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
          my->check_block_read();
 
          uint64_t pos;
@@ -282,10 +697,128 @@ namespace sigmaengine { namespace chain {
       return my->head;
    }
 
+   void block_log::recover_torn_tail()
+   {
+      try
+      {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+         my->check_block_read();
+         uint64_t log_size = fc::file_size( my->block_file );
+
+         // Returns the end of the entry starting at pos, or npos if it is not a complete block
+         auto entry_end = [&]( uint64_t pos ) -> uint64_t
+         {
+            if( log_size < sizeof( uint64_t ) || pos >= log_size - sizeof( uint64_t ) )
+               return npos;
+            try
+            {
+               signed_block tmp;
+               uint64_t trailer;
+               my->block_stream.seekg( pos );
+               fc::raw::unpack( my->block_stream, tmp );
+               my->block_stream.read( (char*)&trailer, sizeof( trailer ) );
+               return trailer == pos ? uint64_t( my->block_stream.tellg() ) : npos;
+            }
+            catch( ... )
+            {
+               my->block_stream.clear();
+               return npos;
+            }
+         };
+
+         uint64_t tail_pos = npos;
+         if( log_size >= sizeof( uint64_t ) )
+         {
+            my->block_stream.seekg( -sizeof( uint64_t ), std::ios::end );
+            my->block_stream.read( (char*)&tail_pos, sizeof( tail_pos ) );
+         }
+         if( entry_end( tail_pos ) == log_size )
+            return;
+
+         // Index entries are only written once their block is on disk, so the last one marks a complete block
+         if( fc::file_size( my->index_file ) < sizeof( uint64_t ) )
+         {
+            wlog( "Block log tail is torn and there is no index to recover it from" );
+            return;
+         }
+
+         my->check_index_read();
+         uint64_t index_pos;
+         my->index_stream.seekg( -sizeof( uint64_t ), std::ios::end );
+         my->index_stream.read( (char*)&index_pos, sizeof( index_pos ) );
+
+         uint64_t good_end = entry_end( index_pos );
+         if( good_end == npos )
+         {
+            wlog( "Block log tail is torn and does not match its index" );
+            return;
+         }
+
+         wlog( "Truncating torn block log tail from ${old} to ${new} bytes", ("old", log_size)("new", good_end) );
+         my->block_stream.close();
+         fc::resize_file( my->block_file, good_end );
+         my->block_stream.open( my->block_file.generic_string().c_str(), LOG_READ );
+         my->block_write = false;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   void block_log::recover_journal()
+   {
+      try
+      {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
+         if( !fc::exists( my->journal_file ) )
+            return;
+
+         std::ifstream in;
+         in.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+         in.open( my->journal_file.generic_string().c_str(), LOG_READ );
+         uint64_t journal_size = fc::file_size( my->journal_file );
+
+         // Blocks already in the log are skipped; the rest must continue it
+         uint32_t recovered = 0;
+         while( uint64_t( in.tellg() ) < journal_size )
+         {
+            signed_block b;
+            try
+            {
+               fc::raw::unpack( in, b );
+            }
+            catch( ... )
+            {
+               wlog( "Block log journal ends in a torn block" );
+               break;
+            }
+
+            uint32_t expected_num = my->head.valid() ? my->head->block_num() + 1 : 1;
+            if( b.block_num() < expected_num )
+               continue;
+            if( b.block_num() != expected_num || ( my->head.valid() && b.previous != my->head_id ) )
+            {
+               wlog( "Block log journal does not continue the log at block ${n}", ("n", b.block_num()) );
+               break;
+            }
+            append( b );
+            ++recovered;
+         }
+         in.close();
+
+         if( recovered )
+         {
+            flush();
+            wlog( "Recovered ${n} blocks from the block log journal", ("n", recovered) );
+         }
+         fc::remove_all( my->journal_file );
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
    void block_log::construct_index()
    {
       try
       {
+         boost::lock_guard< boost::recursive_mutex > lock( my->stream_mutex );
          ilog( "Reconstructing Block Log Index..." );
          my->index_stream.close();
          fc::remove_all( my->index_file );
@@ -81,7 +81,46 @@ database_impl::database_impl( database& self )
    : _self(self), _evaluator_registry(self) {}
 
 database::database()
-   : _my( new database_impl(*this) ) {}
+   : _my( new database_impl(*this) )
+{
+   _due_items.register_processor( "savings_withdraws",
+      [this]() -> fc::optional< time_point_sec >
+      {
+         const auto& idx = get_index< savings_withdraw_index >().indices().get< by_complete_from_rid >();
+         if( idx.empty() ) return fc::optional< time_point_sec >();
+         return idx.begin()->complete;
+      },
+      [this]( time_point_sec ) { return process_savings_withdraws(); }, false );
+
+   _due_items.register_processor( "fund_withdraws",
+      [this]() -> fc::optional< time_point_sec >
+      {
+         const auto& idx = get_index< fund_withdraw_index >().indices().get< by_complete_from >();
+         if( idx.empty() ) return fc::optional< time_point_sec >();
+         return idx.begin()->complete;
+      },
+      [this]( time_point_sec ) { return process_fund_withdraws(); }, false );
+
+   _due_items.register_processor( "account_recovery",
+      [this]() -> fc::optional< time_point_sec >
+      {
+         fc::optional< time_point_sec > due;
+         auto earliest = [&]( time_point_sec t ) { if( !due.valid() || t < *due ) due = t; };
+
+         const auto& rec_req_idx = get_index< account_recovery_request_index >().indices().get< by_expiration >();
+         if( rec_req_idx.size() )
+            earliest( rec_req_idx.begin()->expires );
+         // removed once strictly past the recovery period
+         const auto& hist_idx = get_index< owner_authority_history_index >().indices();
+         if( hist_idx.size() )
+            earliest( time_point_sec( hist_idx.begin()->last_valid_time + SIGMAENGINE_OWNER_AUTH_RECOVERY_PERIOD ) + 1 );
+         const auto& change_req_idx = get_index< change_recovery_account_request_index >().indices().get< by_effective_date >();
+         if( change_req_idx.size() )
+            earliest( change_req_idx.begin()->effective_on );
+         return due;
+      },
+      [this]( time_point_sec ) { return account_recovery_processing(); }, false );
+}
 
 database::~database()
 {
@@ -93,7 +132,9 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
    try
    {
       init_schema();
-      chainbase::database::open( shared_mem_dir, chainbase_flags, shared_file_size );
+      chainbase::database::open( shared_mem_dir, chainbase_flags, shared_file_size, SIGMAENGINE_SHARED_MEMORY_LAYOUT_VERSION );
+      if( _background_flush && ( chainbase_flags & chainbase::database::read_write ) )
+         start_background_flush();
 
       initialize_indexes();
       initialize_evaluators();
@@ -107,6 +148,8 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
             });
 
          _block_log.open( data_dir / "block_log" );
+         if( _block_log_queue_size )
+            _block_log.start_writer( _block_log_queue_size );
 
          auto log_head = _block_log.head();
 
@@ -217,6 +260,9 @@ void database::close(bool rewind)
       // DB state (issue #336).
       clear_pending();
 
+      // the block log must hold every block the flushed state reflects
+      _block_log.wait_for_writes();
+      stop_background_flush();
       chainbase::database::flush();
       chainbase::database::close();
 
@@ -266,7 +312,7 @@ block_id_type database::find_block_id_for_num( uint32_t block_num )const
          return b->id();
 
       // Finally we query the fork DB.
-      shared_ptr< fork_item > fitem = _fork_db.fetch_block_on_main_branch_by_number( block_num );
+      item_ptr fitem = _fork_db.fetch_block_on_main_branch_by_number( block_num );
       if( fitem )
          return fitem->id;
 
@@ -313,14 +359,36 @@ optional<signed_block> database::fetch_block_by_number( uint32_t block_num )cons
    return b;
 } FC_LOG_AND_RETHROW() }
 
+uint32_t database::fetch_block_data_by_number( uint32_t first_block_num, uint32_t count, std::vector<char>& out )const
+{ try {
+   uint32_t result = _block_log.read_block_data( first_block_num, count, out );
+
+   for( ; result < count; ++result )
+   {
+      auto b = fetch_block_by_number( first_block_num + result );
+      if( !b.valid() )
+         break;
+      auto data = fc::raw::pack( *b );
+      out.insert( out.end(), data.begin(), data.end() );
+   }
+   return result;
+} FC_LOG_AND_RETHROW() }
+
 const signed_transaction database::get_recent_transaction( const transaction_id_type& trx_id ) const
 { try {
+   if( const signed_transaction* pending = _pending_tx.find( trx_id ) )
+      return *pending;
+
    auto& index = get_index<transaction_index>().indices().get<by_trx_id>();
    auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
+   // key_not_found is what the p2p layer answers with item_not_available
+   if( itr == index.end() )
+      FC_THROW_EXCEPTION( fc::key_not_found_exception, "Unknown transaction ${id}", ("id", trx_id) );
+   if( itr->packed_trx.empty() )
+      FC_THROW_EXCEPTION( fc::key_not_found_exception, "Transactions in blocks are only kept with store-recent-transactions" );
    signed_transaction trx;
    fc::raw::unpack( itr->packed_trx, trx );
-   return trx;;
+   return trx;
 } FC_CAPTURE_AND_RETHROW() }
 
 std::vector< block_id_type > database::get_block_ids_on_fork( block_id_type head_of_fork ) const
@@ -449,7 +517,7 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    {
       with_write_lock( [&]()
       {
-         detail::without_pending_transactions( *this, std::move(_pending_tx), [&]()
+         detail::without_pending_transactions( *this, _pending_tx.extract(), [&]()
          {
             try
             {
@@ -490,7 +558,7 @@ bool database::_push_block(const signed_block& new_block)
 
    if( !(skip&skip_fork_db) )
    {
-      shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
+      item_ptr new_head = _fork_db.push_block(new_block);
       _maybe_warn_multiple_production( new_head->num );
 
       //If the head block from the longest chain does not build off of the current head, we need to switch forks.
@@ -617,7 +685,12 @@ void database::_push_transaction( const signed_transaction& trx )
 
    auto temp_session = start_undo_session( true );
    _apply_transaction( trx );
-   _pending_tx.push_back( trx );
+
+   // Transactions evicted to make room keep their effects in the pending state
+   // until it is rebuilt from the pool by the next block.
+   SIGMAENGINE_ASSERT( _pending_tx.push( trx, _current_trx_fee, head_block_time() ), pending_transaction_pool_full,
+      "Pending transaction pool is full and the transaction fee is too low to replace pending transactions",
+      ("trx_id", trx.id())("fee", _current_trx_fee)("pool_size", _pending_tx.total_size()) );
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
@@ -653,17 +726,55 @@ signed_block database::_generate_block(
    const fc::ecc::private_key& block_signing_private_key
    )
 {
-   uint32_t skip = get_node_properties().skip_flags;
+   signed_block pending_block = _assemble_block( when, bobserver_owner );
+   _sign_and_push_block( pending_block, block_signing_private_key );
+   return pending_block;
+}
+
+signed_block database::assemble_block(
+   fc::time_point_sec when,
+   const account_name_type& bobserver_owner,
+   uint32_t skip
+   )
+{
+   signed_block result;
+   detail::with_skip_flags( *this, skip, [&]()
+   {
+      try
+      {
+         result = _assemble_block( when, bobserver_owner );
+      }
+      FC_CAPTURE_AND_RETHROW( (bobserver_owner) )
+   });
+   return result;
+}
+
+void database::sign_and_push_block(
+   signed_block& pending_block,
+   const fc::ecc::private_key& block_signing_private_key,
+   uint32_t skip
+   )
+{
+   detail::with_skip_flags( *this, skip, [&]()
+   {
+      try
+      {
+         _sign_and_push_block( pending_block, block_signing_private_key );
+      }
+      FC_CAPTURE_AND_RETHROW( (pending_block.bobserver)(pending_block.timestamp) )
+   });
+}
+
+signed_block database::_assemble_block(
+   fc::time_point_sec when,
+   const account_name_type& bobserver_owner
+   )
+{
    uint32_t slot_num = get_slot_at_time( when );
    FC_ASSERT( slot_num > 0 );
    string scheduled_bobserver = get_scheduled_bobserver( slot_num );
    FC_ASSERT( scheduled_bobserver == bobserver_owner );
 
-   const auto& bobserver_obj = get_bobserver( bobserver_owner );
-
-   if( !(skip & skip_bobserver_signature) )
-      FC_ASSERT( bobserver_obj.signing_key == block_signing_private_key.get_public_key() );
-
    static const size_t max_block_header_size = fc::raw::pack_size( signed_block_header() ) + 4;
    auto maximum_block_size = get_dynamic_global_properties().maximum_block_size; //SIGMAENGINE_MAX_BLOCK_SIZE;
    size_t total_block_size = max_block_header_size;
@@ -686,23 +797,23 @@ signed_block database::_generate_block(
       _pending_tx_session.reset();
       _pending_tx_session = start_undo_session( true );
 
-      uint64_t postponed_tx_count = 0;
-      // pop pending state (reset to head block state)
-      for( const signed_transaction& tx : _pending_tx )
-      {
-         // Only include transactions that have not expired yet for currently generating block,
-         // this should clear problem transactions and allow block production to continue
+      // Only include transactions that have not expired yet for currently generating block,
+      // this should clear problem transactions and allow block production to continue
+      _pending_tx.remove_expired( when );
 
-         if( tx.expiration < when )
-            continue;
+      uint64_t postponed_tx_count = 0;
+      vector< const pending_transaction* > failed_txs;
 
-         uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+      auto include_transaction = [&]( const pending_transaction& ptx ) -> bool
+      {
+         const signed_transaction& tx = ptx.trx;
+         uint64_t new_total_size = total_block_size + ptx.packed_size;
 
          // postpone transaction if it would make block too big
          if( new_total_size >= maximum_block_size )
          {
             postponed_tx_count++;
-            continue;
+            return true;
          }
 
          try
@@ -711,16 +822,31 @@ signed_block database::_generate_block(
             _apply_transaction( tx );
             temp_session.squash();
 
-            total_block_size += fc::raw::pack_size( tx );
+            total_block_size += ptx.packed_size;
             pending_block.transactions.push_back( tx );
+            return true;
          }
          catch ( const fc::exception& e )
          {
-            // Do nothing, transaction will not be re-applied
             //wlog( "Transaction was not processed while generating block due to ${e}", ("e", e) );
             //wlog( "The transaction was ${t}", ("t", tx) );
+            return false;
          }
+      };
+
+      // pop pending state (reset to head block state)
+      // transactions paying the most per byte are included first
+      for( const pending_transaction& ptx : _pending_tx.by_priority_index() )
+      {
+         if( !include_transaction( ptx ) )
+            failed_txs.push_back( &ptx );
       }
+
+      // a transaction can depend on one that pays less, such as a transfer from an account
+      // created by a cheaper transaction, so give the failures one more try after the rest
+      // of the pool has been applied.  Those that fail again will not be re-applied.
+      for( const pending_transaction* ptx : failed_txs )
+         include_transaction( *ptx );
       if( postponed_tx_count > 0 )
       {
          wlog( "Postponed ${n} transactions due to block size limit", ("n", postponed_tx_count) );
@@ -764,8 +890,22 @@ signed_block database::_generate_block(
       }
    }      
  
+   return pending_block;
+}
+
+void database::_sign_and_push_block(
+   signed_block& pending_block,
+   const fc::ecc::private_key& block_signing_private_key
+   )
+{
+   uint32_t skip = get_node_properties().skip_flags;
+   FC_ASSERT( pending_block.previous == head_block_id(), "The head block changed since the block was assembled" );
+
    if( !(skip & skip_bobserver_signature) )
+   {
+      FC_ASSERT( get_bobserver( pending_block.bobserver ).signing_key == block_signing_private_key.get_public_key() );
       pending_block.sign( block_signing_private_key );
+   }
 
    // TODO:  Move this to _push_block() so session is restored.
    if( !(skip & skip_block_size_check) )
@@ -774,8 +914,6 @@ signed_block database::_generate_block(
    }
 
    push_block( pending_block, skip );
-
-   return pending_block;
 }
 
 /**
@@ -831,6 +969,13 @@ void database::notify_post_apply_operation( const operation_notification& note )
 void database::push_virtual_operation( const operation& op, bool force )
 {
    FC_ASSERT( is_virtual_operation( op ) );
+
+   // Track the fees charged by the current transaction so the pending pool can prioritize by them
+   if( op.which() == operation::tag< tx_fee_virtual_operation >::value )
+      _current_trx_fee += op.get< tx_fee_virtual_operation >().reward.amount;
+   else if( op.which() == operation::tag< dapp_fee_virtual_operation >::value )
+      _current_trx_fee += op.get< dapp_fee_virtual_operation >().reward.amount;
+
    operation_notification note(op);
    ++_current_virtual_op;
    note.virtual_op = _current_virtual_op;
@@ -1002,14 +1147,16 @@ void database::process_funds()
    }
 }
 
-void database::process_savings_withdraws()
+uint32_t database::process_savings_withdraws()
 {
+   uint32_t processed = 0;
    const auto& idx = get_index< savings_withdraw_index >().indices().get< by_complete_from_rid >();
    auto itr = idx.begin();
    while( itr != idx.end() ) {
       
       if( itr->complete > head_block_time() )
          break;
+      ++processed;
 
       if ( itr->split_pay_order == itr->split_pay_month ) {
 
@@ -1065,10 +1212,12 @@ void database::process_savings_withdraws()
          });
       }
    }
+   return processed;
 }
 
-void database::process_fund_withdraws()
+uint32_t database::process_fund_withdraws()
 {
+   uint32_t processed = 0;
    const auto& idx = get_index< fund_withdraw_index >().indices().get< by_complete_from >();
    auto itr = idx.begin();
    while( itr != idx.end() ) {
@@ -1080,7 +1229,7 @@ void database::process_fund_withdraws()
       asset  fund_balance = get_common_fund(fund_name).fund_balance;
       if(fund_balance < itr->amount){
          ilog( "process_fund_withdraws : lack of fund balance. fund_balance/required amount = ${balance}/${amount}", ("balance", fund_balance)("amount", itr->amount) );
-         return;
+         return processed;
       }
 
       adjust_balance( get_account( itr->from ), itr->amount );
@@ -1090,11 +1239,15 @@ void database::process_fund_withdraws()
 
       remove( *itr );
       itr = idx.begin();
+      ++processed;
    }
+   return processed;
 }
 
-void database::account_recovery_processing()
+uint32_t database::account_recovery_processing()
 {
+   uint32_t processed = 0;
+
    // Clear expired recovery requests
    const auto& rec_req_idx = get_index< account_recovery_request_index >().indices().get< by_expiration >();
    auto rec_req = rec_req_idx.begin();
@@ -1103,6 +1256,7 @@ void database::account_recovery_processing()
    {
       remove( *rec_req );
       rec_req = rec_req_idx.begin();
+      ++processed;
    }
 
    // Clear invalid historical authorities
@@ -1113,6 +1267,7 @@ void database::account_recovery_processing()
    {
       remove( *hist );
       hist = hist_idx.begin();
+      ++processed;
    }
 
    // Apply effective recovery_account changes
@@ -1128,7 +1283,9 @@ void database::account_recovery_processing()
 
       remove( *change_req );
       change_req = change_req_idx.begin();
+      ++processed;
    }
+   return processed;
 }
 
 time_point_sec database::head_block_time()const
@@ -1471,6 +1628,36 @@ void database::set_flush_interval( uint32_t flush_blocks )
    _next_flush_block = 0;
 }
 
+void database::set_background_flush( bool enabled )
+{
+   _background_flush = enabled;
+}
+
+void database::set_block_log_queue_size( uint32_t queue_size )
+{
+   _block_log_queue_size = queue_size;
+}
+
+void database::set_max_pending_transactions_size( uint64_t max_size )
+{
+   _pending_tx.set_max_size( max_size );
+}
+
+void database::set_store_recent_transactions( bool store )
+{
+   _store_recent_transactions = store;
+}
+
+void database::register_due_processor( const string& name, due_item_scheduler::next_due_function next_due, due_item_scheduler::process_function process )
+{
+   _due_items.register_processor( name, next_due, process );
+}
+
+vector< due_processor_metrics > database::get_due_processor_metrics()const
+{
+   return _due_items.get_metrics();
+}
+
 //////////////////// private methods ////////////////////
 
 void database::apply_block( const signed_block& next_block, uint32_t skip )
@@ -1538,7 +1725,8 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
       {
          _next_flush_block = 0;
          //ilog( "Flushing database shared memory at block ${b}", ("b", block_num) );
-         chainbase::database::flush();
+         _block_log.wait_for_writes();
+         chainbase::database::request_flush();
       }
    }
 
@@ -1649,11 +1837,13 @@ void database::_apply_block( const signed_block& next_block )
    update_bobserver_schedule(*this);
    clear_null_account_balance();
    process_funds();
-   process_savings_withdraws();
-   process_fund_withdraws();
+   // the chain's own processors keep their place, which orders their virtual operations
+   _due_items.run( "savings_withdraws", head_block_time() );
+   _due_items.run( "fund_withdraws", head_block_time() );
    process_transaction_fee();
-   account_recovery_processing();
+   _due_items.run( "account_recovery", head_block_time() );
    process_hardforks();
+   _due_items.run( head_block_time() );
    // notify observers that the block has been applied
    notify_applied_block( next_block );
    notify_changed_objects();
@@ -1667,19 +1857,23 @@ void database::process_transaction_fee()
 
    if ( dpo.head_block_number == dpo.next_refresh_transaction_fee_block )
    {
-      const auto& vote_idx = get_index< transaction_fee_vote_index >().indicies().get< by_voter >();
-      auto vote_itr = vote_idx.begin();
-      vector< asset > trx_fee_list;
-      while( vote_itr != vote_idx.end() ) {
-         if( dpo.head_block_number < vote_itr->vote_block + dpo.refresh_transaction_fee_cycle ){
-            trx_fee_list.push_back( vote_itr->trx_fee );
-         }
-         vote_itr++;
+      // votes leave the count as they age out; each vote is visited once until it is cast again
+      const auto& expire_idx = get_index< transaction_fee_vote_index >().indicies().get< by_expired_vote_block >();
+      auto expire_itr = expire_idx.begin();
+      while( expire_itr != expire_idx.end() && !expire_itr->expired
+         && dpo.head_block_number >= expire_itr->vote_block + dpo.refresh_transaction_fee_cycle ) {
+         modify( *expire_itr, []( transaction_fee_vote_object& object ) {
+            object.expired = true;
+         });
+         expire_itr = expire_idx.begin();
       }
 
-      if( trx_fee_list.size() >= SIGMAENGINE_MIN_FEEDS ) {
-         std::sort( trx_fee_list.begin(), trx_fee_list.end() );
-         auto median_value = trx_fee_list[ trx_fee_list.size()/2 ];
+      // unexpired votes come first, ordered by fee, so the median is found by rank
+      const auto& fee_idx = get_index< transaction_fee_vote_index >().indicies().get< by_expired_fee >();
+      uint32_t vote_count = fee_idx.rank( fee_idx.lower_bound( std::make_tuple( true ) ) );
+
+      if( vote_count >= SIGMAENGINE_MIN_FEEDS ) {
+         auto median_value = fee_idx.nth( vote_count/2 )->trx_fee;
 
          modify( dpo, [&]( dynamic_global_property_object& object ) {
             object.transaction_fee = median_value;
@@ -1756,6 +1950,7 @@ void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
 void database::_apply_transaction(const signed_transaction& trx)
 { try {
    _current_trx_id = trx.id();
+   _current_trx_fee = 0;
    _current_virtual_op   = 0;
    uint32_t skip = get_node_properties().skip_flags;
 
@@ -1764,7 +1959,7 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    auto& trx_idx = get_index<transaction_index>();
    const chain_id_type& chain_id = SIGMAENGINE_CHAIN_ID;
-   auto trx_id = trx.id();
+   const transaction_id_type& trx_id = _current_trx_id;
    // idump((trx_id)(skip&skip_transaction_dupe_check));
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -1814,7 +2009,8 @@ void database::_apply_transaction(const signed_transaction& trx)
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
          transaction.expiration = trx.expiration;
-         fc::raw::pack( transaction.packed_trx, trx );
+         if( _store_recent_transactions )
+            fc::raw::pack( transaction.packed_trx, trx );
       });
    }
 
@@ -2000,7 +2196,7 @@ void database::update_last_irreversible_block()
       {
          while( log_head_num < dpo.last_irreversible_block_num )
          {
-            shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( log_head_num+1 );
+            item_ptr block = _fork_db.fetch_block_on_main_branch_by_number( log_head_num+1 );
             FC_ASSERT( block, "Current fork in the fork database does not contain the last_irreversible_block" );
             _block_log.append( block->data );
             log_head_num++;
@@ -2016,10 +2212,13 @@ void database::update_last_irreversible_block()
 void database::clear_expired_transactions()
 {
    //Look for expired transactions in the deduplication list, and remove them.
-   //Transactions must have expired by at least two forking windows in order to be removed.
+   //They are removed together on the first block of each prune interval, so the other blocks only
+   //look at the oldest expiration.  An expired transaction fails the expiration check anyway.
+   uint32_t now = head_block_time().sec_since_epoch();
+   fc::time_point_sec prune_before( now - now % SIGMAENGINE_TRANSACTION_PRUNE_INTERVAL );
    auto& transaction_idx = get_index< transaction_index >();
    const auto& dedupe_index = transaction_idx.indices().get< by_expiration >();
-   while( ( !dedupe_index.empty() ) && ( head_block_time() > dedupe_index.begin()->expiration ) )
+   while( ( !dedupe_index.empty() ) && ( prune_before > dedupe_index.begin()->expiration ) )
       remove( *dedupe_index.begin() );
 }
 
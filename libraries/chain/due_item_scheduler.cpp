@@ -0,0 +1,62 @@
+#include <sigmaengine/chain/due_item_scheduler.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+
+namespace sigmaengine { namespace chain {
+
+void due_item_scheduler::register_processor( const std::string& name, next_due_function next_due, process_function process, bool at_end_of_block )
+{
+   FC_ASSERT( std::none_of( _processors.begin(), _processors.end(), [&]( const processor& p ){ return p.metrics.name == name; } ),
+      "Due item processor ${name} is already registered", ("name", name) );
+
+   processor p;
+   p.next_due = std::move( next_due );
+   p.process = std::move( process );
+   p.metrics.name = name;
+   p.at_end_of_block = at_end_of_block;
+   _processors.push_back( std::move( p ) );
+}
+
+void due_item_scheduler::run( fc::time_point_sec now )
+{
+   for( auto& p : _processors )
+      if( p.at_end_of_block )
+         run_processor( p, now );
+}
+
+void due_item_scheduler::run( const std::string& name, fc::time_point_sec now )
+{
+   auto itr = std::find_if( _processors.begin(), _processors.end(), [&]( const processor& p ){ return p.metrics.name == name; } );
+   FC_ASSERT( itr != _processors.end(), "Due item processor ${name} is not registered", ("name", name) );
+   run_processor( *itr, now );
+}
+
+void due_item_scheduler::run_processor( processor& p, fc::time_point_sec now )
+{
+   fc::optional< fc::time_point_sec > due = p.next_due();
+   if( !due.valid() || *due > now )
+      return;
+
+   auto start = fc::time_point::now();
+   uint32_t items = p.process( now );
+   uint64_t elapsed = ( fc::time_point::now() - start ).count();
+
+   p.metrics.runs++;
+   p.metrics.items += items;
+   p.metrics.total_us += elapsed;
+   p.metrics.max_us = std::max( p.metrics.max_us, elapsed );
+   p.metrics.last_run = now;
+}
+
+std::vector< due_processor_metrics > due_item_scheduler::get_metrics()const
+{
+   std::vector< due_processor_metrics > result;
+   result.reserve( _processors.size() );
+   for( const auto& p : _processors )
+      result.push_back( p.metrics );
+   return result;
+}
+
+} } // sigmaengine::chain
@@ -5,26 +5,87 @@
 namespace sigmaengine { namespace chain {
 
 fork_database::fork_database()
+   : _item_pool( sizeof( fork_item ), 128 )
 {
 }
+
+fork_database::~fork_database()
+{
+   clear_index( _unlinked_index );
+   clear_index( _index );
+}
+
 void fork_database::reset()
 {
-   _head.reset();
-   _index.clear();
+   _head = nullptr;
+   clear_index( _unlinked_index );
+   clear_index( _index );
+}
+
+item_ptr fork_database::create_item( signed_block&& b )
+{
+   void* mem = _item_pool.malloc();
+   if( mem == nullptr )
+      throw std::bad_alloc();
+   try
+   {
+      return new( mem ) fork_item( std::move( b ) );
+   }
+   catch( ... )
+   {
+      _item_pool.free( mem );
+      throw;
+   }
+}
+
+void fork_database::release_item( item_ptr item )
+{
+   item->~fork_item();
+   _item_pool.free( item );
+}
+
+void fork_database::erase_item( fork_multi_index_type& index, item_ptr item )
+{
+   auto& prev_idx = index.get<by_previous>();
+   auto range = prev_idx.equal_range( item->id );
+   for( auto itr = range.first; itr != range.second; ++itr )
+      if( (*itr)->prev == item )
+         (*itr)->prev = nullptr;
+
+   if( _head == item )
+      _head = item->prev;
+
+   index.get<block_id>().erase( item->id );
+   release_item( item );
+}
+
+void fork_database::clear_index( fork_multi_index_type& index )
+{
+   for( item_ptr item : index )
+      release_item( item );
+   index.clear();
 }
 
 void fork_database::pop_block()
 {
    FC_ASSERT( _head, "cannot pop an empty fork database" );
-   auto prev = _head->prev.lock();
+   auto prev = _head->prev;
    FC_ASSERT( prev, "popping head block would leave fork DB empty" );
    _head = prev;
 }
 
 void     fork_database::start_block(signed_block b)
 {
-   auto item = std::make_shared<fork_item>(std::move(b));
-   _index.insert(item);
+   auto item = create_item( std::move( b ) );
+   auto& index = _index.get<block_id>();
+   auto existing = index.find( item->id );
+   if( existing != index.end() )
+   {
+      release_item( item );
+      item = *existing;
+   }
+   else
+      _index.insert( item );
    _head = item;
 }
 
@@ -32,9 +93,9 @@ void     fork_database::start_block(signed_block b)
  * Pushes the block into the fork database and caches it if it doesn't link
  *
  */
-shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
+item_ptr  fork_database::push_block(const signed_block& b)
 {
-   auto item = std::make_shared<fork_item>(b);
+   auto item = create_item( signed_block( b ) );
    try {
       _push_block(item);
    }
@@ -42,13 +103,18 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
    {
       wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
       wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
+      release_item( item );
+      throw;
+   }
+   catch( ... )
+   {
+      release_item( item );
       throw;
-      _unlinked_index.insert( item );
    }
    return _head;
 }
 
-void  fork_database::_push_block(const item_ptr& item)
+void  fork_database::_push_block(item_ptr item)
 {
    if( _head ) // make sure the block is within the range that we are caching
    {
@@ -57,9 +123,20 @@ void  fork_database::_push_block(const item_ptr& item)
                  ("item->num",item->num)("head",_head->num)("max_size",_max_size));
    }
 
+   auto& index = _index.get<block_id>();
+
+   // A block we already hold (e.g. re-pushed after a pop) keeps its existing item
+   auto existing = index.find( item->id );
+   if( existing != index.end() )
+   {
+      release_item( item );
+      item = *existing;
+      if( !_head || item->num > _head->num ) _head = item;
+      return;
+   }
+
    if( _head && item->previous_id() != block_id_type() )
    {
-      auto& index = _index.get<block_id>();
       auto itr = index.find(item->previous_id());
       SIGMAENGINE_ASSERT(itr != index.end(), unlinkable_block_exception, "block does not link to known chain");
       FC_ASSERT(!(*itr)->invalid);
@@ -76,7 +153,7 @@ void  fork_database::_push_block(const item_ptr& item)
  *  set of calls performing a depth-first insertion of pending blocks as
  *  _push_next(..) calls _push_block(...) which will in turn call _push_next
  */
-void fork_database::_push_next( const item_ptr& new_item )
+void fork_database::_push_next( item_ptr new_item )
 {
     auto& prev_idx = _unlinked_index.get<by_previous>();
 
@@ -102,7 +179,7 @@ void fork_database::set_max_size( uint32_t s )
       while( itr != by_num_idx.end() )
       {
          if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
+            erase_item( _index, *itr );
          else
             break;
          itr = by_num_idx.begin();
@@ -114,7 +191,7 @@ void fork_database::set_max_size( uint32_t s )
       while( itr != by_num_idx.end() )
       {
          if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
+            erase_item( _unlinked_index, *itr );
          else
             break;
          itr = by_num_idx.begin();
@@ -143,7 +220,7 @@ item_ptr fork_database::fetch_block(const block_id_type& id)const
    auto unlinked_itr = unlinked_index.find(id);
    if( unlinked_itr != unlinked_index.end() )
       return *unlinked_itr;
-   return item_ptr();
+   return nullptr;
 }
 
 vector<item_ptr> fork_database::fetch_block_by_number(uint32_t num)const
@@ -173,32 +250,36 @@ pair<fork_database::branch_type,fork_database::branch_type>
    pair<branch_type,branch_type> result;
    auto first_branch_itr = _index.get<block_id>().find(first);
    FC_ASSERT(first_branch_itr != _index.get<block_id>().end());
-   auto first_branch = *first_branch_itr;
+   item_ptr first_branch = *first_branch_itr;
 
    auto second_branch_itr = _index.get<block_id>().find(second);
    FC_ASSERT(second_branch_itr != _index.get<block_id>().end());
-   auto second_branch = *second_branch_itr;
+   item_ptr second_branch = *second_branch_itr;
 
+   // Branches are at least as long as the height difference; reserve for the common case of a shallow fork
+   const uint32_t height_diff = first_branch->num > second_branch->num ? first_branch->num - second_branch->num : second_branch->num - first_branch->num;
+   result.first.reserve( height_diff + 2 );
+   result.second.reserve( height_diff + 2 );
 
-   while( first_branch->data.block_num() > second_branch->data.block_num() )
+   while( first_branch->num > second_branch->num )
    {
       result.first.push_back(first_branch);
-      first_branch = first_branch->prev.lock();
+      first_branch = first_branch->prev;
       FC_ASSERT(first_branch);
    }
-   while( second_branch->data.block_num() > first_branch->data.block_num() )
+   while( second_branch->num > first_branch->num )
    {
       result.second.push_back( second_branch );
-      second_branch = second_branch->prev.lock();
+      second_branch = second_branch->prev;
       FC_ASSERT(second_branch);
    }
    while( first_branch->data.previous != second_branch->data.previous )
    {
       result.first.push_back(first_branch);
       result.second.push_back(second_branch);
-      first_branch = first_branch->prev.lock();
+      first_branch = first_branch->prev;
       FC_ASSERT(first_branch);
-      second_branch = second_branch->prev.lock();
+      second_branch = second_branch->prev;
       FC_ASSERT(second_branch);
    }
    if( first_branch && second_branch )
@@ -209,35 +290,38 @@ pair<fork_database::branch_type,fork_database::branch_type>
    return result;
 } FC_CAPTURE_AND_RETHROW( (first)(second) ) }
 
-shared_ptr<fork_item> fork_database::walk_main_branch_to_num( uint32_t block_num )const
+item_ptr fork_database::walk_main_branch_to_num( uint32_t block_num )const
 {
-   shared_ptr<fork_item> next = head();
+   item_ptr next = head();
    if( block_num > next->num )
-      return shared_ptr<fork_item>();
+      return nullptr;
 
-   while( next.get() != nullptr && next->num > block_num )
-      next = next->prev.lock();
+   while( next != nullptr && next->num > block_num )
+      next = next->prev;
    return next;
 }
 
-shared_ptr<fork_item> fork_database::fetch_block_on_main_branch_by_number( uint32_t block_num )const
+item_ptr fork_database::fetch_block_on_main_branch_by_number( uint32_t block_num )const
 {
    vector<item_ptr> blocks = fetch_block_by_number(block_num);
    if( blocks.size() == 1 )
       return blocks[0];
    if( blocks.size() == 0 )
-      return shared_ptr<fork_item>();
+      return nullptr;
    return walk_main_branch_to_num(block_num);
 }
 
-void fork_database::set_head(shared_ptr<fork_item> h)
+void fork_database::set_head(item_ptr h)
 {
    _head = h;
 }
 
 void fork_database::remove(block_id_type id)
 {
-   _index.get<block_id>().erase(id);
+   auto& index = _index.get<block_id>();
+   auto itr = index.find( id );
+   if( itr != index.end() )
+      erase_item( _index, *itr );
 }
 
 } } // sigmaengine::chain
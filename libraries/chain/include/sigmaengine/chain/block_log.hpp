@@ -31,6 +31,15 @@ namespace sigmaengine { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Appends can be handed to a background writer with start_writer(). Queued blocks are written in
+    * batches, the main file is synced before their index entries are written, and they are served from
+    * memory until they reach disk. If the process dies mid-write, open() truncates the torn tail of the
+    * main file back to the last block recorded in the index.
+    *
+    * Each queued block is also written to a journal next to the log before append() returns. The journal
+    * only goes through the OS cache, like the shared memory state. If the process dies with blocks still
+    * queued, open() appends them from the journal, so the log again holds every block the state reflects.
     */
 
    class block_log {
@@ -42,11 +51,30 @@ namespace sigmaengine { namespace chain {
          void close();
          bool is_open()const;
 
+         /**
+          * Hand appends to a background thread. append() blocks only while max_queue_size
+          * blocks are already waiting to be written.
+          */
+         void start_writer( uint32_t max_queue_size );
+         void stop_writer();
+
          uint64_t append( const signed_block& b );
+         /** Writes buffered blocks out. With a background writer this only wakes it up. */
          void flush();
+         /** Blocks until every appended block has been written and synced. */
+         void wait_for_writes();
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
 
+         /**
+          * Appends the packed bytes of up to count blocks, starting at first_block_num, to out.
+          * The bytes are copied as stored, without unpacking the blocks, and the position
+          * trailers between blocks are left out.
+          *
+          * @return the number of blocks appended, fewer than count past the head of the log
+          */
+         uint32_t read_block_data( uint32_t first_block_num, uint32_t count, std::vector< char >& out )const;
+
          /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
@@ -58,6 +86,8 @@ namespace sigmaengine { namespace chain {
 
       private:
          void construct_index();
+         void recover_torn_tail();
+         void recover_journal();
 
          std::unique_ptr<detail::block_log_impl> my;
    };
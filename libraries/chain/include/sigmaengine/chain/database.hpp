@@ -6,6 +6,8 @@
 #include <sigmaengine/chain/hardfork_property_object.hpp>
 #include <sigmaengine/chain/node_property_object.hpp>
 #include <sigmaengine/chain/fork_database.hpp>
+#include <sigmaengine/chain/pending_transaction_pool.hpp>
+#include <sigmaengine/chain/due_item_scheduler.hpp>
 #include <sigmaengine/chain/block_log.hpp>
 #include <sigmaengine/chain/operation_notification.hpp>
 
@@ -109,6 +111,12 @@ namespace sigmaengine { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /**
+          *  Appends up to count consecutive packed blocks starting at first_block_num to out.
+          *  Irreversible blocks are copied from the block log as stored; only reversible ones
+          *  are packed.  @return the number of blocks appended
+          */
+         uint32_t                   fetch_block_data_by_number( uint32_t first_block_num, uint32_t count, std::vector<char>& out )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -164,6 +172,31 @@ namespace sigmaengine { namespace chain {
             const fc::ecc::private_key& block_signing_private_key
             );
 
+         /**
+          *  Builds the block generate_block would produce at when from the pending
+          *  transactions, without signing or pushing it, so it can be assembled ahead of
+          *  its slot.  The block must be passed to sign_and_push_block before anything
+          *  else changes the head block.
+          */
+         signed_block assemble_block(
+            const fc::time_point_sec when,
+            const account_name_type& bobserver_owner,
+            uint32_t skip
+            );
+         signed_block _assemble_block(
+            const fc::time_point_sec when,
+            const account_name_type& bobserver_owner
+            );
+         void sign_and_push_block(
+            signed_block& pending_block,
+            const fc::ecc::private_key& block_signing_private_key,
+            uint32_t skip
+            );
+         void _sign_and_push_block(
+            signed_block& pending_block,
+            const fc::ecc::private_key& block_signing_private_key
+            );
+
          void pop_block();
          void clear_pending();
 
@@ -293,7 +326,7 @@ namespace sigmaengine { namespace chain {
           * adjust_proxied_bobserver_votes( a, -a.bobserver_vote_weight() )
           */
          void clear_bobserver_votes( const account_object& a );
-         void account_recovery_processing();
+         uint32_t account_recovery_processing();
 
          time_point_sec   head_block_time()const;
          uint32_t         head_block_num()const;
@@ -337,12 +370,29 @@ namespace sigmaengine { namespace chain {
          const std::string& get_json_schema() const;
 
          void set_flush_interval( uint32_t flush_blocks );
+         /** Write back shared memory on a background thread instead of blocking apply_block. Takes effect on open() */
+         void set_background_flush( bool enabled );
+         void set_max_pending_transactions_size( uint64_t max_size );
+         /** Keep a packed copy of each recent transaction for get_recent_transaction, not only its id */
+         void set_store_recent_transactions( bool store );
+         /** Irreversible blocks are appended to the block log by a background writer holding up to this many blocks; 0 writes synchronously */
+         void set_block_log_queue_size( uint32_t queue_size );
+         const pending_transaction_pool& get_pending_transactions()const { return _pending_tx; }
+
+         /**
+          *  Registers processing of items that become due at a block time.  Processors run at the end of
+          *  each block that something is due in, in the order they were registered.  The database's own
+          *  run earlier, where they always have.
+          */
+         void register_due_processor( const string& name, due_item_scheduler::next_due_function next_due, due_item_scheduler::process_function process );
+         vector< due_processor_metrics > get_due_processor_metrics()const;
+
          void show_free_memory( bool force );
          // bool skip_transaction_delta_check = true;
 
          void process_funds();
-         void process_savings_withdraws();
-         void process_fund_withdraws();
+         uint32_t process_savings_withdraws();
+         uint32_t process_fund_withdraws();
          void process_transaction_fee();
 
          const common_fund_object&              get_common_fund( const string name )const;
@@ -393,12 +443,15 @@ namespace sigmaengine { namespace chain {
 
          std::unique_ptr< database_impl > _my;
 
-         vector< signed_transaction >  _pending_tx;
+         pending_transaction_pool      _pending_tx;
+         due_item_scheduler            _due_items;
          fork_database                 _fork_db;
          fc::time_point_sec            _hardfork_times[ SIGMAENGINE_NUM_HARDFORKS + 1 ];
          protocol::hardfork_version    _hardfork_versions[ SIGMAENGINE_NUM_HARDFORKS + 1 ];
 
          block_log                     _block_log;
+         uint32_t                      _block_log_queue_size = 0;
+         bool                          _store_recent_transactions = false;
 
          // this function needs access to _plugin_index_signal
          template< typename MultiIndexType >
@@ -407,6 +460,7 @@ namespace sigmaengine { namespace chain {
          fc::signal< void() >          _plugin_index_signal;
 
          transaction_id_type           _current_trx_id;
+         share_type                    _current_trx_fee;
          uint32_t                      _current_block_num    = 0;
          uint16_t                      _current_trx_in_block = 0;
          uint16_t                      _current_op_in_trx    = 0;
@@ -418,6 +472,7 @@ namespace sigmaengine { namespace chain {
 
          uint32_t                      _flush_blocks = 0;
          uint32_t                      _next_flush_block = 0;
+         bool                          _background_flush = false;
 
          uint32_t                      _last_free_gb_printed = 0;
 
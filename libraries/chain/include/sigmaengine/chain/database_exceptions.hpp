@@ -77,6 +77,7 @@ namespace sigmaengine { namespace chain {
 
    FC_DECLARE_DERIVED_EXCEPTION( transaction_expiration_exception,  sigmaengine::chain::transaction_exception, 4030100, "transaction expiration exception" )
    FC_DECLARE_DERIVED_EXCEPTION( transaction_tapos_exception,       sigmaengine::chain::transaction_exception, 4030200, "transaction tapos exception" )
+   FC_DECLARE_DERIVED_EXCEPTION( pending_transaction_pool_full,     sigmaengine::chain::transaction_exception, 4030300, "pending transaction pool is full" )
 
    FC_DECLARE_DERIVED_EXCEPTION( pop_empty_chain,                   sigmaengine::chain::undo_database_exception, 4070001, "there are no blocks to pop" )
 
@@ -0,0 +1,69 @@
+#pragma once
+#include <fc/optional.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sigmaengine { namespace chain {
+
+   struct due_processor_metrics
+   {
+      std::string          name;
+      uint64_t             runs = 0;           ///< blocks in which something was due
+      uint64_t             items = 0;          ///< items processed over all runs
+      uint64_t             total_us = 0;
+      uint64_t             max_us = 0;
+      fc::time_point_sec   last_run;
+   };
+
+   /**
+    *  Runs the per-block processing of items that become due at a block time, such as
+    *  withdrawals completing or requests expiring.
+    *
+    *  Each module registers a processor that can tell when its earliest item is due,
+    *  normally the first entry of an index ordered by due time, and one that processes
+    *  everything due.  A block only calls into the processors that have something due,
+    *  in the order they were registered, and records how much work each did.  A processor
+    *  that has to keep its place among other block processing is registered with
+    *  at_end_of_block false and run by name from there instead.
+    *
+    *  Due items stay in their chain state indexes, so they follow undo sessions and fork
+    *  switches without the scheduler holding a copy of them.
+    */
+   class due_item_scheduler
+   {
+      public:
+         /// the time the earliest item is due, or nothing when there is none
+         typedef std::function< fc::optional< fc::time_point_sec >() >  next_due_function;
+         /// processes every item due at now, returning how many there were
+         typedef std::function< uint32_t( fc::time_point_sec now ) >     process_function;
+
+         void register_processor( const std::string& name, next_due_function next_due, process_function process, bool at_end_of_block = true );
+
+         /// runs the processors registered to run at the end of the block
+         void run( fc::time_point_sec now );
+         /// runs the one processor registered as name
+         void run( const std::string& name, fc::time_point_sec now );
+
+         std::vector< due_processor_metrics > get_metrics()const;
+
+      private:
+         struct processor
+         {
+            next_due_function       next_due;
+            process_function        process;
+            due_processor_metrics   metrics;
+            bool                    at_end_of_block = true;
+         };
+
+         void run_processor( processor& p, fc::time_point_sec now );
+
+         std::vector< processor >   _processors;
+   };
+
+} } // sigmaengine::chain
+
+FC_REFLECT( sigmaengine::chain::due_processor_metrics, (name)(runs)(items)(total_us)(max_us)(last_run) )
@@ -7,6 +7,8 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
+#include <boost/pool/pool.hpp>
+
 
 namespace sigmaengine { namespace chain {
    using boost::multi_index_container;
@@ -17,12 +19,16 @@ namespace sigmaengine { namespace chain {
 
    struct fork_item
    {
-      fork_item( signed_block d )
+      fork_item( signed_block&& d )
       :num(d.block_num()),id(d.id()),data( std::move(d) ){}
 
       block_id_type previous_id()const { return data.previous; }
 
-      weak_ptr< fork_item > prev;
+      /**
+       * Intrusive link to the parent block.  It is cleared by the fork database
+       * when the parent is removed, so it is null for the oldest block kept.
+       */
+      fork_item*            prev = nullptr;
       uint32_t              num;    // initialized in ctor
       /**
        * Used to flag a block as invalid and prevent other blocks from
@@ -32,7 +38,13 @@ namespace sigmaengine { namespace chain {
       block_id_type         id;
       signed_block          data;
    };
-   typedef shared_ptr<fork_item> item_ptr;
+
+   /**
+    * Items are owned by the fork database and allocated from its pool.  An
+    * item_ptr stays valid until the block is removed or falls out of the
+    * fork database window, so callers must not hold one across those calls.
+    */
+   typedef fork_item* item_ptr;
 
 
    /**
@@ -53,20 +65,24 @@ namespace sigmaengine { namespace chain {
          const static int MAX_BLOCK_REORDERING = 1024;
 
          fork_database();
+         ~fork_database();
+         fork_database( const fork_database& ) = delete;
+         fork_database& operator=( const fork_database& ) = delete;
+
          void reset();
 
          void                             start_block(signed_block b);
          void                             remove(block_id_type b);
-         void                             set_head(shared_ptr<fork_item> h);
+         void                             set_head(item_ptr h);
          bool                             is_known_block(const block_id_type& id)const;
-         shared_ptr<fork_item>            fetch_block(const block_id_type& id)const;
+         item_ptr                         fetch_block(const block_id_type& id)const;
          vector<item_ptr>                 fetch_block_by_number(uint32_t n)const;
 
          /**
           *  @return the new head block ( the longest fork )
           */
-         shared_ptr<fork_item>            push_block(const signed_block& b);
-         shared_ptr<fork_item>            head()const { return _head; }
+         item_ptr                         push_block(const signed_block& b);
+         item_ptr                         head()const { return _head; }
          void                             pop_block();
 
          /**
@@ -75,8 +91,8 @@ namespace sigmaengine { namespace chain {
           */
          pair< branch_type, branch_type >  fetch_branch_from(block_id_type first,
                                                              block_id_type second)const;
-         shared_ptr<fork_item>            walk_main_branch_to_num( uint32_t block_num )const;
-         shared_ptr<fork_item>            fetch_block_on_main_branch_by_number( uint32_t block_num )const;
+         item_ptr                         walk_main_branch_to_num( uint32_t block_num )const;
+         item_ptr                         fetch_block_on_main_branch_by_number( uint32_t block_num )const;
 
          struct block_id;
          struct block_num;
@@ -94,14 +110,21 @@ namespace sigmaengine { namespace chain {
 
       private:
          /** @return a pointer to the newly pushed item */
-         void _push_block(const item_ptr& b );
-         void _push_next(const item_ptr& newly_inserted);
+         void _push_block(item_ptr b );
+         void _push_next(item_ptr newly_inserted);
+
+         item_ptr                 create_item( signed_block&& b );
+         void                     release_item( item_ptr item );
+         /** Removes an item from the index, unlinks its children and returns it to the pool */
+         void                     erase_item( fork_multi_index_type& index, item_ptr item );
+         void                     clear_index( fork_multi_index_type& index );
 
          uint32_t                 _max_size = 1024;
 
+         boost::pool<>            _item_pool;
          fork_multi_index_type    _unlinked_index;
          fork_multi_index_type    _index;
-         shared_ptr<fork_item>    _head;
+         item_ptr                 _head = nullptr;
    };
 
 } } // sigmaengine::chain
@@ -0,0 +1,128 @@
+#pragma once
+#include <sigmaengine/protocol/transaction.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+
+namespace sigmaengine { namespace chain {
+   using boost::multi_index_container;
+   using namespace boost::multi_index;
+
+   using sigmaengine::protocol::signed_transaction;
+   using sigmaengine::protocol::transaction_id_type;
+   using sigmaengine::protocol::share_type;
+
+   struct pending_transaction
+   {
+      pending_transaction( const signed_transaction& t, share_type f, uint64_t seq );
+
+      signed_transaction    trx;
+      transaction_id_type   id;
+      fc::time_point_sec    expiration;
+      uint32_t              packed_size = 0;
+      share_type            fee;
+      /** fee paid per kilobyte of packed transaction, the priority used for block assembly and eviction */
+      uint64_t              fee_per_kbyte = 0;
+      /** arrival order, used to break ties and to replay the pool in the order it was received */
+      uint64_t              sequence = 0;
+   };
+
+   /**
+    *  Holds the transactions which have been applied to the pending state but
+    *  not yet included in a block.
+    *
+    *  The pool is bounded by the total packed size of its transactions.  When a
+    *  transaction does not fit, expired transactions are dropped first and then
+    *  the transactions paying the lowest fee per byte.  A transaction which pays
+    *  no more than everything it would have to evict is rejected instead.
+    *
+    *  Block production walks the pool by priority (fee per byte, then arrival),
+    *  while fork switches replay it in arrival order so that dependent
+    *  transactions are re-applied in the order they were accepted.
+    */
+   class pending_transaction_pool
+   {
+      public:
+         /// The default bound on the total packed size of pending transactions
+         const static uint64_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+
+         struct by_sequence;
+         struct by_trx_id;
+         struct by_expiration;
+         struct by_priority;
+         typedef multi_index_container<
+            pending_transaction,
+            indexed_by<
+               ordered_unique< tag< by_sequence >, member< pending_transaction, uint64_t, &pending_transaction::sequence > >,
+               hashed_unique< tag< by_trx_id >, member< pending_transaction, transaction_id_type, &pending_transaction::id >, std::hash< fc::ripemd160 > >,
+               ordered_non_unique< tag< by_expiration >, member< pending_transaction, fc::time_point_sec, &pending_transaction::expiration > >,
+               ordered_unique< tag< by_priority >,
+                  composite_key< pending_transaction,
+                     member< pending_transaction, uint64_t, &pending_transaction::fee_per_kbyte >,
+                     member< pending_transaction, uint64_t, &pending_transaction::sequence >
+                  >,
+                  composite_key_compare< std::greater< uint64_t >, std::less< uint64_t > >
+               >
+            >
+         > pending_transaction_multi_index_type;
+
+         void                 set_max_size( uint64_t s );
+         uint64_t             max_size()const { return _max_size; }
+         uint64_t             total_size()const { return _total_size; }
+         size_t               size()const { return _index.size(); }
+         bool                 empty()const { return _index.empty(); }
+
+         bool                 contains( const transaction_id_type& id )const;
+         const signed_transaction* find( const transaction_id_type& id )const;
+
+         /**
+          *  Checks whether a transaction of the given size and fee could be
+          *  admitted, without modifying the pool.
+          */
+         bool                 can_accept( uint32_t packed_size, share_type fee, fc::time_point_sec now )const;
+
+         /**
+          *  Adds a transaction that has already been applied to the pending state,
+          *  evicting expired and lower priority transactions as needed.
+          *
+          *  @return false if the pool is full and the transaction was not admitted
+          */
+         bool                 push( const signed_transaction& trx, share_type fee, fc::time_point_sec now );
+
+         void                 remove( const transaction_id_type& id );
+         uint32_t             remove_expired( fc::time_point_sec now );
+         void                 clear();
+
+         /**
+          *  Removes every transaction from the pool, returned in arrival order.
+          */
+         vector< signed_transaction > extract();
+
+         const pending_transaction_multi_index_type::index< by_priority >::type& by_priority_index()const
+         {
+            return _index.get< by_priority >();
+         }
+
+         uint64_t             evicted_count()const { return _evicted_count; }
+         uint64_t             rejected_count()const { return _rejected_count; }
+         uint64_t             expired_count()const { return _expired_count; }
+
+      private:
+         static uint64_t      fee_per_kbyte( share_type fee, uint32_t packed_size );
+
+         pending_transaction_multi_index_type   _index;
+
+         uint64_t             _max_size = DEFAULT_MAX_SIZE;
+         uint64_t             _total_size = 0;
+         uint64_t             _next_sequence = 0;
+
+         uint64_t             _evicted_count = 0;
+         uint64_t             _rejected_count = 0;
+         uint64_t             _expired_count = 0;
+   };
+
+} } // sigmaengine::chain
@@ -7,6 +7,7 @@
 #include <sigmaengine/chain/account_object.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
 
@@ -149,6 +150,10 @@ namespace sigmaengine { namespace chain {
          account_name_type       voter;
          asset                   trx_fee = asset(0, SGT_SYMBOL);
          uint32_t                vote_block = 0;
+         /// set once vote_block falls outside the refresh cycle, cleared by a new vote
+         bool                    expired = false;
+
+         share_type fee_amount()const { return trx_fee.amount; }
    };
 
    class transaction_fee_reward_object : public object< transaction_fee_reward_object_type, transaction_fee_reward_object>
@@ -299,6 +304,8 @@ namespace sigmaengine { namespace chain {
    > dapp_reward_fund_index;
 
    struct by_voter;
+   struct by_expired_fee;
+   struct by_expired_vote_block;
    typedef multi_index_container <
       transaction_fee_vote_object,
       indexed_by <
@@ -309,6 +316,20 @@ namespace sigmaengine { namespace chain {
             composite_key< transaction_fee_vote_object,
                member < transaction_fee_vote_object, account_name_type, &transaction_fee_vote_object::voter >
             >
+         >,
+         ranked_unique < tag < by_expired_fee >,
+            composite_key< transaction_fee_vote_object,
+               member < transaction_fee_vote_object, bool, &transaction_fee_vote_object::expired >,
+               const_mem_fun < transaction_fee_vote_object, share_type, &transaction_fee_vote_object::fee_amount >,
+               member < transaction_fee_vote_object, transaction_fee_vote_id_type, &transaction_fee_vote_object::id >
+            >
+         >,
+         ordered_unique < tag < by_expired_vote_block >,
+            composite_key< transaction_fee_vote_object,
+               member < transaction_fee_vote_object, bool, &transaction_fee_vote_object::expired >,
+               member < transaction_fee_vote_object, uint32_t, &transaction_fee_vote_object::vote_block >,
+               member < transaction_fee_vote_object, transaction_fee_vote_id_type, &transaction_fee_vote_object::id >
+            >
          >
       >,
       allocator < transaction_fee_vote_object >
@@ -363,6 +384,7 @@ FC_REFLECT( sigmaengine::chain::transaction_fee_vote_object,
    ( voter )
    ( trx_fee )
    ( vote_block )
+   ( expired )
 )
 CHAINBASE_SET_INDEX_TYPE( sigmaengine::chain::transaction_fee_vote_object, sigmaengine::chain::transaction_fee_vote_index )
 
@@ -13,6 +13,9 @@ namespace sigmaengine { namespace chain {
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
     * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
     * expired can be removed from the index.
+    *
+    * packed_trx is left empty unless the database stores recent transactions, so that the duplicate check only
+    * holds the id and expiration in shared memory.
     */
    class transaction_object : public object< transaction_object_type, transaction_object >
    {
@@ -0,0 +1,141 @@
+#include <sigmaengine/chain/pending_transaction_pool.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace sigmaengine { namespace chain {
+
+pending_transaction::pending_transaction( const signed_transaction& t, share_type f, uint64_t seq )
+   : trx( t ), id( t.id() ), expiration( t.expiration ), packed_size( fc::raw::pack_size( t ) ), fee( f ), sequence( seq )
+{
+}
+
+uint64_t pending_transaction_pool::fee_per_kbyte( share_type fee, uint32_t packed_size )
+{
+   if( fee.value <= 0 || packed_size == 0 )
+      return 0;
+   // fee is bounded by SIGMAENGINE_MAX_SHARE_SUPPLY, so this cannot overflow
+   return ( uint64_t( fee.value ) * 1024 ) / packed_size;
+}
+
+void pending_transaction_pool::set_max_size( uint64_t s )
+{
+   _max_size = s;
+}
+
+bool pending_transaction_pool::contains( const transaction_id_type& id )const
+{
+   const auto& id_idx = _index.get< by_trx_id >();
+   return id_idx.find( id ) != id_idx.end();
+}
+
+const signed_transaction* pending_transaction_pool::find( const transaction_id_type& id )const
+{
+   const auto& id_idx = _index.get< by_trx_id >();
+   auto itr = id_idx.find( id );
+   return itr == id_idx.end() ? nullptr : &itr->trx;
+}
+
+bool pending_transaction_pool::can_accept( uint32_t packed_size, share_type fee, fc::time_point_sec now )const
+{
+   if( packed_size > _max_size )
+      return false;
+   if( _total_size + packed_size <= _max_size )
+      return true;
+
+   uint64_t needed = _total_size + packed_size - _max_size;
+   uint64_t freed = 0;
+
+   const auto& exp_idx = _index.get< by_expiration >();
+   for( auto itr = exp_idx.begin(); itr != exp_idx.end() && itr->expiration < now && freed < needed; ++itr )
+      freed += itr->packed_size;
+
+   // Only transactions paying strictly less per byte may be displaced
+   const uint64_t priority = fee_per_kbyte( fee, packed_size );
+   const auto& prio_idx = _index.get< by_priority >();
+   for( auto itr = prio_idx.rbegin(); itr != prio_idx.rend() && freed < needed; ++itr )
+   {
+      if( itr->fee_per_kbyte >= priority )
+         break;
+      if( itr->expiration >= now )
+         freed += itr->packed_size;
+   }
+
+   return freed >= needed;
+}
+
+bool pending_transaction_pool::push( const signed_transaction& trx, share_type fee, fc::time_point_sec now )
+{
+   pending_transaction item( trx, fee, _next_sequence );
+   item.fee_per_kbyte = fee_per_kbyte( item.fee, item.packed_size );
+
+   if( contains( item.id ) )
+      return true;
+
+   if( !can_accept( item.packed_size, item.fee, now ) )
+   {
+      ++_rejected_count;
+      return false;
+   }
+
+   if( _total_size + item.packed_size > _max_size )
+   {
+      remove_expired( now );
+
+      auto& prio_idx = _index.get< by_priority >();
+      while( _total_size + item.packed_size > _max_size )
+      {
+         auto lowest = std::prev( prio_idx.end() );
+         _total_size -= lowest->packed_size;
+         prio_idx.erase( lowest );
+         ++_evicted_count;
+      }
+   }
+
+   _total_size += item.packed_size;
+   ++_next_sequence;
+   _index.insert( std::move( item ) );
+   return true;
+}
+
+void pending_transaction_pool::remove( const transaction_id_type& id )
+{
+   auto& id_idx = _index.get< by_trx_id >();
+   auto itr = id_idx.find( id );
+   if( itr == id_idx.end() )
+      return;
+   _total_size -= itr->packed_size;
+   id_idx.erase( itr );
+}
+
+uint32_t pending_transaction_pool::remove_expired( fc::time_point_sec now )
+{
+   uint32_t removed = 0;
+   auto& exp_idx = _index.get< by_expiration >();
+   auto itr = exp_idx.begin();
+   while( itr != exp_idx.end() && itr->expiration < now )
+   {
+      _total_size -= itr->packed_size;
+      itr = exp_idx.erase( itr );
+      ++removed;
+   }
+   _expired_count += removed;
+   return removed;
+}
+
+void pending_transaction_pool::clear()
+{
+   _index.clear();
+   _total_size = 0;
+}
+
+vector< signed_transaction > pending_transaction_pool::extract()
+{
+   vector< signed_transaction > result;
+   result.reserve( _index.size() );
+   for( const auto& item : _index.get< by_sequence >() )
+      result.push_back( item.trx );
+   clear();
+   return result;
+}
+
+} } // sigmaengine::chain
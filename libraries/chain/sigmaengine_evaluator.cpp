@@ -826,6 +826,7 @@ void vote_transaction_fee_evaluator::do_apply(const vote_transaction_fee_operati
             _db.modify( *vote_itr, [&]( transaction_fee_vote_object& object ) {
                object.trx_fee = o.trx_fee;
                object.vote_block = _db.head_block_num();
+               object.expired = false;
             });
          }
 
@@ -161,7 +161,7 @@ namespace chainbase {
    class int_incrementer
    {
       public:
-         int_incrementer( int32_t& target ) : _target(target)
+         int_incrementer( std::atomic< int32_t >& target ) : _target(target)
          { ++_target; }
          ~int_incrementer()
          { --_target; }
@@ -170,7 +170,7 @@ namespace chainbase {
          { return _target; }
 
       private:
-         int32_t& _target;
+         std::atomic< int32_t >& _target;
    };
 
    /**
@@ -660,6 +660,50 @@ namespace chainbase {
    };
 
 
+   /**
+    *  Counters for writeback of the shared memory file.  Durations are measured
+    *  on the thread doing the writeback.
+    */
+   struct flush_stats
+   {
+      uint64_t    flush_count = 0;
+      uint64_t    last_flush_us = 0;
+      uint64_t    max_flush_us = 0;
+      uint64_t    total_flush_us = 0;
+      /// Size of the mapped ranges passed to msync, clean pages included
+      uint64_t    bytes_synced = 0;
+      /// Flushes requested while one was already in progress
+      uint64_t    coalesced_requests = 0;
+      /// Dirty bytes of the mapping when the last flush started, 0 where unsupported
+      uint64_t    dirty_bytes_before_last_flush = 0;
+   };
+
+   /**
+    *  How the shared memory file is mapped.  These only take effect on Linux and
+    *  are applied by open(), so set them before opening the database.
+    *
+    *  Explicit huge pages are used by placing the shared memory file on a
+    *  hugetlbfs mount; open() detects it and rounds the file size up to the huge
+    *  page size.  Transparent huge pages are requested with MADV_HUGEPAGE, which
+    *  the kernel only honours for file mappings on filesystems that support it.
+    */
+   struct mapping_options
+   {
+      enum huge_page_mode
+      {
+         huge_pages_none,
+         huge_pages_transparent
+      };
+
+      huge_page_mode    huge_pages = huge_pages_none;
+      /// Fault the whole mapping in at open so replay does not pay for it one page at a time
+      bool              prefault = false;
+      /// mlock the mapping; open() fails if RLIMIT_MEMLOCK does not allow it
+      bool              lock = false;
+      /// Prefer memory on this NUMA node, -1 for the default policy
+      int32_t           numa_node = -1;
+   };
+
    /**
     *  This class
     */
@@ -671,14 +715,52 @@ namespace chainbase {
             read_write    = 1
          };
 
+         /// Size of each msync issued by the background flush thread
+         static const uint64_t default_flush_chunk_size = 64 * 1024 * 1024;
+
          database():_session_signal( std::make_shared< session_signal >() ){}
+         ~database();
 
-         void open( const bfs::path& dir, uint32_t write = read_only, uint64_t shared_file_size = 0 );
+         /**
+          *  layout_version is stored in a new database and must match when an existing one is opened,
+          *  as indexes are found by type name alone and can not tell that their objects changed.
+          */
+         void open( const bfs::path& dir, uint32_t write = read_only, uint64_t shared_file_size = 0, uint32_t layout_version = 0 );
          void close();
          void flush();
+
+         /**
+          *  Starts a thread that writes back the shared memory file when request_flush()
+          *  is called.  The mapping is synced in chunks of chunk_size so that no single
+          *  msync covers the whole file, and the caller never waits on the disk.
+          */
+         void start_background_flush( uint64_t chunk_size = default_flush_chunk_size );
+         void stop_background_flush();
+         bool has_background_flush()const { return bool( _flush_thread ); }
+
+         /**
+          *  Schedules a writeback on the background thread, or flushes synchronously
+          *  when it is not running.  Requests made during a flush are coalesced into
+          *  one follow-up pass.
+          */
+         void request_flush();
+
+         flush_stats get_flush_stats()const;
+
+         /**
+          *  Bytes of the mapping that are dirty in the page cache.  Reads /proc/self/smaps,
+          *  so the result is cached for dirty_bytes_ttl_ms and callers in between share one
+          *  scan.  Returns 0 on platforms without it.
+          */
+         uint64_t get_dirty_bytes()const;
+
+         static const uint32_t dirty_bytes_ttl_ms = 1000;
          void wipe( const bfs::path& dir );
          void set_require_locking( bool enable_require_locking );
 
+         void set_mapping_options( const mapping_options& opts ) { _mapping_options = opts; }
+         const mapping_options& get_mapping_options()const { return _mapping_options; }
+
 #ifdef CHAINBASE_CHECK_LOCKING
          void require_lock_fail( const char* method, const char* lock_type, const char* tname )const;
 
@@ -1007,6 +1089,11 @@ namespace chainbase {
          std::shared_ptr< session_signal > get_session_signal() { return _session_signal; }
 
       private:
+         void apply_mapping_options();
+         void background_flush_loop();
+         void record_flush( const boost::chrono::steady_clock::time_point& start, uint64_t bytes, uint64_t dirty_bytes );
+         uint64_t read_dirty_bytes()const;
+
          unique_ptr<bip::managed_mapped_file>                        _segment;
          unique_ptr<bip::managed_mapped_file>                        _meta;
          read_write_mutex_manager*                                   _rw_manager = nullptr;
@@ -1025,10 +1112,27 @@ namespace chainbase {
 
          bfs::path                                                   _data_dir;
 
-         int32_t                                                     _read_lock_count = 0;
-         int32_t                                                     _write_lock_count = 0;
+         /// read locks are taken on RPC worker threads as well
+         std::atomic< int32_t >                                      _read_lock_count{ 0 };
+         std::atomic< int32_t >                                      _write_lock_count{ 0 };
          bool                                                        _enable_require_locking = false;
          std::shared_ptr< session_signal >                           _session_signal;
+
+         mapping_options                                             _mapping_options;
+
+         unique_ptr< boost::thread >                                 _flush_thread;
+         mutable boost::mutex                                        _flush_mutex;
+         boost::condition_variable                                   _flush_cv;
+         uint64_t                                                    _flush_chunk_size = default_flush_chunk_size;
+         bool                                                        _flush_requested = false;
+         bool                                                        _flush_in_progress = false;
+         bool                                                        _flush_stopping = false;
+         flush_stats                                                 _flush_stats;
+
+         mutable boost::mutex                                        _dirty_bytes_mutex;
+         mutable uint64_t                                            _dirty_bytes = 0;
+         mutable boost::chrono::steady_clock::time_point             _dirty_bytes_time;
+         mutable bool                                                _dirty_bytes_valid = false;
    };
 
    template<typename Object, typename... Args>
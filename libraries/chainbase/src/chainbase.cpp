@@ -1,8 +1,21 @@
 #include <chainbase/chainbase.hpp>
 #include <boost/array.hpp>
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+#endif
+
 namespace chainbase {
    struct environment_check {
       environment_check() {
@@ -29,9 +42,91 @@ namespace chainbase {
       bool                    windows = false;
    };
 
-   void database::open( const bfs::path& dir, uint32_t flags, uint64_t shared_file_size ) {
+#ifdef __linux__
+   namespace {
+      // Memory policy modes from <linux/mempolicy.h>, used through syscall() to avoid depending on libnuma
+      const int mpol_default   = 0;
+      const int mpol_preferred = 1;
+
+      std::vector< unsigned long > numa_node_mask( int32_t node )
+      {
+         const size_t bits = sizeof( unsigned long ) * 8;
+         std::vector< unsigned long > mask( node / bits + 1, 0 );
+         mask[ node / bits ] |= 1ul << ( node % bits );
+         return mask;
+      }
+
+      /// @return the huge page size if dir is on hugetlbfs, otherwise 0
+      uint64_t hugetlbfs_page_size( const bfs::path& dir )
+      {
+         struct statfs fs;
+         if( ::statfs( dir.generic_string().c_str(), &fs ) != 0 || uint64_t( fs.f_type ) != HUGETLBFS_MAGIC )
+            return 0;
+         return fs.f_bsize;
+      }
+   }
+#endif
+
+   void database::apply_mapping_options()
+   {
+#ifdef __linux__
+      char* base = static_cast< char* >( _segment->get_address() );
+      const size_t size = _segment->get_size();
+
+      if( _mapping_options.huge_pages == mapping_options::huge_pages_transparent )
+      {
+         if( ::madvise( base, size, MADV_HUGEPAGE ) != 0 )
+            std::cerr << "chainbase: transparent huge pages are not available for the shared memory file: " << strerror( errno ) << "\n";
+      }
+
+      if( _mapping_options.numa_node >= 0 )
+      {
+         // The range policy covers shmem and hugetlbfs pages; page cache pages of a regular file follow
+         // the policy of the faulting thread, which is why the prefault below runs under the same policy.
+         auto mask = numa_node_mask( _mapping_options.numa_node );
+         if( ::syscall( SYS_mbind, base, size, mpol_preferred, mask.data(), mask.size() * sizeof( unsigned long ) * 8 + 1, 0 ) != 0 )
+            std::cerr << "chainbase: could not bind the shared memory file to NUMA node " << _mapping_options.numa_node << ": " << strerror( errno ) << "\n";
+      }
+
+      if( _mapping_options.prefault )
+      {
+         bool thread_policy_set = false;
+         if( _mapping_options.numa_node >= 0 )
+         {
+            auto mask = numa_node_mask( _mapping_options.numa_node );
+            thread_policy_set = ::syscall( SYS_set_mempolicy, mpol_preferred, mask.data(), mask.size() * sizeof( unsigned long ) * 8 + 1 ) == 0;
+         }
+
+         bool populated = false;
+#ifdef MADV_POPULATE_READ
+         populated = ::madvise( base, size, MADV_POPULATE_READ ) == 0;
+#endif
+         if( !populated )
+         {
+            // Reading, not writing, so prefaulting does not dirty every page of the file
+            const size_t page_size = bip::mapped_region::get_page_size();
+            volatile char sink = 0;
+            for( size_t offset = 0; offset < size; offset += page_size )
+               sink ^= base[ offset ];
+            (void)sink;
+         }
+
+         if( thread_policy_set )
+            ::syscall( SYS_set_mempolicy, mpol_default, nullptr, 0 );
+      }
+
+      if( _mapping_options.lock )
+      {
+         if( ::mlock( base, size ) != 0 )
+            BOOST_THROW_EXCEPTION( std::runtime_error( std::string( "could not lock the shared memory file in memory: " ) + strerror( errno ) ) );
+      }
+#endif
+   }
+
+   void database::open( const bfs::path& dir, uint32_t flags, uint64_t shared_file_size, uint32_t layout_version ) {
 
       bool write = flags & database::read_write;
+      stop_background_flush();
 
       if( !bfs::exists( dir ) ) {
 	  	
@@ -52,6 +147,12 @@ namespace chainbase {
       _data_dir = dir;
       auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
 
+#ifdef __linux__
+      // hugetlbfs files can only be sized in whole huge pages
+      if( uint64_t huge_page_size = hugetlbfs_page_size( dir ) )
+         shared_file_size = ( shared_file_size + huge_page_size - 1 ) / huge_page_size * huge_page_size;
+#endif
+
       if( bfs::exists( abs_path ) )
       {
          if( write )
@@ -77,13 +178,21 @@ namespace chainbase {
          if( !env.first || !( *env.first == environment_check()) ) {
             BOOST_THROW_EXCEPTION( std::runtime_error( "database created by a different compiler, build, or operating system" ) );
          }
+
+         auto layout = _segment->find< uint32_t >( "layout_version" );
+         if( !layout.first || *layout.first != layout_version ) {
+            BOOST_THROW_EXCEPTION( std::runtime_error( "database created with a different object layout, it must be rebuilt with --replay-blockchain" ) );
+         }
       } else {
          _segment.reset( new bip::managed_mapped_file( bip::create_only,
                                                        abs_path.generic_string().c_str(), shared_file_size
                                                        ) );
          _segment->find_or_construct< environment_check >( "environment" )();
+         _segment->find_or_construct< uint32_t >( "layout_version" )( layout_version );
       }
 
+      apply_mapping_options();
+
 
       abs_path = bfs::absolute( dir / "shared_memory.meta" );
 
@@ -113,15 +222,205 @@ namespace chainbase {
       }
    }
 
+   database::~database()
+   {
+      stop_background_flush();
+   }
+
    void database::flush() {
+      auto start = boost::chrono::steady_clock::now();
       if( _segment )
          _segment->flush();
       if( _meta )
          _meta->flush();
+      if( _segment )
+         record_flush( start, _segment->get_size(), 0 );
+   }
+
+   void database::start_background_flush( uint64_t chunk_size )
+   {
+      if( _flush_thread )
+         BOOST_THROW_EXCEPTION( std::logic_error( "background flush is already running" ) );
+      if( !_segment || _read_only )
+         BOOST_THROW_EXCEPTION( std::logic_error( "background flush requires a database opened for writing" ) );
+
+      // msync ranges must start on a page boundary
+      const uint64_t page_size = bip::mapped_region::get_page_size();
+      _flush_chunk_size = std::max( page_size, chunk_size - chunk_size % page_size );
+      _flush_requested = false;
+      _flush_stopping = false;
+      _flush_thread.reset( new boost::thread( [this]() { background_flush_loop(); } ) );
+   }
+
+   void database::stop_background_flush()
+   {
+      if( !_flush_thread )
+         return;
+
+      {
+         boost::unique_lock< boost::mutex > lock( _flush_mutex );
+         _flush_stopping = true;
+      }
+      _flush_cv.notify_all();
+      _flush_thread->join();
+      _flush_thread.reset();
+   }
+
+   void database::request_flush()
+   {
+      if( !_flush_thread )
+      {
+         flush();
+         return;
+      }
+
+      {
+         boost::unique_lock< boost::mutex > lock( _flush_mutex );
+         if( _flush_requested || _flush_in_progress )
+            ++_flush_stats.coalesced_requests;
+         _flush_requested = true;
+      }
+      _flush_cv.notify_one();
+   }
+
+   flush_stats database::get_flush_stats()const
+   {
+      boost::unique_lock< boost::mutex > lock( _flush_mutex );
+      return _flush_stats;
+   }
+
+   void database::record_flush( const boost::chrono::steady_clock::time_point& start, uint64_t bytes, uint64_t dirty_bytes )
+   {
+      uint64_t us = boost::chrono::duration_cast< boost::chrono::microseconds >( boost::chrono::steady_clock::now() - start ).count();
+
+      boost::unique_lock< boost::mutex > lock( _flush_mutex );
+      ++_flush_stats.flush_count;
+      _flush_stats.last_flush_us = us;
+      _flush_stats.max_flush_us = std::max( _flush_stats.max_flush_us, us );
+      _flush_stats.total_flush_us += us;
+      _flush_stats.bytes_synced += bytes;
+      _flush_stats.dirty_bytes_before_last_flush = dirty_bytes;
+   }
+
+   void database::background_flush_loop()
+   {
+      // The segment and meta mappings stay valid until close() or wipe(), which stop this thread first
+      char* base = static_cast< char* >( _segment->get_address() );
+      const uint64_t size = _segment->get_size();
+
+      while( true )
+      {
+         {
+            boost::unique_lock< boost::mutex > lock( _flush_mutex );
+            while( !_flush_requested && !_flush_stopping )
+               _flush_cv.wait( lock );
+            if( _flush_stopping )
+               return;
+            _flush_requested = false;
+            _flush_in_progress = true;
+         }
+
+         auto start = boost::chrono::steady_clock::now();
+         uint64_t dirty = get_dirty_bytes();
+         uint64_t synced = 0;
+         bool stopped = false;
+
+         // Clean pages cost nothing to msync, so walking the whole mapping only writes what changed
+         for( uint64_t offset = 0; offset < size; offset += _flush_chunk_size )
+         {
+            uint64_t len = std::min( _flush_chunk_size, size - offset );
+#ifdef __linux__
+            if( ::msync( base + offset, len, MS_SYNC ) != 0 )
+               std::cerr << "chainbase: msync of shared memory file failed: " << strerror( errno ) << "\n";
+#else
+            _segment->flush( offset, len );
+#endif
+            synced += len;
+
+            boost::unique_lock< boost::mutex > lock( _flush_mutex );
+            if( _flush_stopping )
+            {
+               stopped = true;
+               break;
+            }
+         }
+
+         if( !stopped )
+            _meta->flush();
+
+         record_flush( start, synced, dirty );
+
+         {
+            // what was dirty before the flush is not any more
+            boost::unique_lock< boost::mutex > lock( _dirty_bytes_mutex );
+            _dirty_bytes_valid = false;
+         }
+
+         boost::unique_lock< boost::mutex > lock( _flush_mutex );
+         _flush_in_progress = false;
+         if( stopped )
+            return;
+      }
+   }
+
+   uint64_t database::get_dirty_bytes()const
+   {
+      boost::unique_lock< boost::mutex > lock( _dirty_bytes_mutex );
+      auto now = boost::chrono::steady_clock::now();
+      if( !_dirty_bytes_valid || now - _dirty_bytes_time >= boost::chrono::milliseconds( uint32_t( dirty_bytes_ttl_ms ) ) )
+      {
+         _dirty_bytes = read_dirty_bytes();
+         _dirty_bytes_time = now;
+         _dirty_bytes_valid = true;
+      }
+      return _dirty_bytes;
+   }
+
+   uint64_t database::read_dirty_bytes()const
+   {
+#ifdef __linux__
+      if( !_segment )
+         return 0;
+
+      std::ifstream smaps( "/proc/self/smaps" );
+      if( !smaps )
+         return 0;
+
+      const uintptr_t base = reinterpret_cast< uintptr_t >( _segment->get_address() );
+      const uintptr_t end = base + _segment->get_size();
+      bool in_segment = false;
+      uint64_t dirty_kb = 0;
+      std::string line;
+
+      while( std::getline( smaps, line ) )
+      {
+         // Mapping headers start with "start-end", field lines with "Name:"
+         auto dash = line.find( '-' );
+         auto space = line.find( ' ' );
+         if( dash != std::string::npos && space != std::string::npos && dash < space && line[ space - 1 ] != ':' )
+         {
+            uintptr_t vma_start = std::strtoull( line.substr( 0, dash ).c_str(), nullptr, 16 );
+            in_segment = vma_start >= base && vma_start < end;
+            continue;
+         }
+
+         if( in_segment && ( line.compare( 0, 13, "Shared_Dirty:" ) == 0 || line.compare( 0, 14, "Private_Dirty:" ) == 0 ) )
+            dirty_kb += std::strtoull( line.c_str() + line.find( ':' ) + 1, nullptr, 10 );
+      }
+
+      return dirty_kb * 1024;
+#else
+      return 0;
+#endif
    }
 
    void database::close()
    {
+      stop_background_flush();
+      {
+         boost::unique_lock< boost::mutex > lock( _dirty_bytes_mutex );
+         _dirty_bytes_valid = false;
+      }
       _segment.reset();
       _meta.reset();
       _data_dir = bfs::path();
@@ -129,6 +428,7 @@ namespace chainbase {
 
    void database::wipe( const bfs::path& dir )
    {
+      stop_background_flush();
       _segment.reset();
       _meta.reset();
       bfs::remove_all( dir / "shared_memory.bin" );
@@ -37,6 +37,50 @@ namespace fc {
          fc::fwd<impl,96> my;
     };
 
+    /**
+     *  AES-256-GCM for a stream of records under one key.  Each record is encrypted with
+     *  the next nonce from a 64 bit counter, so a key must only ever be used by one
+     *  encoder.  OpenSSL uses AES-NI and carry-less multiplication where the CPU has them.
+     *
+     *  A record is begun with the data it authenticates without encrypting, encoded in
+     *  as many pieces as convenient and ended with its tag.
+     */
+    class aes_gcm_encoder
+    {
+       public:
+         enum { tag_size = 16 };
+
+         aes_gcm_encoder();
+         ~aes_gcm_encoder();
+
+         void     init( const fc::sha256& key );
+         void     begin_record( const char* aad, uint32_t aad_len );
+         uint32_t encode( const char* plaintxt, uint32_t len, char* ciphertxt );
+         void     end_record( char* tag );
+
+       private:
+         struct      impl;
+         fc::fwd<impl,96> my;
+    };
+    class aes_gcm_decoder
+    {
+       public:
+         enum { tag_size = aes_gcm_encoder::tag_size };
+
+         aes_gcm_decoder();
+         ~aes_gcm_decoder();
+
+         void     init( const fc::sha256& key );
+         void     begin_record( const char* aad, uint32_t aad_len );
+         uint32_t decode( const char* ciphertxt, uint32_t len, char* plaintext );
+         /** @throws aes_exception if the record was not encrypted with this key and nonce or was altered */
+         void     end_record( const char* tag );
+
+       private:
+         struct      impl;
+         fc::fwd<impl,96> my;
+    };
+
     unsigned aes_encrypt(unsigned char *plaintext, int plaintext_len, unsigned char *key,
                          unsigned char *iv, unsigned char *ciphertext);
     unsigned aes_decrypt(unsigned char *ciphertext, int ciphertext_len, unsigned char *key,
@@ -40,6 +40,11 @@ namespace fc
          static string   to_string( const variant& v, output_formatting format = stringify_large_ints_and_doubles );
          static string   to_pretty_string( const variant& v, output_formatting format = stringify_large_ints_and_doubles );
 
+         /** Appends the JSON for v to out */
+         static void     append( std::string& out, const variant& v, output_formatting format = stringify_large_ints_and_doubles );
+         /** Appends s to out as a quoted, escaped JSON string */
+         static void     append_escaped( std::string& out, const std::string& s );
+
          static bool     is_valid( const std::string& json_str, parse_type ptype = legacy_parser );
 
          template<typename T>
@@ -0,0 +1,240 @@
+#pragma once
+#include <fc/io/json.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/container/flat_fwd.hpp>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace fc
+{
+   namespace json_writer_detail
+   {
+      struct uses_generic_to_variant {};
+
+      /**
+       *  Competes with the generic reflected to_variant in fc.  A call that sees only
+       *  the two templates is ambiguous; one that finds a better match, i.e. a type's
+       *  own to_variant, resolves to it.
+       */
+      template<typename T>
+      uses_generic_to_variant to_variant( const T&, fc::variant& );
+
+      template<typename T>
+      struct has_custom_to_variant
+      {
+         template<typename U>
+         static auto test( int ) -> decltype( to_variant( std::declval< const U& >(), std::declval< fc::variant& >() ), std::true_type() );
+         template<typename U>
+         static std::false_type test( ... );
+
+         static constexpr bool value = decltype( test< T >( 0 ) )::value;
+      };
+   }
+
+   /**
+    *  Writes JSON straight from C++ values into a string, producing the same text as
+    *  fc::json::to_string( fc::variant( value ) ) without building the variant tree.
+    *
+    *  Containers, optionals and FC_REFLECT'ed structs that rely on the generic
+    *  to_variant are walked directly.  Anything with its own to_variant (asset,
+    *  fixed_string, time_point_sec, hashes, static_variant, ...) is converted to a
+    *  variant one value at a time, so its output is exactly what it always was.
+    */
+   class json_writer
+   {
+      public:
+         explicit json_writer( std::string& out, json::output_formatting format = json::stringify_large_ints_and_doubles )
+         :_out( out ), _format( format ){}
+
+         void raw( char c )                    { _out.push_back( c ); }
+         void raw( const char* s )             { _out.append( s ); }
+         void raw( const std::string& s )      { _out.append( s ); }
+
+         void write( const variant& v )        { json::append( _out, v, _format ); }
+         void write( const std::string& s )    { json::append_escaped( _out, s ); }
+         void write( const std::vector<char>& v ) { write( variant( v ) ); }
+         void write( bool b )                  { raw( b ? "true" : "false" ); }
+
+         template<typename T>
+         void write( const optional<T>& v )
+         {
+            if( v.valid() )
+               write( *v );
+            else
+               raw( "null" );
+         }
+
+         template<typename A, typename B>
+         void write( const std::pair<A,B>& p )
+         {
+            raw( '[' );
+            write( p.first );
+            raw( ',' );
+            write( p.second );
+            raw( ']' );
+         }
+
+         template<typename T>
+         void write( const std::vector<T>& v )           { write_array( v ); }
+         template<typename T>
+         void write( const std::deque<T>& v )            { write_array( v ); }
+         template<typename T>
+         void write( const std::set<T>& v )              { write_array( v ); }
+         template<typename T>
+         void write( const std::unordered_set<T>& v )    { write_array( v ); }
+         template<typename T>
+         void write( const flat_set<T>& v )              { write_array( v ); }
+         template<typename K, typename T>
+         void write( const std::map<K,T>& v )            { write_array( v ); }
+         template<typename K, typename T>
+         void write( const std::multimap<K,T>& v )       { write_array( v ); }
+         template<typename K, typename T>
+         void write( const std::unordered_map<K,T>& v )  { write_array( v ); }
+         template<typename K, typename... T>
+         void write( const flat_map<K,T...>& v )         { write_array( v ); }
+
+         /** string keyed maps are written as objects */
+         template<typename T>
+         void write( const std::map<std::string,T>& v )
+         {
+            raw( '{' );
+            bool first = true;
+            for( const auto& item : v )
+            {
+               if( !first )
+                  raw( ',' );
+               first = false;
+               write( item.first );
+               raw( ':' );
+               write( item.second );
+            }
+            raw( '}' );
+         }
+
+         template<typename T>
+         void write( const T& v )
+         {
+            write_value( v, value_kind< T >() );
+         }
+
+      private:
+         typedef std::integral_constant< int, 0 > variant_kind;
+         typedef std::integral_constant< int, 1 > signed_kind;
+         typedef std::integral_constant< int, 2 > unsigned_kind;
+         typedef std::integral_constant< int, 3 > reflected_kind;
+
+         template<typename T>
+         using value_kind = std::integral_constant< int,
+            ( std::is_integral< T >::value && !std::is_same< T, char >::value ) ? ( std::is_signed< T >::value ? 1 : 2 ) :
+            ( fc::reflector< T >::is_defined::value && !fc::reflector< T >::is_enum::value &&
+              !json_writer_detail::has_custom_to_variant< T >::value ) ? 3 : 0 >;
+
+         template<typename T>
+         void write_value( const T& v, variant_kind )
+         {
+            write( variant( v ) );
+         }
+
+         template<typename T>
+         void write_value( const T& v, signed_kind )
+         {
+            const int64_t i = v;
+            if( _format == json::stringify_large_ints_and_doubles && i > 0xffffffff )
+            {
+               raw( '"' );
+               raw( std::to_string( i ) );
+               raw( '"' );
+            }
+            else
+               raw( std::to_string( i ) );
+         }
+
+         template<typename T>
+         void write_value( const T& v, unsigned_kind )
+         {
+            const uint64_t i = v;
+            if( _format == json::stringify_large_ints_and_doubles && i > 0xffffffff )
+            {
+               raw( '"' );
+               raw( std::to_string( i ) );
+               raw( '"' );
+            }
+            else
+               raw( std::to_string( i ) );
+         }
+
+         template<typename T>
+         class member_visitor
+         {
+            public:
+               member_visitor( json_writer& w, const T& v, bool& first )
+               :_writer( w ), _val( v ), _first( first ){}
+
+               template<typename Member, class Class, Member (Class::*member)>
+               void operator()( const char* name )const
+               {
+                  add( name, _val.*member );
+               }
+
+            private:
+               template<typename M>
+               void add( const char* name, const optional<M>& v )const
+               {
+                  if( v.valid() )
+                     add( name, *v );
+               }
+               template<typename M>
+               void add( const char* name, const M& v )const
+               {
+                  if( !_first )
+                     _writer.raw( ',' );
+                  _first = false;
+                  // member names are identifiers and never need escaping
+                  _writer.raw( '"' );
+                  _writer.raw( name );
+                  _writer.raw( "\":" );
+                  _writer.write( v );
+               }
+
+               json_writer&   _writer;
+               const T&       _val;
+               bool&          _first;
+         };
+
+         template<typename T>
+         void write_value( const T& v, reflected_kind )
+         {
+            bool first = true;
+            raw( '{' );
+            fc::reflector< T >::visit( member_visitor< T >( *this, v, first ) );
+            raw( '}' );
+         }
+
+         template<typename Container>
+         void write_array( const Container& c )
+         {
+            raw( '[' );
+            bool first = true;
+            for( const auto& item : c )
+            {
+               if( !first )
+                  raw( ',' );
+               first = false;
+               write( item );
+            }
+            raw( ']' );
+         }
+
+         std::string&               _out;
+         json::output_formatting    _format;
+   };
+
+} // fc
@@ -38,12 +38,16 @@ namespace fc
             {
                config()
                :format( "${timestamp} ${thread_name} ${context} ${file}:${line} ${method} ${level}]  ${message}" ),
-                stream(console_appender::stream::std_error),flush(true){}
+                stream(console_appender::stream::std_error),flush(true),async(false),async_queue_size(8192){}
 
                fc::string                         format;
                console_appender::stream::type     stream;
                std::vector<level_color>           level_colors;
                bool                               flush;
+               /// Format and print messages on a background thread instead of the logging one
+               bool                               async;
+               /// Messages an async appender holds before it drops new ones
+               uint32_t                           async_queue_size;
             };
 
 
@@ -59,7 +63,14 @@ namespace fc
 
             void configure( const config& cfg );
 
+            /// Messages an async appender dropped because its queue was full
+            uint64_t dropped_messages()const;
+
        private:
+            /// Formats and prints one message without the trailing newline or flush
+            void print_line( const log_message& m );
+            void print_text( const std::string& text, color::type text_color );
+
             class impl;
             std::unique_ptr<impl> my;
    };
@@ -69,4 +80,4 @@ namespace fc
 FC_REFLECT_ENUM( fc::console_appender::stream::type, (std_out)(std_error) )
 FC_REFLECT_ENUM( fc::console_appender::color::type, (red)(green)(brown)(blue)(magenta)(cyan)(white)(console_default) )
 FC_REFLECT( fc::console_appender::level_color, (level)(color) )
-FC_REFLECT( fc::console_appender::config, (format)(stream)(level_colors)(flush) )
+FC_REFLECT( fc::console_appender::config, (format)(stream)(level_colors)(flush)(async)(async_queue_size) )
@@ -18,11 +18,18 @@ class file_appender : public appender {
             bool                               rotate = false;
             microseconds                       rotation_interval;
             microseconds                       rotation_limit;
+            /// Format and write messages on a background thread instead of the logging one
+            bool                               async = false;
+            /// Messages an async appender holds before it drops new ones
+            uint32_t                           async_queue_size = 8192;
          };
          file_appender( const variant& args );
          ~file_appender();
          virtual void log( const log_message& m )override;
 
+         /// Messages an async appender dropped because its queue was full
+         uint64_t dropped_messages()const;
+
       private:
          class impl;
          fc::shared_ptr<impl> my;
@@ -31,4 +38,4 @@ class file_appender : public appender {
 
 #include <fc/reflect/reflect.hpp>
 FC_REFLECT( fc::file_appender::config,
-            (format)(filename)(flush)(rotate)(rotation_interval)(rotation_limit) )
+            (format)(filename)(flush)(rotate)(rotation_interval)(rotation_limit)(async)(async_queue_size) )
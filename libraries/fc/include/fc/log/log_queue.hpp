@@ -0,0 +1,66 @@
+#pragma once
+#include <fc/log/log_message.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fc {
+
+   /**
+    *  Hands log messages from the threads that log them to one background thread that
+    *  formats and writes them, so that logging never waits on a file or console.
+    *
+    *  Messages go through a bounded ring buffer that producers enter without a lock.
+    *  When it is full the message is dropped and counted; the writer is told how many
+    *  were dropped since its last batch so it can say so in the log.
+    *
+    *  The writer gets every message queued since its last call in one batch.  It runs
+    *  on the background thread only, and the destructor writes what is still queued.
+    */
+   class log_queue
+   {
+      public:
+         typedef std::function< void( const std::vector< log_message >& batch, uint64_t dropped ) > writer;
+
+         /** @param capacity is rounded up to a power of two */
+         log_queue( uint32_t capacity, writer w );
+         ~log_queue();
+
+         /** @return false if the queue was full and the message dropped */
+         bool push( const log_message& m );
+
+         /// Messages dropped since the queue was created
+         uint64_t dropped()const { return _dropped.load( std::memory_order_relaxed ); }
+
+      private:
+         struct cell
+         {
+            std::atomic< uint64_t >    sequence;
+            log_message                message;
+         };
+
+         bool pop( log_message& m );
+         bool empty()const;
+         void run();
+
+         std::unique_ptr< cell[] >  _cells;
+         uint64_t                   _mask;
+         std::atomic< uint64_t >    _enqueue_pos;
+         uint64_t                   _dequeue_pos = 0;
+
+         std::atomic< uint64_t >    _dropped;
+         std::atomic< bool >        _waiting;
+         bool                       _stopping = false;
+         std::mutex                 _mutex;
+         std::condition_variable    _wake;
+
+         writer                     _writer;
+         std::thread                _thread;
+   };
+
+} // namespace fc
@@ -8,6 +8,7 @@
 
 namespace fc { namespace http {
    namespace detail {
+      class message_worker_pool;
       class websocket_server_impl;
       class websocket_tls_server_impl;
       class websocket_client_impl;
@@ -38,6 +39,25 @@ namespace fc { namespace http {
    typedef std::shared_ptr<websocket_connection> websocket_connection_ptr;
 
    typedef std::function<void(const websocket_connection_ptr&)> on_connection_handler;
+   typedef std::function<std::string(const std::string&)>       on_http_handler;
+
+   /**
+    *  Counters for the message worker pool of a websocket server.  All zero when
+    *  the server handles messages on its own thread.
+    */
+   struct websocket_server_stats
+   {
+      uint32_t    worker_threads = 0;
+      uint32_t    max_pending_per_connection = 0;
+      /// Messages waiting for a worker, over all connections
+      uint64_t    queued_messages = 0;
+      /// Deepest any single connection queue has been
+      uint64_t    max_queue_depth = 0;
+      uint64_t    processed_messages = 0;
+      uint64_t    http_requests = 0;
+      /// Times a connection had to wait for room in its queue
+      uint64_t    backpressure_waits = 0;
+   };
 
    class websocket_server
    {
@@ -46,6 +66,30 @@ namespace fc { namespace http {
          ~websocket_server();
 
          void on_connection( const on_connection_handler& handler);
+         /**
+          *  Serves plain HTTP requests with this handler instead of passing a new
+          *  connection per request to the on_connection handler.
+          */
+         void on_http( const on_http_handler& handler );
+
+         /**
+          *  Handles messages on a pool of threads instead of the server thread.  A
+          *  connection is served by one worker at a time, in the order its messages
+          *  arrived, and reading from it stalls while max_pending_per_connection of
+          *  its messages are queued.  Must be called before start_accept().
+          */
+         void set_worker_pool( uint32_t threads, uint32_t max_pending_per_connection );
+
+         /**
+          *  Compresses websocket messages and HTTP responses of at least min_size bytes;
+          *  0 disables compression.  Websocket messages are deflated when the client
+          *  negotiated permessage-deflate, HTTP responses are gzipped when the request
+          *  accepts it.  level is the zlib level of the gzip responses; the websocket
+          *  extension always uses zlib's default.  Must be called before start_accept().
+          */
+         void set_compression( uint32_t min_size, int level );
+         websocket_server_stats get_stats()const;
+
          void listen( uint16_t port );
          void listen( const fc::ip::endpoint& ep );
          void start_accept();
@@ -64,6 +108,13 @@ namespace fc { namespace http {
          ~websocket_tls_server();
 
          void on_connection( const on_connection_handler& handler);
+         /// @see websocket_server::on_http
+         void on_http( const on_http_handler& handler );
+         /// @see websocket_server::set_worker_pool
+         void set_worker_pool( uint32_t threads, uint32_t max_pending_per_connection );
+         /// @see websocket_server::set_compression
+         void set_compression( uint32_t min_size, int level );
+         websocket_server_stats get_stats()const;
          void listen( uint16_t port );
          void listen( const fc::ip::endpoint& ep );
          void start_accept();
@@ -3,7 +3,9 @@
 #include <fc/optional.hpp>
 #include <fc/api.hpp>
 #include <fc/any.hpp>
+#include <fc/io/json_writer.hpp>
 #include <memory>
+#include <typeinfo>
 #include <vector>
 #include <functional>
 #include <utility>
@@ -116,6 +118,14 @@ namespace fc {
             return _methods[method_id](args);
          }
 
+         /** Same as call, but returns the result as JSON written straight from the C++ return value */
+         std::string call_json( const string& name, const variants& args )
+         {
+            auto itr = _by_name.find(name);
+            FC_ASSERT( itr != _by_name.end(), "no method with name '${name}'", ("name",name)("api",_by_name) );
+            return _json_methods[itr->second](args);
+         }
+
          std::weak_ptr< fc::api_connection > get_connection()
          {
             return _api_connection;
@@ -132,6 +142,9 @@ namespace fc {
       private:
          friend struct api_visitor;
 
+         /// throws when the connection has no way to deliver a callback argument
+         void check_callbacks_enabled();
+
          template<typename R, typename Arg0, typename ... Args>
          std::function<R(Args...)> bind_first_arg( const std::function<R(Arg0,Args...)>& f, Arg0 a0 )const
          {
@@ -148,6 +161,7 @@ namespace fc {
          R call_generic( const std::function<R(std::function<Signature>,Args...)>& f, variants::const_iterator a0, variants::const_iterator e )
          {
             FC_ASSERT( a0 != e, "too few arguments passed to method" );
+            check_callbacks_enabled();
             detail::callback_functor<Signature> arg0( get_connection(), a0->as<uint64_t>() );
             return  call_generic<R,Args...>( this->bind_first_arg<R,std::function<Signature>,Args...>( f, std::function<Signature>(arg0) ), a0+1, e );
          }
@@ -155,6 +169,7 @@ namespace fc {
          R call_generic( const std::function<R(const std::function<Signature>&,Args...)>& f, variants::const_iterator a0, variants::const_iterator e )
          {
             FC_ASSERT( a0 != e, "too few arguments passed to method" );
+            check_callbacks_enabled();
             detail::callback_functor<Signature> arg0( get_connection(), a0->as<uint64_t>() );
             return  call_generic<R,Args...>( this->bind_first_arg<R,const std::function<Signature>&,Args...>( f, arg0 ), a0+1, e );
          }
@@ -185,9 +200,32 @@ namespace fc {
             template<typename ... Args>
             std::function<variant(const fc::variants&)> to_generic( const std::function<void(Args...)>& f )const;
 
+            /// Results that are APIs or nothing go through the variant form of the method
+            template<typename Interface, typename Adaptor, typename ... Args>
+            std::function<std::string(const fc::variants&)> to_generic_json( const std::function<api<Interface,Adaptor>(Args...)>& f )const;
+
+            template<typename Interface, typename Adaptor, typename ... Args>
+            std::function<std::string(const fc::variants&)> to_generic_json( const std::function<fc::optional<api<Interface,Adaptor>>(Args...)>& f )const;
+
+            template<typename ... Args>
+            std::function<std::string(const fc::variants&)> to_generic_json( const std::function<fc::api_ptr(Args...)>& f )const;
+
+            template<typename R, typename ... Args>
+            std::function<std::string(const fc::variants&)> to_generic_json( const std::function<R(Args...)>& f )const;
+
+            template<typename ... Args>
+            std::function<std::string(const fc::variants&)> to_generic_json( const std::function<void(Args...)>& f )const;
+
+            std::function<std::string(const fc::variants&)> variant_to_json()const
+            {
+               auto m = _api._methods.back();
+               return [m]( const variants& args ) { return fc::json::to_string( m( args ) ); };
+            }
+
             template<typename Result, typename... Args>
             void operator()( const char* name, std::function<Result(Args...)>& memb )const {
                _api._methods.emplace_back( to_generic( memb ) );
+               _api._json_methods.emplace_back( to_generic_json( memb ) );
                _api._by_name[name] = _api._methods.size() - 1;
             }
 
@@ -200,6 +238,7 @@ namespace fc {
          fc::any                                                 _api;
          std::map< std::string, uint32_t >                       _by_name;
          std::vector< std::function<variant(const variants&)> >  _methods;
+         std::vector< std::function<std::string(const variants&)> > _json_methods;
    }; // class generic_api
 
 
@@ -229,6 +268,12 @@ namespace fc {
             FC_ASSERT( _local_apis.size() > api_id );
             return _local_apis[api_id]->call( method_name, args );
          }
+         /** @return the result of a local call serialized as JSON */
+         std::string receive_call_json( api_id_type api_id, const string& method_name, const variants& args = variants() )const
+         {
+            FC_ASSERT( _local_apis.size() > api_id );
+            return _local_apis[api_id]->call_json( method_name, args );
+         }
          variant receive_callback( uint64_t callback_id,  const variants& args = variants() )const
          {
             FC_ASSERT( _local_callbacks.size() > callback_id );
@@ -261,8 +306,13 @@ namespace fc {
 
          std::vector<std::string> get_method_names( api_id_type local_api_id = 0 )const { return _local_apis[local_api_id]->get_method_names(); }
 
+         /** Connections that cannot send anything back, such as plain HTTP, reject methods taking a callback */
+         void set_callbacks_enabled( bool enabled ) { _callbacks_enabled = enabled; }
+         bool callbacks_enabled()const { return _callbacks_enabled; }
+
          fc::signal<void()> closed;
       private:
+         bool                                                    _callbacks_enabled = true;
          std::vector< std::unique_ptr<generic_api> >             _local_apis;
          std::map< uint64_t, api_id_type >                       _handle_to_id;
          std::vector< std::function<variant(const variants&)>  > _local_callbacks;
@@ -372,6 +422,13 @@ namespace fc {
          std::shared_ptr<fc::api_connection>    _remote_connection;
    };
 
+   inline void generic_api::check_callbacks_enabled()
+   {
+      auto con = _api_connection.lock();
+      FC_ASSERT( con, "not connected" );
+      FC_ASSERT( con->callbacks_enabled(), "This method takes a callback, which needs a websocket connection" );
+   }
+
    template<typename Api>
    generic_api::generic_api( const Api& a, const std::shared_ptr<fc::api_connection>& c )
    :_api_connection(c),_api(a)
@@ -446,6 +503,48 @@ namespace fc {
       };
    }
 
+   template<typename Interface, typename Adaptor, typename ... Args>
+   std::function<std::string(const fc::variants&)> generic_api::api_visitor::to_generic_json(
+                                               const std::function<fc::api<Interface,Adaptor>(Args...)>& f )const
+   {
+      return variant_to_json();
+   }
+   template<typename Interface, typename Adaptor, typename ... Args>
+   std::function<std::string(const fc::variants&)> generic_api::api_visitor::to_generic_json(
+                                               const std::function<fc::optional<fc::api<Interface,Adaptor>>(Args...)>& f )const
+   {
+      return variant_to_json();
+   }
+   template<typename ... Args>
+   std::function<std::string(const fc::variants&)> generic_api::api_visitor::to_generic_json(
+                                               const std::function<fc::api_ptr(Args...)>& f )const
+   {
+      return variant_to_json();
+   }
+   template<typename ... Args>
+   std::function<std::string(const fc::variants&)> generic_api::api_visitor::to_generic_json( const std::function<void(Args...)>& f )const
+   {
+      return variant_to_json();
+   }
+
+   template<typename R, typename ... Args>
+   std::function<std::string(const fc::variants&)> generic_api::api_visitor::to_generic_json( const std::function<R(Args...)>& f )const
+   {
+      generic_api* gapi = &_api;
+      return [f,gapi]( const variants& args ) {
+         std::string result;
+         fc::json_writer writer( result );
+         auto r = gapi->call_generic( f, args.begin(), args.end() );
+         writer.write( r );
+#ifndef NDEBUG
+         // clients see the same text as the variant route; a type whose own to_variant is missed would differ
+         FC_ASSERT( result == fc::json::to_string( fc::variant( r ) ),
+                    "JSON written for ${type} differs from its variant", ("type", typeid( R ).name()) );
+#endif
+         return result;
+      };
+   }
+
    /**
     * It is slightly unclean tight coupling to have this method in the api class.
     * It breaks encapsulation by requiring an api class method to have a pointer
@@ -0,0 +1,50 @@
+#pragma once
+#include <fc/rpc/state.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <string>
+#include <unordered_map>
+
+namespace fc { namespace rpc {
+
+   /**
+    *  Logs a sample of the RPC requests a server handles, and every call slower than
+    *  the configured thresholds.
+    *
+    *  Sampled requests go to the "rpc" logger at info level with the method, its
+    *  parameters, the execution time and whether it succeeded.  Nothing is formatted
+    *  unless that logger is enabled and the request is picked, so a server that does
+    *  not sample pays one time measurement per request.
+    *
+    *  Methods are named "api.method" for "call" requests, where api is the name or id
+    *  given by the client, and by the request method otherwise.
+    *
+    *  Configure before the log is shared with any connection; it is read concurrently
+    *  by the RPC workers and is not synchronized.
+    */
+   class request_log
+   {
+      public:
+         request_log();
+
+         /// Fraction of requests logged, from 0 to 1, for methods with no rate of their own
+         void set_sample_rate( double rate );
+         void set_method_sample_rate( const std::string& method, double rate );
+
+         /// Calls taking longer are logged as warnings, resp. errors, to the default logger; 0 disables
+         void set_slow_call_thresholds( const microseconds& warn, const microseconds& error );
+
+         void record( const request& call, const microseconds& elapsed, bool ok )const;
+
+      private:
+         bool sample( const request& call )const;
+
+         mutable logger                            _logger;
+         double                                    _sample_rate = 0;
+         std::unordered_map< std::string, double > _method_sample_rates;
+         microseconds                              _slow_call_warn;
+         microseconds                              _slow_call_error;
+   };
+
+} } // namespace fc::rpc
@@ -1,8 +1,10 @@
 #pragma once
 #include <fc/rpc/api_connection.hpp>
+#include <fc/rpc/request_log.hpp>
 #include <fc/rpc/state.hpp>
 #include <fc/network/http/websocket.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/json_writer.hpp>
 #include <fc/reflect/variant.hpp>
 
 namespace fc { namespace rpc {
@@ -10,9 +12,24 @@ namespace fc { namespace rpc {
    class websocket_api_connection : public api_connection
    {
       public:
+         /**
+          *  Runs a local API call.  The dispatcher is given the api id and method name so that
+          *  it may choose the thread the call runs on and measure it; it must invoke call, which
+          *  stores the result itself.
+          */
+         typedef std::function< void( api_id_type api_id, const std::string& method_name, const std::function< void() >& call ) > call_dispatcher;
+
          websocket_api_connection( fc::http::websocket_connection& c );
          ~websocket_api_connection();
 
+         void set_call_dispatcher( const call_dispatcher& d ) { _dispatcher = d; }
+
+         /// Largest JSON-RPC batch (array of requests) accepted in one message, 0 disables batches
+         void set_max_batch_size( uint32_t s ) { _max_batch_size = s; }
+
+         /// Sampled request and slow call log, may be shared by many connections; none disables it
+         void set_request_log( const std::shared_ptr< const request_log >& l ) { _request_log = l; }
+
          virtual variant send_call(
             api_id_type api_id,
             string method_name,
@@ -29,8 +46,22 @@ namespace fc { namespace rpc {
             const std::string& message,
             bool send_message = true );
 
+         api_id_type resolve_api_id( const variant& api );
+         variant dispatch_call( api_id_type api_id, const std::string& method_name, const variants& args );
+         /** Runs the arguments of a "call" request and returns the result as JSON */
+         std::string dispatch_call_json( const variants& args );
+
+         /** @return the serialized reply, or nothing for a notification */
+         optional< std::string > handle_call( const fc::rpc::request& call );
+         std::string on_batch( const variants& batch, bool send_message );
+         /** A JSON-RPC error reply for a request that could not be run; id is null when it could not be read */
+         static std::string error_reply( const variant& id, int64_t code, const std::string& message, const fc::exception& e );
+
          fc::http::websocket_connection&  _connection;
          fc::rpc::state                   _rpc_state;
+         call_dispatcher                  _dispatcher;
+         uint32_t                         _max_batch_size = 100;
+         std::shared_ptr< const request_log > _request_log;
    };
 
 } } // namespace fc::rpc
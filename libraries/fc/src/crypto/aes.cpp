@@ -172,6 +172,153 @@ uint32_t aes_decoder::final_decode( char* plaintext )
 
 
 
+struct aes_gcm_encoder::impl
+{
+   evp_cipher_ctx ctx;
+   uint64_t       records = 0;
+};
+
+// 96 bit nonce: four zero bytes then the record counter
+static void aes_gcm_nonce( uint64_t counter, unsigned char* nonce )
+{
+    memset( nonce, 0, 12 );
+    for( int i = 0; i < 8; ++i )
+        nonce[4 + i] = (unsigned char)( counter >> ( 8 * i ) );
+}
+
+aes_gcm_encoder::aes_gcm_encoder()
+{
+  static int init = init_openssl();
+  FC_UNUSED(init);
+}
+
+aes_gcm_encoder::~aes_gcm_encoder()
+{
+}
+
+void aes_gcm_encoder::init( const fc::sha256& key )
+{
+    my->ctx.obj = EVP_CIPHER_CTX_new();
+    if(!my->ctx)
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error allocating evp cipher context",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    if(1 != EVP_EncryptInit_ex(my->ctx, EVP_aes_256_gcm(), NULL, (unsigned char*)&key, NULL))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm encryption init",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    my->records = 0;
+}
+
+void aes_gcm_encoder::begin_record( const char* aad, uint32_t aad_len )
+{
+    unsigned char nonce[12];
+    aes_gcm_nonce( my->records++, nonce );
+    int len = 0;
+    if(1 != EVP_EncryptInit_ex(my->ctx, NULL, NULL, NULL, nonce) ||
+       (aad_len && 1 != EVP_EncryptUpdate(my->ctx, NULL, &len, (const unsigned char*)aad, aad_len)))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error starting aes 256 gcm record",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+}
+
+uint32_t aes_gcm_encoder::encode( const char* plaintxt, uint32_t plaintext_len, char* ciphertxt )
+{
+    int ciphertext_len = 0;
+    if(1 != EVP_EncryptUpdate(my->ctx, (unsigned char*)ciphertxt, &ciphertext_len, (const unsigned char*)plaintxt, plaintext_len))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm encryption update",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    FC_ASSERT( static_cast<uint32_t>(ciphertext_len) == plaintext_len, "", ("ciphertext_len",ciphertext_len)("plaintext_len",plaintext_len) );
+    return ciphertext_len;
+}
+
+void aes_gcm_encoder::end_record( char* tag )
+{
+    unsigned char unused[16];
+    int len = 0;
+    if(1 != EVP_EncryptFinal_ex(my->ctx, unused, &len) ||
+       1 != EVP_CIPHER_CTX_ctrl(my->ctx, EVP_CTRL_GCM_GET_TAG, tag_size, tag))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error finishing aes 256 gcm record",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+}
+
+
+struct aes_gcm_decoder::impl
+{
+   evp_cipher_ctx ctx;
+   uint64_t       records = 0;
+};
+
+aes_gcm_decoder::aes_gcm_decoder()
+{
+  static int init = init_openssl();
+  FC_UNUSED(init);
+}
+
+aes_gcm_decoder::~aes_gcm_decoder()
+{
+}
+
+void aes_gcm_decoder::init( const fc::sha256& key )
+{
+    my->ctx.obj = EVP_CIPHER_CTX_new();
+    if(!my->ctx)
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error allocating evp cipher context",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    if(1 != EVP_DecryptInit_ex(my->ctx, EVP_aes_256_gcm(), NULL, (unsigned char*)&key, NULL))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm decryption init",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    my->records = 0;
+}
+
+void aes_gcm_decoder::begin_record( const char* aad, uint32_t aad_len )
+{
+    unsigned char nonce[12];
+    aes_gcm_nonce( my->records++, nonce );
+    int len = 0;
+    if(1 != EVP_DecryptInit_ex(my->ctx, NULL, NULL, NULL, nonce) ||
+       (aad_len && 1 != EVP_DecryptUpdate(my->ctx, NULL, &len, (const unsigned char*)aad, aad_len)))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error starting aes 256 gcm record",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+}
+
+uint32_t aes_gcm_decoder::decode( const char* ciphertxt, uint32_t ciphertxt_len, char* plaintext )
+{
+    int plaintext_len = 0;
+    if(1 != EVP_DecryptUpdate(my->ctx, (unsigned char*)plaintext, &plaintext_len, (const unsigned char*)ciphertxt, ciphertxt_len))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm decryption update",
+                           ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+    }
+    FC_ASSERT( ciphertxt_len == static_cast<uint32_t>(plaintext_len), "", ("ciphertxt_len",ciphertxt_len)("plaintext_len",plaintext_len) );
+    return plaintext_len;
+}
+
+void aes_gcm_decoder::end_record( const char* tag )
+{
+    unsigned char unused[16];
+    int len = 0;
+    if(1 != EVP_CIPHER_CTX_ctrl(my->ctx, EVP_CTRL_GCM_SET_TAG, tag_size, (void*)tag) ||
+       1 != EVP_DecryptFinal_ex(my->ctx, unused, &len))
+    {
+        FC_THROW_EXCEPTION( aes_exception, "aes 256 gcm record failed authentication" );
+    }
+}
+
+
 /** example method from wiki.opensslfoundation.com */
 unsigned aes_encrypt(unsigned char *plaintext, int plaintext_len, unsigned char *key,
                      unsigned char *iv, unsigned char *ciphertext)
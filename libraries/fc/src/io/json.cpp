@@ -14,10 +14,66 @@
 
 namespace fc
 {
+    /**
+     *  Reads JSON straight out of a string buffer.  Has the peek/get interface of
+     *  the stream types the parsers are templated on, without the virtual calls and
+     *  std::stringstream underneath fc::stringstream.
+     */
+    class json_string_reader
+    {
+       public:
+          json_string_reader( const char* begin, const char* end ) : _pos( begin ), _end( end ) {}
+
+          char peek()const
+          {
+             if( _pos == _end )
+                FC_THROW_EXCEPTION( eof_exception, "json_string_reader" );
+             return *_pos;
+          }
+          char get()
+          {
+             if( _pos == _end )
+                FC_THROW_EXCEPTION( eof_exception, "json_string_reader" );
+             return *_pos++;
+          }
+
+          /** Consumes the characters up to the next '"', '\\', ^D or the end of the buffer, and returns their end */
+          const char* skip_plain_string( const char*& run_begin )
+          {
+             run_begin = _pos;
+             while( _pos != _end && *_pos != '"' && *_pos != '\\' && *_pos != 0x04 )
+                ++_pos;
+             return _pos;
+          }
+
+       private:
+          const char* _pos;
+          const char* _end;
+    };
+
+    /** Appends JSON to a std::string; the writer behind json::to_string */
+    class json_string_writer
+    {
+       public:
+          explicit json_string_writer( std::string& out ) : _out( out ) {}
+
+          json_string_writer& operator<<( char c )                 { _out.push_back( c ); return *this; }
+          json_string_writer& operator<<( const char* s )          { _out.append( s ); return *this; }
+          json_string_writer& operator<<( const std::string& s )   { _out.append( s ); return *this; }
+          json_string_writer& operator<<( int64_t i )              { _out.append( std::to_string( i ) ); return *this; }
+          json_string_writer& operator<<( uint64_t i )             { _out.append( std::to_string( i ) ); return *this; }
+
+          void write( const char* s, size_t len )                  { _out.append( s, len ); }
+
+       private:
+          std::string& _out;
+    };
+
     // forward declarations of provided functions
     template<typename T, json::parse_type parser_type> variant variant_from_stream( T& in );
     template<typename T> char parseEscape( T& in );
     template<typename T> fc::string stringFromStream( T& in );
+    fc::string stringFromStream( json_string_reader& in );
     template<typename T> bool skip_white_space( T& in );
     template<typename T> fc::string stringFromToken( T& in );
     template<typename T, json::parse_type parser_type> variant_object objectFromStream( T& in );
@@ -25,6 +81,7 @@ namespace fc
     template<typename T, json::parse_type parser_type> variant number_from_stream( T& in );
     template<typename T> variant token_from_stream( T& in );
     void escape_string( const string& str, ostream& os );
+    void escape_string( const string& str, json_string_writer& os );
     template<typename T> void to_stream( T& os, const variants& a, json::output_formatting format );
     template<typename T> void to_stream( T& os, const variant_object& o, json::output_formatting format );
     template<typename T> void to_stream( T& os, const variant& v, json::output_formatting format );
@@ -88,7 +145,7 @@ namespace fc
    template<typename T>
    fc::string stringFromStream( T& in )
    {
-      fc::stringstream token;
+      fc::string token;
       try
       {
          char c = in.peek();
@@ -104,23 +161,59 @@ namespace fc
             switch( c = in.peek() )
             {
                case '\\':
-                  token << parseEscape( in );
+                  token.push_back( parseEscape( in ) );
                   break;
                case 0x04:
                   FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"' in string '${token}'",
-                                                   ("token", token.str() ) );
+                                                   ("token", token ) );
                case '"':
                   in.get();
-                  return token.str();
+                  return token;
                default:
-                  token << c;
+                  token.push_back( c );
                   in.get();
             }
          }
          FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"' in string '${token}'",
-                                          ("token", token.str() ) );
+                                          ("token", token ) );
        } FC_RETHROW_EXCEPTIONS( warn, "while parsing token '${token}'",
-                                          ("token", token.str() ) );
+                                          ("token", token ) );
+   }
+
+   /** Same as the generic version, but copies each run of unescaped characters at once */
+   fc::string stringFromStream( json_string_reader& in )
+   {
+      fc::string token;
+      try
+      {
+         char c = in.peek();
+
+         if( c != '"' )
+            FC_THROW_EXCEPTION( parse_error_exception,
+                                            "Expected '\"' but read '${char}'",
+                                            ("char", string(&c, (&c) + 1) ) );
+         in.get();
+         while( true )
+         {
+            const char* run_begin;
+            const char* run_end = in.skip_plain_string( run_begin );
+            token.append( run_begin, run_end );
+
+            switch( c = in.peek() )
+            {
+               case '\\':
+                  token.push_back( parseEscape( in ) );
+                  break;
+               case 0x04:
+                  FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"' in string '${token}'",
+                                                   ("token", token ) );
+               case '"':
+                  in.get();
+                  return token;
+            }
+         }
+       } FC_RETHROW_EXCEPTIONS( warn, "while parsing token '${token}'",
+                                          ("token", token ) );
    }
    template<typename T>
    fc::string stringFromToken( T& in )
@@ -204,7 +297,7 @@ namespace fc
          if( in.peek() == '}' )
          {
             in.get();
-            return obj;
+            return variant_object( std::move( obj ) );
          }
          FC_THROW_EXCEPTION( parse_error_exception, "Expected '}' after ${variant}", ("variant", obj ) );
       }
@@ -253,14 +346,14 @@ namespace fc
    template<typename T, json::parse_type parser_type>
    variant number_from_stream( T& in )
    {
-      fc::stringstream ss;
+      fc::string ss;
 
       bool  dot = false;
       bool  neg = false;
       if( in.peek() == '-')
       {
         neg = true;
-        ss.put( in.get() );
+        ss.push_back( in.get() );
       }
       bool done = false;
 
@@ -286,12 +379,12 @@ namespace fc
               case '7':
               case '8':
               case '9':
-                 ss.put( in.get() );
+                 ss.push_back( in.get() );
                  break;
               default:
                  if( isalnum( c ) )
                  {
-                    return ss.str() + stringFromToken( in );
+                    return ss + stringFromToken( in );
                  }
                 done = true;
                 break;
@@ -304,7 +397,7 @@ namespace fc
       catch (const std::ios_base::failure&)
       {
       }
-      fc::string str = ss.str();
+      const fc::string& str = ss;
       if (str == "-." || str == ".") // check the obviously wrong things we could have encountered
         FC_THROW_EXCEPTION(parse_error_exception, "Can't parse token \"${token}\" as a JSON numeric constant", ("token", str));
       if( dot )
@@ -461,18 +554,17 @@ namespace fc
    { try {
       check_string_depth( utf8_str );
 
-      fc::stringstream in( utf8_str );
-      //in.exceptions( std::ifstream::eofbit );
+      json_string_reader in( utf8_str.data(), utf8_str.data() + utf8_str.size() );
       switch( ptype )
       {
           case legacy_parser:
-              return variant_from_stream<fc::stringstream, legacy_parser>( in );
+              return variant_from_stream<json_string_reader, legacy_parser>( in );
           case legacy_parser_with_string_doubles:
-              return variant_from_stream<fc::stringstream, legacy_parser_with_string_doubles>( in );
+              return variant_from_stream<json_string_reader, legacy_parser_with_string_doubles>( in );
           case strict_parser:
-              return json_relaxed::variant_from_stream<fc::stringstream, true>( in );
+              return json_relaxed::variant_from_stream<json_string_reader, true>( in );
           case relaxed_parser:
-              return json_relaxed::variant_from_stream<fc::stringstream, false>( in );
+              return json_relaxed::variant_from_stream<json_string_reader, false>( in );
           default:
               FC_ASSERT( false, "Unknown JSON parser type {ptype}", ("ptype", ptype) );
       }
@@ -482,13 +574,12 @@ namespace fc
    { try {
       check_string_depth( utf8_str );
       variants result;
-      fc::stringstream in( utf8_str );
-      //in.exceptions( std::ifstream::eofbit );
+      json_string_reader in( utf8_str.data(), utf8_str.data() + utf8_str.size() );
       try {
          while( true )
          {
            // result.push_back( variant_from_stream( in ));
-           result.push_back(json_relaxed::variant_from_stream<fc::stringstream, false>( in ));
+           result.push_back(json_relaxed::variant_from_stream<json_string_reader, false>( in ));
          }
       } catch ( const fc::eof_exception& ){}
       return result;
@@ -507,77 +598,57 @@ namespace fc
    */
 
    /**
-    *  Convert '\t', '\a', '\n', '\\' and '"'  to "\t\a\n\\\""
+    *  @return the JSON escape sequence for c, or nullptr if c is printed as is.
     *
-    *  All other characters are printed as UTF8.
+    *  '\b', '\f', '\n', '\r', '\t', '\\' and '"' get their short escapes and the other
+    *  control characters a \u escape.  All other characters are printed as UTF8.
     */
+   static const char* json_escape_sequence( char c )
+   {
+      static const char* const control[0x20] = {
+         "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007", // \a is not valid JSON
+         "\\b",     "\\t",     "\\n",     "\\u000b", "\\f",     "\\r",     "\\u000e", "\\u000f",
+         "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+         "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f"
+      };
+      if( static_cast< unsigned char >( c ) < 0x20 )
+         return control[ static_cast< unsigned char >( c ) ];
+      if( c == '\\' )
+         return "\\\\";
+      if( c == '"' )
+         return "\\\"";
+      return nullptr;
+   }
+
    void escape_string( const string& str, ostream& os )
    {
       os << '"';
       for( auto itr = str.begin(); itr != str.end(); ++itr )
       {
-         switch( *itr )
-         {
-            case '\b':        // \x08
-               os << "\\b";
-               break;
-            case '\f':        // \x0c
-               os << "\\f";
-               break;
-            case '\n':        // \x0a
-               os << "\\n";
-               break;
-            case '\r':        // \x0d
-               os << "\\r";
-               break;
-            case '\t':        // \x09
-               os << "\\t";
-               break;
-            case '\\':
-               os << "\\\\";
-               break;
-            case '\"':
-               os << "\\\"";
-               break;
-            case '\x00': os << "\\u0000"; break;
-            case '\x01': os << "\\u0001"; break;
-            case '\x02': os << "\\u0002"; break;
-            case '\x03': os << "\\u0003"; break;
-            case '\x04': os << "\\u0004"; break;
-            case '\x05': os << "\\u0005"; break;
-            case '\x06': os << "\\u0006"; break;
-            case '\x07': os << "\\u0007"; break; // \a is not valid JSON
-         // case '\x08': os << "\\u0008"; break; // \b
-         // case '\x09': os << "\\u0009"; break; // \t
-         // case '\x0a': os << "\\u000a"; break; // \n
-            case '\x0b': os << "\\u000b"; break;
-         // case '\x0c': os << "\\u000c"; break; // \f
-         // case '\x0d': os << "\\u000d"; break; // \r
-            case '\x0e': os << "\\u000e"; break;
-            case '\x0f': os << "\\u000f"; break;
-
-            case '\x10': os << "\\u0010"; break;
-            case '\x11': os << "\\u0011"; break;
-            case '\x12': os << "\\u0012"; break;
-            case '\x13': os << "\\u0013"; break;
-            case '\x14': os << "\\u0014"; break;
-            case '\x15': os << "\\u0015"; break;
-            case '\x16': os << "\\u0016"; break;
-            case '\x17': os << "\\u0017"; break;
-            case '\x18': os << "\\u0018"; break;
-            case '\x19': os << "\\u0019"; break;
-            case '\x1a': os << "\\u001a"; break;
-            case '\x1b': os << "\\u001b"; break;
-            case '\x1c': os << "\\u001c"; break;
-            case '\x1d': os << "\\u001d"; break;
-            case '\x1e': os << "\\u001e"; break;
-            case '\x1f': os << "\\u001f"; break;
+         if( const char* esc = json_escape_sequence( *itr ) )
+            os << esc;
+         else
+            os << *itr;
+      }
+      os << '"';
+   }
 
-            default:
-               os << *itr;
-               //toUTF8( *itr, os );
+   /** Copies each run of characters that need no escaping in one append */
+   void escape_string( const string& str, json_string_writer& os )
+   {
+      os << '"';
+      const char* run = str.data();
+      const char* end = str.data() + str.size();
+      for( const char* p = run; p != end; ++p )
+      {
+         if( const char* esc = json_escape_sequence( *p ) )
+         {
+            os.write( run, p - run );
+            os << esc;
+            run = p + 1;
          }
       }
+      os.write( run, end - run );
       os << '"';
    }
    ostream& json::to_stream( ostream& out, const fc::string& str )
@@ -681,11 +752,25 @@ namespace fc
 
    fc::string   json::to_string( const variant& v, output_formatting format /* = stringify_large_ints_and_doubles */ )
    {
-      fc::stringstream ss;
-      fc::to_stream( ss, v, format );
-      return ss.str();
+      fc::string result;
+      result.reserve( 256 );
+      json_string_writer out( result );
+      fc::to_stream( out, v, format );
+      return result;
+   }
+
+
+   void json::append( std::string& out, const variant& v, output_formatting format )
+   {
+      json_string_writer w( out );
+      fc::to_stream( w, v, format );
    }
 
+   void json::append_escaped( std::string& out, const std::string& s )
+   {
+      json_string_writer w( out );
+      escape_string( s, w );
+   }
 
     fc::string pretty_print( const fc::string& v, uint8_t indent ) {
       int level = 0;
@@ -852,20 +937,20 @@ namespace fc
    bool json::is_valid( const std::string& utf8_str, parse_type ptype )
    {
       if( utf8_str.size() == 0 ) return false;
-      fc::stringstream in( utf8_str );
+      json_string_reader in( utf8_str.data(), utf8_str.data() + utf8_str.size() );
       switch( ptype )
       {
           case legacy_parser:
-              variant_from_stream<fc::stringstream, legacy_parser>( in );
+              variant_from_stream<json_string_reader, legacy_parser>( in );
               break;
           case legacy_parser_with_string_doubles:
-              variant_from_stream<fc::stringstream, legacy_parser_with_string_doubles>( in );
+              variant_from_stream<json_string_reader, legacy_parser_with_string_doubles>( in );
               break;
           case strict_parser:
-              json_relaxed::variant_from_stream<fc::stringstream, true>( in );
+              json_relaxed::variant_from_stream<json_string_reader, true>( in );
               break;
           case relaxed_parser:
-              json_relaxed::variant_from_stream<fc::stringstream, false>( in );
+              json_relaxed::variant_from_stream<json_string_reader, false>( in );
               break;
           default:
               FC_ASSERT( false, "Unknown JSON parser type {ptype}", ("ptype", ptype) );
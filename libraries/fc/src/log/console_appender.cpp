@@ -1,5 +1,6 @@
 #include <fc/log/console_appender.hpp>
 #include <fc/log/log_message.hpp>
+#include <fc/log/log_queue.hpp>
 #include <fc/thread/unique_lock.hpp>
 #include <fc/string.hpp>
 #include <fc/variant.hpp>
@@ -22,11 +23,16 @@ namespace fc {
    public:
      config                      cfg;
      color::type                 lc[log_level::off+1];
+     std::unique_ptr<log_queue>  queue;
 #ifdef WIN32
      HANDLE                      console_handle;
 #endif
    };
 
+   boost::mutex& log_mutex() {
+    static boost::mutex m; return m;
+   }
+
    console_appender::console_appender( const variant& args ) 
    :my(new impl)
    {
@@ -59,9 +65,38 @@ namespace fc {
             my->lc[i] = color::console_default;
          for( auto itr = my->cfg.level_colors.begin(); itr != my->cfg.level_colors.end(); ++itr )
             my->lc[itr->level] = itr->color;
+
+         my->queue.reset();
+         if( my->cfg.async )
+         {
+            my->queue.reset( new log_queue( my->cfg.async_queue_size, [this]( const std::vector<log_message>& batch, uint64_t dropped )
+            {
+               FILE* out = stream::std_error ? stderr : stdout;
+
+               fc::unique_lock<boost::mutex> lock(log_mutex());
+               if( dropped )
+                  fprintf( out, "log queue full, dropped %llu messages\n", (unsigned long long)dropped );
+               for( const auto& m : batch )
+               {
+                  print_line( m );
+                  fprintf( out, "\n" );
+               }
+               // once per batch
+               if( my->cfg.flush ) fflush( out );
+            } ) );
+         }
    } FC_CAPTURE_AND_RETHROW( (console_appender_config) ) }
 
-   console_appender::~console_appender() {}
+   console_appender::~console_appender()
+   {
+      // prints what is still queued
+      my->queue.reset();
+   }
+
+   uint64_t console_appender::dropped_messages()const
+   {
+      return my->queue ? my->queue->dropped() : 0;
+   }
 
    #ifdef WIN32
    static WORD
@@ -83,16 +118,28 @@ namespace fc {
       }
    }
 
-   boost::mutex& log_mutex() {
-    static boost::mutex m; return m;
+   void console_appender::log( const log_message& m ) {
+      if( my->queue )
+      {
+         my->queue->push( m );
+         return;
+      }
+
+      FILE* out = stream::std_error ? stderr : stdout;
+
+      fc::unique_lock<boost::mutex> lock(log_mutex());
+
+      print_line( m );
+
+      fprintf( out, "\n" );
+
+      if( my->cfg.flush ) fflush( out );
    }
 
-   void console_appender::log( const log_message& m ) {
+   void console_appender::print_line( const log_message& m ) {
       //fc::string message = fc::format_string( m.get_format(), m.get_data() );
       //fc::variant lmsg(m);
 
-      FILE* out = stream::std_error ? stderr : stdout;
-
       //fc::string fmt_str = fc::format_string( cfg.format, mutable_variant_object(m.get_context())( "message", message)  );
       std::stringstream file_line;
       file_line << m.get_context().get_file() <<":"<<m.get_context().get_line_number() <<" ";
@@ -119,16 +166,18 @@ namespace fc {
       fc::string message = fc::format_string( m.get_format(), m.get_data() );
       line << message;//.c_str();
 
-      fc::unique_lock<boost::mutex> lock(log_mutex());
-
-      print( line.str(), my->lc[m.get_context().get_log_level()] );
+      print_text( line.str(), my->lc[m.get_context().get_log_level()] );
+   }
 
-      fprintf( out, "\n" );
+   void console_appender::print( const std::string& text, color::type text_color )
+   {
+      print_text( text, text_color );
 
+      FILE* out = stream::std_error ? stderr : stdout;
       if( my->cfg.flush ) fflush( out );
    }
 
-   void console_appender::print( const std::string& text, color::type text_color )
+   void console_appender::print_text( const std::string& text, color::type text_color )
    {
       FILE* out = stream::std_error ? stderr : stdout;
 
@@ -148,8 +197,6 @@ namespace fc {
       #else
       if(isatty(fileno(out))) fprintf( out, "\r%s", CONSOLE_DEFAULT );
       #endif
-
-      if( my->cfg.flush ) fflush( out );
    }
 
 }
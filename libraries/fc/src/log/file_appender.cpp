@@ -1,6 +1,7 @@
 #include <fc/exception/exception.hpp>
 #include <fc/io/fstream.hpp>
 #include <fc/log/file_appender.hpp>
+#include <fc/log/log_queue.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/thread/scoped_lock.hpp>
 #include <fc/thread/thread.hpp>
@@ -19,6 +20,7 @@ namespace fc {
          config                     cfg;
          ofstream                   out;
          boost::mutex               slock;
+         std::unique_ptr<log_queue> queue;
 
       private:
          future<void>               _rotation_task;
@@ -48,6 +50,8 @@ namespace fc {
 
          ~impl()
          {
+            // writes out what is still queued
+            queue.reset();
             try
             {
               _rotation_task.cancel_and_wait("file_appender is destructing");
@@ -136,6 +140,41 @@ namespace fc {
          }
    };
 
+   // MS THREAD METHOD  MESSAGE \t\t\t File:Line
+   static void format_line( const log_message& m, std::string& out )
+   {
+      std::stringstream line;
+      //line << (m.get_context().get_timestamp().time_since_epoch().count() % (1000ll*1000ll*60ll*60))/1000 <<"ms ";
+      line << string(m.get_context().get_timestamp()) << " ";
+      line << std::setw( 21 ) << (m.get_context().get_thread_name().substr(0,9) + string(":") + m.get_context().get_task_name()).c_str() << " ";
+
+      string method_name = m.get_context().get_method();
+      // strip all leading scopes...
+      if( method_name.size() )
+      {
+         uint32_t p = 0;
+         for( uint32_t i = 0;i < method_name.size(); ++i )
+         {
+             if( method_name[i] == ':' ) p = i;
+         }
+
+         if( method_name[p] == ':' )
+           ++p;
+         line << std::setw( 20 ) << m.get_context().get_method().substr(p,20).c_str() <<" ";
+      }
+
+      line << "] ";
+      fc::string message = fc::format_string( m.get_format(), m.get_data() );
+      line << message.c_str();
+
+      //fc::variant lmsg(m);
+
+      // fc::string fmt_str = fc::format_string( my->cfg.format, mutable_variant_object(m.get_context())( "message", message)  );
+
+      line << "\t\t\t" << m.get_context().get_file() << ":" << m.get_context().get_line_number() << "\n";
+      out += line.str();
+   }
+
    file_appender::config::config(const fc::path& p) :
      format( "${timestamp} ${thread_name} ${context} ${file}:${line} ${method} ${level}]  ${message}" ),
      filename(p),
@@ -158,47 +197,50 @@ namespace fc {
       {
          std::cerr << "error opening log file: " << my->cfg.filename.preferred_string() << "\n";
       }
+
+      if( my->cfg.async )
+      {
+         impl* i = my.get();
+         my->queue.reset( new log_queue( my->cfg.async_queue_size, [i]( const std::vector<log_message>& batch, uint64_t dropped )
+         {
+            // one write and at most one flush per batch
+            std::string lines;
+            if( dropped )
+               lines += string(time_point::now()) + " log queue full, dropped " + std::to_string( dropped ) + " messages\n";
+            for( const auto& m : batch )
+               format_line( m, lines );
+
+            fc::scoped_lock<boost::mutex> lock( i->slock );
+            i->out << lines;
+            if( i->cfg.flush )
+               i->out.flush();
+         } ) );
+      }
    }
 
    file_appender::~file_appender(){}
 
-   // MS THREAD METHOD  MESSAGE \t\t\t File:Line
    void file_appender::log( const log_message& m )
    {
-      std::stringstream line;
-      //line << (m.get_context().get_timestamp().time_since_epoch().count() % (1000ll*1000ll*60ll*60))/1000 <<"ms ";
-      line << string(m.get_context().get_timestamp()) << " ";
-      line << std::setw( 21 ) << (m.get_context().get_thread_name().substr(0,9) + string(":") + m.get_context().get_task_name()).c_str() << " ";
-
-      string method_name = m.get_context().get_method();
-      // strip all leading scopes...
-      if( method_name.size() )
+      if( my->queue )
       {
-         uint32_t p = 0;
-         for( uint32_t i = 0;i < method_name.size(); ++i )
-         {
-             if( method_name[i] == ':' ) p = i;
-         }
-
-         if( method_name[p] == ':' )
-           ++p;
-         line << std::setw( 20 ) << m.get_context().get_method().substr(p,20).c_str() <<" ";
+         my->queue->push( m );
+         return;
       }
 
-      line << "] ";
-      fc::string message = fc::format_string( m.get_format(), m.get_data() );
-      line << message.c_str();
-
-      //fc::variant lmsg(m);
-
-      // fc::string fmt_str = fc::format_string( my->cfg.format, mutable_variant_object(m.get_context())( "message", message)  );
-
+      std::string line;
+      format_line( m, line );
       {
         fc::scoped_lock<boost::mutex> lock( my->slock );
-        my->out << line.str() << "\t\t\t" << m.get_context().get_file() << ":" << m.get_context().get_line_number() << "\n";
+        my->out << line;
         if( my->cfg.flush )
           my->out.flush();
       }
    }
 
+   uint64_t file_appender::dropped_messages()const
+   {
+      return my->queue ? my->queue->dropped() : 0;
+   }
+
 } // fc
@@ -0,0 +1,124 @@
+#include <fc/log/log_queue.hpp>
+
+#include <iostream>
+
+namespace fc {
+
+   log_queue::log_queue( uint32_t capacity, writer w )
+   :_enqueue_pos(0),_dropped(0),_waiting(false),_writer( std::move( w ) )
+   {
+      uint64_t size = 2;
+      while( size < capacity )
+         size <<= 1;
+      _cells.reset( new cell[size] );
+      _mask = size - 1;
+      for( uint64_t i = 0; i < size; ++i )
+         _cells[i].sequence.store( i, std::memory_order_relaxed );
+
+      _thread = std::thread( [this](){ run(); } );
+   }
+
+   log_queue::~log_queue()
+   {
+      {
+         std::lock_guard< std::mutex > lock( _mutex );
+         _stopping = true;
+      }
+      _wake.notify_one();
+      _thread.join();
+   }
+
+   // Bounded multi-producer queue after Dmitry Vyukov: each cell's sequence tells
+   // producers and the consumer whose turn it is, so a slot is claimed with one CAS
+   bool log_queue::push( const log_message& m )
+   {
+      uint64_t pos = _enqueue_pos.load( std::memory_order_relaxed );
+      for( ;; )
+      {
+         cell& c = _cells[ pos & _mask ];
+         uint64_t seq = c.sequence.load( std::memory_order_acquire );
+         int64_t diff = int64_t( seq ) - int64_t( pos );
+         if( diff == 0 )
+         {
+            if( _enqueue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+            {
+               c.message = m;
+               c.sequence.store( pos + 1, std::memory_order_release );
+               break;
+            }
+         }
+         else if( diff < 0 )
+         {
+            _dropped.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+         }
+         else
+            pos = _enqueue_pos.load( std::memory_order_relaxed );
+      }
+
+      // Pairs with the fence in run(): either the writer sees this message before it
+      // sleeps, or this thread sees it waiting and wakes it
+      std::atomic_thread_fence( std::memory_order_seq_cst );
+      if( _waiting.load( std::memory_order_relaxed ) )
+      {
+         std::lock_guard< std::mutex > lock( _mutex );
+         _wake.notify_one();
+      }
+      return true;
+   }
+
+   bool log_queue::pop( log_message& m )
+   {
+      cell& c = _cells[ _dequeue_pos & _mask ];
+      if( c.sequence.load( std::memory_order_acquire ) != _dequeue_pos + 1 )
+         return false;
+      m = std::move( c.message );
+      c.message = log_message();
+      c.sequence.store( _dequeue_pos + _mask + 1, std::memory_order_release );
+      ++_dequeue_pos;
+      return true;
+   }
+
+   bool log_queue::empty()const
+   {
+      return _cells[ _dequeue_pos & _mask ].sequence.load( std::memory_order_acquire ) != _dequeue_pos + 1;
+   }
+
+   void log_queue::run()
+   {
+      std::vector< log_message > batch;
+      uint64_t reported_drops = 0;
+      for( ;; )
+      {
+         log_message m;
+         while( batch.size() <= _mask && pop( m ) )
+            batch.push_back( std::move( m ) );
+
+         uint64_t drops = _dropped.load( std::memory_order_relaxed );
+         if( batch.size() || drops != reported_drops )
+         {
+            try
+            {
+               _writer( batch, drops - reported_drops );
+            }
+            catch( ... )
+            {
+               std::cerr << "log_queue: writing log messages failed\n";
+            }
+            reported_drops = drops;
+            batch.clear();
+            continue;
+         }
+
+         std::unique_lock< std::mutex > lock( _mutex );
+         if( _stopping )
+            break;
+         _waiting.store( true, std::memory_order_relaxed );
+         std::atomic_thread_fence( std::memory_order_seq_cst );
+         if( empty() )
+            _wake.wait_for( lock, std::chrono::milliseconds( 100 ) );
+         _waiting.store( false, std::memory_order_relaxed );
+      }
+   }
+
+} // namespace fc
@@ -5,12 +5,26 @@
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <websocketpp/logger/stub.hpp>
+#ifdef HAS_ZLIB
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#endif
 
 #include <fc/optional.hpp>
 #include <fc/variant.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/asio.hpp>
 
+#include <boost/algorithm/string.hpp>
+
+#ifdef HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
 #endif
@@ -140,16 +154,115 @@ namespace fc { namespace http {
 
 
 
+#ifdef HAS_ZLIB
+      /**
+       *  Servers negotiate permessage-deflate with clients that offer it; only messages marked
+       *  compressed are deflated.  Outgoing client connections keep the configs above and never
+       *  offer it.
+       */
+      template<typename Config>
+      struct deflate_server_config : public Config {
+         struct permessage_deflate_config : public Config::permessage_deflate_config {};
+         typedef websocketpp::extensions::permessage_deflate::enabled<permessage_deflate_config>
+            permessage_deflate_type;
+      };
+      typedef deflate_server_config<asio_with_stub_log>  asio_server_stub_log;
+      typedef deflate_server_config<asio_tls_stub_log>   asio_tls_server_stub_log;
+#else
+      typedef asio_with_stub_log                         asio_server_stub_log;
+      typedef asio_tls_stub_log                          asio_tls_server_stub_log;
+#endif
+
       using websocketpp::connection_hdl;
-      typedef websocketpp::server<asio_with_stub_log>  websocket_server_type;
-      typedef websocketpp::server<asio_tls_stub_log>   websocket_tls_server_type;
+      typedef websocketpp::server<asio_server_stub_log>      websocket_server_type;
+      typedef websocketpp::server<asio_tls_server_stub_log>  websocket_tls_server_type;
+
+      /// Settings of websocket_server::set_compression
+      struct compression_settings
+      {
+         uint32_t    min_size = 0;
+         int         level = -1; // zlib's default
+      };
+
+#ifdef HAS_ZLIB
+      /** @return the body as a gzip stream, or nothing if zlib fails */
+      optional<std::string> gzip_compress( const std::string& in, int level )
+      {
+         z_stream zs;
+         memset( &zs, 0, sizeof( zs ) );
+         // 16 + 15 window bits asks zlib for a gzip header and trailer
+         if( deflateInit2( &zs, level, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+            return optional<std::string>();
+
+         std::string out;
+         out.resize( deflateBound( &zs, in.size() ) );
+         zs.next_in = (Bytef*)in.data();
+         zs.avail_in = in.size();
+         zs.next_out = (Bytef*)&out[0];
+         zs.avail_out = out.size();
+         int ret = deflate( &zs, Z_FINISH );
+         out.resize( zs.total_out );
+         deflateEnd( &zs );
+         if( ret != Z_STREAM_END )
+            return optional<std::string>();
+         return out;
+      }
+
+      /** true if an Accept-Encoding header value allows gzip */
+      bool accepts_gzip( const std::string& accept_encoding )
+      {
+         std::vector<std::string> codings;
+         boost::split( codings, accept_encoding, boost::is_any_of( "," ) );
+         for( const auto& c : codings )
+         {
+            std::vector<std::string> params;
+            boost::split( params, c, boost::is_any_of( ";" ) );
+            std::string name = boost::algorithm::to_lower_copy( boost::algorithm::trim_copy( params[0] ) );
+            if( name != "gzip" && name != "*" )
+               continue;
+            bool refused = false;
+            for( size_t i = 1; i < params.size(); ++i )
+            {
+               std::string param = boost::algorithm::erase_all_copy( params[i], " " );
+               if( boost::starts_with( param, "q=" ) && std::atof( param.c_str() + 2 ) <= 0 )
+                  refused = true;
+            }
+            if( !refused )
+               return true;
+         }
+         return false;
+      }
+#endif
+
+      /** Sets an HTTP response body, gzipped if it is large enough and the client accepts it */
+      template<typename Connection>
+      void set_http_body( const Connection& con, std::string body, const compression_settings& compression )
+      {
+#ifdef HAS_ZLIB
+         if( compression.min_size )
+         {
+            con->append_header( "Vary", "Accept-Encoding" );
+            if( body.size() >= compression.min_size && accepts_gzip( con->get_request_header( "Accept-Encoding" ) ) )
+            {
+               auto zipped = gzip_compress( body, compression.level );
+               if( zipped )
+               {
+                  con->append_header( "Content-Encoding", "gzip" );
+                  body = std::move( *zipped );
+               }
+            }
+         }
+#endif
+         con->set_body( body );
+      }
 
       template<typename T>
       class websocket_connection_impl : public websocket_connection
       {
          public:
-            websocket_connection_impl( T con )
-            :_ws_connection(con){
+            /** @param compress_min_size smallest message sent compressed, if the peer negotiated it; 0 never compresses */
+            websocket_connection_impl( T con, uint32_t compress_min_size = 0 )
+            :_ws_connection(con),_compress_min_size(compress_min_size){
             }
 
             ~websocket_connection_impl()
@@ -158,9 +271,11 @@ namespace fc { namespace http {
 
             virtual void send_message( const std::string& message )override
             {
-               idump((message));
                //std::cerr<<"send: "<<message<<"\n";
-               auto ec = _ws_connection->send( message );
+               auto msg = _ws_connection->get_message( websocketpp::frame::opcode::text, message.size() );
+               msg->append_payload( message );
+               msg->set_compressed( _compress_min_size && message.size() >= _compress_min_size );
+               auto ec = _ws_connection->send( msg );
                FC_ASSERT( !ec, "websocket send failed: ${msg}", ("msg",ec.message() ) );
             }
             virtual void close( int64_t code, const std::string& reason  )override
@@ -169,8 +284,177 @@ namespace fc { namespace http {
             }
 
             T _ws_connection;
+            uint32_t _compress_min_size;
+      };
+
+      /**
+       *  Runs connection messages on a pool of fc threads.  Each connection is pinned to
+       *  one worker and drained by a single task at a time, which keeps its messages in
+       *  order even when a call yields.
+       */
+      class message_worker_pool
+      {
+         public:
+            struct connection_queue
+            {
+               std::deque< std::string >  messages;
+               bool                       draining = false;
+               fc::thread*                worker = nullptr;
+            };
+            typedef std::shared_ptr< connection_queue > connection_queue_ptr;
+
+            message_worker_pool( uint32_t threads, uint32_t max_pending )
+            :_max_pending( std::max< uint32_t >( max_pending, 1 ) )
+            {
+               FC_ASSERT( threads > 0 );
+               for( uint32_t i = 0; i < threads; ++i )
+                  _workers.emplace_back( new fc::thread( "rpc-worker-" + std::to_string( i ) ) );
+            }
+
+            ~message_worker_pool()
+            {
+               for( auto& w : _workers )
+                  w->quit();
+            }
+
+            connection_queue_ptr create_queue()
+            {
+               auto q = std::make_shared< connection_queue >();
+               q->worker = next_worker();
+               return q;
+            }
+
+            /**
+             *  Queues a message for the connection, waiting (and so holding back the calling
+             *  asio thread) while its queue is full.
+             */
+            void push( const connection_queue_ptr& q, const websocket_connection_ptr& con, std::string message )
+            {
+               bool waited = false;
+               while( true )
+               {
+                  std::unique_lock< std::mutex > lock( _mutex );
+                  if( q->messages.size() < _max_pending )
+                  {
+                     q->messages.push_back( std::move( message ) );
+                     ++_queued;
+                     _max_depth = std::max< uint64_t >( _max_depth, q->messages.size() );
+                     if( q->draining )
+                        return;
+                     q->draining = true;
+                     break;
+                  }
+                  lock.unlock();
+                  if( !waited )
+                  {
+                     ++_backpressure_waits;
+                     waited = true;
+                  }
+                  // Workers run on other threads, so poll rather than block this fc thread
+                  fc::usleep( fc::milliseconds( 1 ) );
+               }
+
+               q->worker->async( [this,q,con]() { drain( q, con ); }, "rpc drain" );
+            }
+
+            void run_http( const std::function< void() >& f )
+            {
+               ++_http_requests;
+               next_worker()->async( f, "rpc http" );
+            }
+
+            websocket_server_stats get_stats()const
+            {
+               std::unique_lock< std::mutex > lock( _mutex );
+               websocket_server_stats s;
+               s.worker_threads = _workers.size();
+               s.max_pending_per_connection = _max_pending;
+               s.queued_messages = _queued;
+               s.max_queue_depth = _max_depth;
+               s.processed_messages = _processed;
+               s.http_requests = _http_requests;
+               s.backpressure_waits = _backpressure_waits;
+               return s;
+            }
+
+         private:
+            fc::thread* next_worker()
+            {
+               return _workers[ _next_worker++ % _workers.size() ].get();
+            }
+
+            void drain( const connection_queue_ptr& q, const websocket_connection_ptr& con )
+            {
+               while( true )
+               {
+                  std::string message;
+                  {
+                     std::unique_lock< std::mutex > lock( _mutex );
+                     if( q->messages.empty() )
+                     {
+                        q->draining = false;
+                        return;
+                     }
+                     message = std::move( q->messages.front() );
+                     q->messages.pop_front();
+                     --_queued;
+                  }
+
+                  try
+                  {
+                     con->on_message( message );
+                  }
+                  catch( const fc::exception& e )
+                  {
+                     wdump((e.to_detail_string()));
+                  }
+
+                  std::unique_lock< std::mutex > lock( _mutex );
+                  ++_processed;
+               }
+            }
+
+            std::vector< std::unique_ptr< fc::thread > >   _workers;
+            std::atomic< uint32_t >                        _next_worker{ 0 };
+            const uint32_t                                 _max_pending;
+
+            mutable std::mutex                             _mutex;
+            uint64_t                                       _queued = 0;
+            uint64_t                                       _max_depth = 0;
+            uint64_t                                       _processed = 0;
+            std::atomic< uint64_t >                        _http_requests{ 0 };
+            std::atomic< uint64_t >                        _backpressure_waits{ 0 };
       };
 
+      /**
+       *  Answers a request with the shared HTTP handler off the server thread, on the worker
+       *  pool when there is one.  The response is deferred until the handler returns.
+       */
+      template<typename Connection>
+      void serve_http( const Connection& con, const on_http_handler& handler, const compression_settings& compression, message_worker_pool* pool )
+      {
+         con->defer_http_response();
+         std::string request_body = con->get_request_body();
+
+         auto respond = [handler, compression, request_body, con] {
+            try
+            {
+               set_http_body( con, handler( request_body ), compression );
+               con->set_status( websocketpp::http::status_code::ok );
+            }
+            catch( const fc::exception& e )
+            {
+               edump((e.to_detail_string()));
+               con->set_status( websocketpp::http::status_code::internal_server_error );
+            }
+            con->send_http_response();
+         };
+         if( pool )
+            pool->run_http( respond );
+         else
+            fc::async( respond, "call on_http" );
+      }
+
       typedef websocketpp::lib::shared_ptr<boost::asio::ssl::context> context_ptr;
 
       class websocket_server_impl
@@ -185,7 +469,7 @@ namespace fc { namespace http {
                _server.set_reuse_addr(true);
                _server.set_open_handler( [&]( connection_hdl hdl ){
                     _server_thread.async( [&](){
-                       auto new_con = std::make_shared<websocket_connection_impl<websocket_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl) );
+                       auto new_con = std::make_shared<websocket_connection_impl<websocket_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl), _compression.min_size );
                        _on_connection( _connections[hdl] = new_con );
                     }).wait();
                });
@@ -193,10 +477,14 @@ namespace fc { namespace http {
                     _server_thread.async( [&](){
                        auto current_con = _connections.find(hdl);
                        assert( current_con != _connections.end() );
-                       wdump(("server")(msg->get_payload()));
                        //std::cerr<<"recv: "<<msg->get_payload()<<"\n";
                        auto payload = msg->get_payload();
                        std::shared_ptr<websocket_connection> con = current_con->second;
+                       if( _pool )
+                       {
+                          _pool->push( queue_for( hdl ), con, std::move( payload ) );
+                          return;
+                       }
                        ++_pending_messages;
                        auto f = fc::async([this,con,payload](){ if( _pending_messages ) --_pending_messages; con->on_message( payload ); });
                        if( _pending_messages > 100 ) 
@@ -211,17 +499,23 @@ namespace fc { namespace http {
 
                _server.set_http_handler( [&]( connection_hdl hdl ){
                     _server_thread.async( [&](){
+                       if( _on_http )
+                       {
+                          serve_http( _server.get_con_from_hdl(hdl), _on_http, _compression, _pool.get() );
+                          return;
+                       }
+
                        auto current_con = std::make_shared<websocket_connection_impl<websocket_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl) );
                        _on_connection( current_con );
 
                        auto con = _server.get_con_from_hdl(hdl);
                        con->defer_http_response();
                        std::string request_body = con->get_request_body();
-                       wdump(("server")(request_body));
 
-                       fc::async([current_con, request_body, con] {
+                       compression_settings compression = _compression;
+                       fc::async([current_con, compression, request_body, con] {
                           std::string response = current_con->on_http(request_body);
-                          con->set_body( response );
+                          set_http_body( con, std::move( response ), compression );
                           con->set_status( websocketpp::http::status_code::ok );
                           con->send_http_response();
                           current_con->closed();
@@ -240,6 +534,7 @@ namespace fc { namespace http {
                        {
                             wlog( "unknown connection closed" );
                        }
+                       _queues.erase( hdl );
                        if( _connections.empty() && _closed )
                           _closed->set_value();
                     }).wait();
@@ -258,6 +553,7 @@ namespace fc { namespace http {
                           {
                             wlog( "unknown connection failed" );
                           }
+                          _queues.erase( hdl );
                           if( _connections.empty() && _closed )
                              _closed->set_value();
                        }).wait();
@@ -280,11 +576,25 @@ namespace fc { namespace http {
             }
 
             typedef std::map<connection_hdl, websocket_connection_ptr,std::owner_less<connection_hdl> > con_map;
+            typedef std::map<connection_hdl, message_worker_pool::connection_queue_ptr, std::owner_less<connection_hdl> > queue_map;
+
+            /// Called on the server thread
+            const message_worker_pool::connection_queue_ptr& queue_for( connection_hdl hdl )
+            {
+               auto& q = _queues[hdl];
+               if( !q )
+                  q = _pool->create_queue();
+               return q;
+            }
 
             con_map                  _connections;
             fc::thread&              _server_thread;
             websocket_server_type    _server;
             on_connection_handler    _on_connection;
+            on_http_handler          _on_http;
+            std::unique_ptr< message_worker_pool > _pool;
+            queue_map                _queues;
+            compression_settings     _compression;
             fc::promise<void>::ptr   _closed;
             uint32_t                 _pending_messages = 0;
       };
@@ -319,7 +629,7 @@ namespace fc { namespace http {
                _server.set_reuse_addr(true);
                _server.set_open_handler( [&]( connection_hdl hdl ){
                     _server_thread.async( [&](){
-                       auto new_con = std::make_shared<websocket_connection_impl<websocket_tls_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl) );
+                       auto new_con = std::make_shared<websocket_connection_impl<websocket_tls_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl), _compression.min_size );
                        _on_connection( _connections[hdl] = new_con );
                     }).wait();
                });
@@ -329,22 +639,31 @@ namespace fc { namespace http {
                        assert( current_con != _connections.end() );
                        auto received = msg->get_payload();
                        std::shared_ptr<websocket_connection> con = current_con->second;
+                       if( _pool )
+                       {
+                          _pool->push( queue_for( hdl ), con, std::move( received ) );
+                          return;
+                       }
                        fc::async([con,received](){ con->on_message( received ); });
                     }).wait();
                });
 
                _server.set_http_handler( [&]( connection_hdl hdl ){
                     _server_thread.async( [&](){
+                       if( _on_http )
+                       {
+                          serve_http( _server.get_con_from_hdl(hdl), _on_http, _compression, _pool.get() );
+                          return;
+                       }
 
                        auto current_con = std::make_shared<websocket_connection_impl<websocket_tls_server_type::connection_ptr>>( _server.get_con_from_hdl(hdl) );
                        try{
                           _on_connection( current_con );
 
                           auto con = _server.get_con_from_hdl(hdl);
-                          wdump(("server")(con->get_request_body()));
                           auto response = current_con->on_http( con->get_request_body() );
 
-                          con->set_body( response );
+                          set_http_body( con, std::move( response ), _compression );
                           con->set_status( websocketpp::http::status_code::ok );
                        } catch ( const fc::exception& e )
                        {
@@ -359,6 +678,7 @@ namespace fc { namespace http {
                     _server_thread.async( [&](){
                        _connections[hdl]->closed();
                        _connections.erase( hdl );
+                       _queues.erase( hdl );
                     }).wait();
                });
 
@@ -371,6 +691,7 @@ namespace fc { namespace http {
                              _connections[hdl]->closed();
                              _connections.erase( hdl );
                           }
+                          _queues.erase( hdl );
                        }).wait();
                     }
                });
@@ -385,11 +706,25 @@ namespace fc { namespace http {
             }
 
             typedef std::map<connection_hdl, websocket_connection_ptr,std::owner_less<connection_hdl> > con_map;
+            typedef std::map<connection_hdl, message_worker_pool::connection_queue_ptr, std::owner_less<connection_hdl> > queue_map;
+
+            /// Called on the server thread
+            const message_worker_pool::connection_queue_ptr& queue_for( connection_hdl hdl )
+            {
+               auto& q = _queues[hdl];
+               if( !q )
+                  q = _pool->create_queue();
+               return q;
+            }
 
             con_map                     _connections;
             fc::thread&                 _server_thread;
             websocket_tls_server_type   _server;
             on_connection_handler       _on_connection;
+            on_http_handler             _on_http;
+            std::unique_ptr< message_worker_pool > _pool;
+            queue_map                   _queues;
+            compression_settings        _compression;
             fc::promise<void>::ptr      _closed;
       };
 
@@ -422,7 +757,6 @@ namespace fc { namespace http {
                 _client.clear_access_channels( websocketpp::log::alevel::all );
                 _client.set_message_handler( [&]( connection_hdl hdl, message_ptr msg ){
                    _client_thread.async( [&](){
-                        wdump((msg->get_payload()));
                         //std::cerr<<"recv: "<<msg->get_payload()<<"\n";
                         auto received = msg->get_payload();
                         fc::async( [=](){
@@ -482,7 +816,6 @@ namespace fc { namespace http {
                 _client.clear_access_channels( websocketpp::log::alevel::all );
                 _client.set_message_handler( [&]( connection_hdl hdl, message_ptr msg ){
                    _client_thread.async( [&](){
-                        wdump((msg->get_payload()));
                       _connection->on_message( msg->get_payload() );
                    }).wait();
                 });
@@ -598,6 +931,27 @@ namespace fc { namespace http {
       my->_on_connection = handler;
    }
 
+   void websocket_server::on_http( const on_http_handler& handler )
+   {
+      my->_on_http = handler;
+   }
+
+   void websocket_server::set_worker_pool( uint32_t threads, uint32_t max_pending_per_connection )
+   {
+      my->_pool.reset( threads ? new detail::message_worker_pool( threads, max_pending_per_connection ) : nullptr );
+   }
+
+   void websocket_server::set_compression( uint32_t min_size, int level )
+   {
+      my->_compression.min_size = min_size;
+      my->_compression.level = level;
+   }
+
+   websocket_server_stats websocket_server::get_stats()const
+   {
+      return my->_pool ? my->_pool->get_stats() : websocket_server_stats();
+   }
+
    void websocket_server::listen( uint16_t port )
    {
       my->_server.listen(port);
@@ -622,6 +976,27 @@ namespace fc { namespace http {
       my->_on_connection = handler;
    }
 
+   void websocket_tls_server::on_http( const on_http_handler& handler )
+   {
+      my->_on_http = handler;
+   }
+
+   void websocket_tls_server::set_worker_pool( uint32_t threads, uint32_t max_pending_per_connection )
+   {
+      my->_pool.reset( threads ? new detail::message_worker_pool( threads, max_pending_per_connection ) : nullptr );
+   }
+
+   void websocket_tls_server::set_compression( uint32_t min_size, int level )
+   {
+      my->_compression.min_size = min_size;
+      my->_compression.level = level;
+   }
+
+   websocket_server_stats websocket_tls_server::get_stats()const
+   {
+      return my->_pool ? my->_pool->get_stats() : websocket_server_stats();
+   }
+
    void websocket_tls_server::listen( uint16_t port )
    {
       my->_server.listen(port);
@@ -0,0 +1,80 @@
+#include <fc/rpc/request_log.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <random>
+
+namespace fc { namespace rpc {
+
+namespace {
+
+   std::string method_name( const request& call )
+   {
+      if( call.method != "call" || call.params.size() < 2 || !call.params[1].is_string() )
+         return call.method;
+      const auto& api = call.params[0];
+      return ( api.is_string() ? api.get_string() : std::to_string( api.as_uint64() ) ) + "." + call.params[1].get_string();
+   }
+
+   double random_fraction()
+   {
+      thread_local std::minstd_rand generator( std::random_device{}() );
+      return std::uniform_real_distribution< double >( 0, 1 )( generator );
+   }
+
+}
+
+request_log::request_log()
+   : _logger( logger::get( "rpc" ) )
+{
+#ifdef LOG_LONG_API
+   _slow_call_warn = milliseconds( LOG_LONG_API_WARN_MS );
+   _slow_call_error = milliseconds( LOG_LONG_API_MAX_MS );
+#endif
+}
+
+void request_log::set_sample_rate( double rate )
+{
+   _sample_rate = rate;
+}
+
+void request_log::set_method_sample_rate( const std::string& method, double rate )
+{
+   _method_sample_rates[ method ] = rate;
+}
+
+void request_log::set_slow_call_thresholds( const microseconds& warn, const microseconds& error )
+{
+   _slow_call_warn = warn;
+   _slow_call_error = error;
+}
+
+bool request_log::sample( const request& call )const
+{
+   if( _sample_rate <= 0 && _method_sample_rates.empty() )
+      return false;
+   if( !_logger.is_enabled( log_level::info ) )
+      return false;
+
+   double rate = _sample_rate;
+   if( !_method_sample_rates.empty() )
+   {
+      auto itr = _method_sample_rates.find( method_name( call ) );
+      if( itr != _method_sample_rates.end() )
+         rate = itr->second;
+   }
+   return rate >= 1 || ( rate > 0 && random_fraction() < rate );
+}
+
+void request_log::record( const request& call, const microseconds& elapsed, bool ok )const
+{
+   if( _slow_call_error.count() > 0 && elapsed > _slow_call_error )
+      elog( "API call execution time limit exceeded. method: ${m} params: ${p} time: ${t}", ("m",method_name( call ))("p",call.params)("t",elapsed) );
+   else if( _slow_call_warn.count() > 0 && elapsed > _slow_call_warn )
+      wlog( "API call execution time nearing limit. method: ${m} params: ${p} time: ${t}", ("m",method_name( call ))("p",call.params)("t",elapsed) );
+
+   if( sample( call ) )
+      fc_ilog( _logger, "${method} ${us}us ok: ${ok} params: ${params}",
+               ("method",method_name( call ))("us",elapsed.count())("ok",ok)("params",call.params) );
+}
+
+} } // namespace fc::rpc
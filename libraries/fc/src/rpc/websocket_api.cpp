@@ -13,19 +13,8 @@ websocket_api_connection::websocket_api_connection( fc::http::websocket_connecti
    _rpc_state.add_method( "call", [this]( const variants& args ) -> variant
    {
       FC_ASSERT( args.size() == 3 && args[2].is_array() );
-      api_id_type api_id;
-      if( args[0].is_string() )
-      {
-         variants subargs;
-         subargs.push_back( args[0] );
-         variant subresult = this->receive_call( 1, "get_api_by_name", subargs );
-         api_id = subresult.as_uint64();
-      }
-      else
-         api_id = args[0].as_uint64();
-
-      return this->receive_call(
-         api_id,
+      return this->dispatch_call(
+         this->resolve_api_id( args[0] ),
          args[1].as_string(),
          args[2].get_array() );
    } );
@@ -46,7 +35,7 @@ websocket_api_connection::websocket_api_connection( fc::http::websocket_connecti
 
    _rpc_state.on_unhandled( [&]( const std::string& method_name, const variants& args )
    {
-      return this->receive_call( 0, method_name, args );
+      return this->dispatch_call( 0, method_name, args );
    } );
 
    _connection.on_message_handler( [&]( const std::string& msg ){ on_message(msg,true); } );
@@ -54,6 +43,43 @@ websocket_api_connection::websocket_api_connection( fc::http::websocket_connecti
    _connection.closed.connect( [this](){ closed(); } );
 }
 
+api_id_type websocket_api_connection::resolve_api_id( const variant& api )
+{
+   if( !api.is_string() )
+      return api.as_uint64();
+
+   variants subargs;
+   subargs.push_back( api );
+   variant subresult = this->receive_call( 1, "get_api_by_name", subargs );
+   return subresult.as_uint64();
+}
+
+variant websocket_api_connection::dispatch_call(
+   api_id_type api_id,
+   const std::string& method_name,
+   const variants& args )
+{
+   if( !_dispatcher )
+      return this->receive_call( api_id, method_name, args );
+   variant result;
+   _dispatcher( api_id, method_name, [&]() { result = this->receive_call( api_id, method_name, args ); } );
+   return result;
+}
+
+std::string websocket_api_connection::dispatch_call_json( const variants& args )
+{
+   FC_ASSERT( args.size() == 3 && args[2].is_array() );
+   api_id_type api_id = resolve_api_id( args[0] );
+   const std::string method_name = args[1].as_string();
+   const variants& method_args = args[2].get_array();
+
+   if( !_dispatcher )
+      return this->receive_call_json( api_id, method_name, method_args );
+   std::string result;
+   _dispatcher( api_id, method_name, [&]() { result = this->receive_call_json( api_id, method_name, method_args ); } );
+   return result;
+}
+
 variant websocket_api_connection::send_call(
    api_id_type api_id,
    string method_name,
@@ -81,62 +107,135 @@ void websocket_api_connection::send_notice(
    _connection.send_message( fc::json::to_string(req) );
 }
 
-std::string websocket_api_connection::on_message(
-   const std::string& message,
-   bool send_message /* = true */ )
+optional< std::string > websocket_api_connection::handle_call( const fc::rpc::request& call )
 {
-   wdump((message));
+   auto start = time_point::now();
+   optional< std::string > reply;
+   exception_ptr optexcept;
+   bool ok = false;
    try
    {
-      auto var = fc::json::from_string(message);
-      const auto& var_obj = var.get_object();
-      if( var_obj.contains( "method" ) )
+      try
       {
-         auto call = var.as<fc::rpc::request>();
-         exception_ptr optexcept;
-         try
+         // Results of "call" are written straight from the API's return value; they
+         // never need to exist as a variant
+         if( call.id && call.method == "call" )
          {
-            try
-            {
-#ifdef LOG_LONG_API
-               auto start = time_point::now();
-#endif
-
-               auto result = _rpc_state.local_call( call.method, call.params );
-
-#ifdef LOG_LONG_API
-               auto end = time_point::now();
-
-               if( end - start > fc::milliseconds( LOG_LONG_API_MAX_MS ) )
-                  elog( "API call execution time limit exceeded. method: ${m} params: ${p} time: ${t}", ("m",call.method)("p",call.params)("t", end - start) );
-               else if( end - start > fc::milliseconds( LOG_LONG_API_WARN_MS ) )
-                  wlog( "API call execution time nearing limit. method: ${m} params: ${p} time: ${t}", ("m",call.method)("p",call.params)("t", end - start) );
-#endif
-
-               if( call.id )
-               {
-                  auto reply = fc::json::to_string( response( *call.id, result ) );
-                  if( send_message )
-                     _connection.send_message( reply );
-                  return reply;
-               }
-            }
-            FC_CAPTURE_AND_RETHROW( (call.method)(call.params) )
+            std::string result_json = dispatch_call_json( call.params );
+
+            // Same text as fc::json::to_string( response( id, result ) )
+            reply = "{\"id\":";
+            fc::json_writer writer( *reply );
+            writer.write( *call.id );
+            writer.raw( ",\"result\":" );
+            writer.raw( result_json );
+            writer.raw( '}' );
          }
-         catch ( const fc::exception& e )
+         else
          {
+            variant result = _rpc_state.local_call( call.method, call.params );
             if( call.id )
-            {
-               optexcept = e.dynamic_copy_exception();
-            }
+               reply = fc::json::to_string( response( *call.id, result ) );
          }
-         if( optexcept ) {
+         ok = true;
+      }
+      FC_CAPTURE_AND_RETHROW( (call.method)(call.params) )
+   }
+   catch ( const fc::exception& e )
+   {
+      if( call.id )
+      {
+         optexcept = e.dynamic_copy_exception();
+      }
+   }
+   if( optexcept )
+      reply = fc::json::to_string( response( *call.id,  error_object{ 1, optexcept->to_detail_string(), fc::variant(*optexcept)}  ) );
+
+   if( _request_log )
+      _request_log->record( call, time_point::now() - start, ok );
+   return reply;
+}
 
-               auto reply = fc::json::to_string( response( *call.id,  error_object{ 1, optexcept->to_detail_string(), fc::variant(*optexcept)}  ) );
-               if( send_message )
-                  _connection.send_message( reply );
+std::string websocket_api_connection::error_reply( const variant& id, int64_t code, const std::string& message, const fc::exception& e )
+{
+   return fc::json::to_string( fc::mutable_variant_object( "id", id )
+      ( "error", error_object{ code, message + ": " + e.to_string(), fc::variant(e) } ) );
+}
+
+std::string websocket_api_connection::on_batch( const variants& batch, bool send_message )
+{
+   try
+   {
+      FC_ASSERT( _max_batch_size > 0, "Batch requests are disabled" );
+      FC_ASSERT( batch.size() > 0, "Empty batch request" );
+      FC_ASSERT( batch.size() <= _max_batch_size, "Batch of ${n} requests exceeds the limit of ${max}", ("n", batch.size())("max", _max_batch_size) );
+   }
+   catch ( const fc::exception& e )
+   {
+      // The batch as a whole is invalid, so it gets one error instead of an array
+      std::string reply = error_reply( variant(), -32600, "Invalid request", e );
+      if( send_message )
+         _connection.send_message( reply );
+      return reply;
+   }
+
+   // Each reply is appended as soon as its call completes, without building a variant of the whole batch
+   std::string reply = "[";
+   bool empty = true;
+   for( const auto& item : batch )
+   {
+      optional< std::string > item_reply;
+      try
+      {
+         item_reply = handle_call( item.as< fc::rpc::request >() );
+      }
+      catch ( const fc::exception& e )
+      {
+         // Echo the id when the entry has one that can be read
+         variant id;
+         if( item.is_object() && item.get_object().contains( "id" ) )
+            id = item.get_object()[ "id" ];
+         item_reply = error_reply( id, -32600, "Invalid request", e );
+      }
 
-               return reply;
+      if( !item_reply )
+         continue;
+      if( !empty )
+         reply += ',';
+      reply += *item_reply;
+      empty = false;
+   }
+   reply += ']';
+
+   // A batch of notifications gets no reply at all
+   if( empty )
+      return string();
+   if( send_message )
+      _connection.send_message( reply );
+   return reply;
+}
+
+std::string websocket_api_connection::on_message(
+   const std::string& message,
+   bool send_message /* = true */ )
+{
+   bool parsed = false;
+   try
+   {
+      auto var = fc::json::from_string(message);
+      parsed = true;
+      if( var.is_array() )
+         return on_batch( var.get_array(), send_message );
+
+      const auto& var_obj = var.get_object();
+      if( var_obj.contains( "method" ) )
+      {
+         auto reply = handle_call( var.as<fc::rpc::request>() );
+         if( reply )
+         {
+            if( send_message )
+               _connection.send_message( *reply );
+            return *reply;
          }
       }
       else
@@ -148,7 +247,11 @@ std::string websocket_api_connection::on_message(
    catch ( const fc::exception& e )
    {
       wdump((e.to_detail_string()));
-      return e.to_detail_string();
+      std::string reply = parsed ? error_reply( variant(), -32600, "Invalid request", e )
+                                 : error_reply( variant(), -32700, "Parse error", e );
+      if( send_message )
+         _connection.send_message( reply );
+      return reply;
    }
    return string();
 }
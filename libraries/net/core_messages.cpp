@@ -23,6 +23,8 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene { namespace net {
 
@@ -45,6 +47,24 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum get_block_transactions_message::type          = core_message_type_enum::get_block_transactions_message_type;
+  const core_message_type_enum block_transactions_message::type              = core_message_type_enum::block_transactions_message_type;
+
+  uint64_t compact_short_id( const transaction_id_type& id )
+  {
+    uint64_t short_id;
+    memcpy( &short_id, id.data(), sizeof(short_id) );
+    return short_id;
+  }
+
+  compact_block_message::compact_block_message(const signed_block& block) :
+    header(block)
+  {
+    short_ids.reserve( block.transactions.size() );
+    for( const signed_transaction& trx : block.transactions )
+      short_ids.push_back( compact_short_id( trx.id() ) );
+  }
 
 } } // graphene::net
 
@@ -56,6 +56,13 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * Queued messages are sent to a peer in batches of about this many bytes, encrypted
+ * together into as few socket writes as possible.  A batch ends with the message that
+ * takes it to this size, however large that message is.
+ */
+#define GRAPHENE_NET_MAX_SEND_BATCH_SIZE                     (64 * 1024)
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -102,3 +109,9 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * Compact blocks a peer may have waiting for their missing transactions.  Each
+ * one answers a block request, so this is only reached if a peer misbehaves.
+ */
+#define GRAPHENE_NET_MAX_COMPACT_BLOCKS_IN_PROGRESS          4
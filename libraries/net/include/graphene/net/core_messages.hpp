@@ -44,6 +44,7 @@ namespace graphene { namespace net {
   using sigmaengine::protocol::block_id_type;
   using sigmaengine::protocol::transaction_id_type;
   using sigmaengine::protocol::signed_block;
+  using sigmaengine::protocol::signed_block_header;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +87,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    get_block_transactions_message_type          = 5019,
+    block_transactions_message_type              = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -115,6 +119,57 @@ namespace graphene { namespace net {
 
    };
 
+  /**
+   * The short id of a transaction in a compact_block_message: the first 8 bytes of its
+   * transaction id.  Ids that collide are caught by the merkle root check when the block
+   * is rebuilt, and the receiver then fetches all of the block's transactions.
+   */
+  uint64_t compact_short_id( const transaction_id_type& id );
+
+  /**
+   * Sent instead of a block_message in reply to a fetch_items_message for
+   * compact_block_message_type, which we only send to peers that set "compact_blocks"
+   * in their hello.  The receiver rebuilds the block from the transactions it has
+   * already seen and asks for the others with a get_block_transactions_message.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    compact_block_message() {}
+    compact_block_message(const signed_block& block);
+
+    signed_block_header   header;
+    std::vector<uint64_t> short_ids; /// compact_short_id of each transaction, in block order
+  };
+
+  struct get_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type         block_id;
+    std::vector<uint32_t> indexes; /// positions of the transactions in the block, ascending
+
+    get_block_transactions_message() {}
+    get_block_transactions_message(const block_id_type& block_id, std::vector<uint32_t> indexes) :
+      block_id(block_id),
+      indexes(std::move(indexes))
+    {}
+  };
+
+  struct block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    block_id_type                   block_id;
+    std::vector<signed_transaction> transactions; /// in the order they were requested, empty if the block is unknown
+
+    block_transactions_message() {}
+    block_transactions_message(const block_id_type& block_id) :
+      block_id(block_id)
+    {}
+  };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -421,10 +476,16 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (get_block_transactions_message_type)
+                 (block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
 FC_REFLECT( graphene::net::block_message, (block)(block_id) )
+FC_REFLECT( graphene::net::compact_block_message, (header)(short_ids) )
+FC_REFLECT( graphene::net::get_block_transactions_message, (block_id)(indexes) )
+FC_REFLECT( graphene::net::block_transactions_message, (block_id)(transactions) )
 
 FC_REFLECT( graphene::net::item_id, (item_type)
                                (item_hash) )
@@ -29,6 +29,9 @@
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <cstring>
+#include <memory>
+
 namespace graphene { namespace net {
 
   /**
@@ -108,6 +111,61 @@ namespace graphene { namespace net {
      }
   };
 
+  /**
+   *  A message as it goes on the wire: header, body and zero padding up to a multiple
+   *  of 16 bytes for the cipher.  It is immutable once built, so a message sent to
+   *  many peers is padded once and the same buffer is queued on every connection.
+   */
+  class padded_message
+  {
+     public:
+        explicit padded_message( const message& m )
+        :_size( 16 * ( ( sizeof(message_header) + m.size + 15 ) / 16 ) ),
+         _bytes( new char[_size] )
+        {
+           memcpy( _bytes.get(), (const char*)&m, sizeof(message_header) );
+           memcpy( _bytes.get() + sizeof(message_header), m.data.data(), m.size );
+           memset( _bytes.get() + sizeof(message_header) + m.size, 0, _size - sizeof(message_header) - m.size );
+        }
+
+        const message_header& header()const { return *(const message_header*)_bytes.get(); }
+
+        /// the padded bytes, a multiple of 16 long
+        const char* data()const { return _bytes.get(); }
+        size_t      size()const { return _size; }
+
+        message to_message()const
+        {
+           message m;
+           (message_header&)m = header();
+           m.data.assign( _bytes.get() + sizeof(message_header), _bytes.get() + sizeof(message_header) + m.size );
+           return m;
+        }
+
+        /// @see message::as
+        template<typename T>
+        T as()const
+        {
+           try {
+              FC_ASSERT( header().msg_type == T::type );
+              T tmp;
+              fc::datastream<const char*> ds( _bytes.get() + sizeof(message_header), header().size );
+              fc::raw::unpack( ds, tmp );
+              return tmp;
+           } FC_RETHROW_EXCEPTIONS( warn,
+                 "error unpacking network message as a '${type}'  ${x} !=? ${msg_type}",
+                 ("type", fc::get_typename<T>::name() )
+                 ("x", T::type)
+                 ("msg_type", header().msg_type)
+                 );
+        }
+
+     private:
+        size_t                  _size;
+        std::unique_ptr<char[]> _bytes;
+  };
+  typedef std::shared_ptr<const padded_message> padded_message_ptr;
+
 
 
 
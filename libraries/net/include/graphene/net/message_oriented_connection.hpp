@@ -52,6 +52,8 @@ namespace graphene { namespace net {
        void connect_to(const fc::ip::endpoint& remote_endpoint);
 
        void send_message(const message& message_to_send);
+       /** writes the messages in order, encrypted into as few socket writes as possible */
+       void send_messages(const std::vector<padded_message_ptr>& messages_to_send);
        void close_connection();
        void destroy_connection();
 
@@ -61,6 +63,10 @@ namespace graphene { namespace net {
        fc::time_point get_last_message_received_time() const;
        fc::time_point get_connection_time() const;
        fc::sha512     get_shared_secret() const;
+
+       /// switch one direction of the socket to AES-GCM records, @see stcp_socket
+       void           start_aead_send();
+       void           start_aead_receive();
      private:
        std::unique_ptr<detail::message_oriented_connection_impl> my;
   };
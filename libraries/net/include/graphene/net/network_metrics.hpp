@@ -0,0 +1,135 @@
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
+
+#include <fc/network/ip.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace net {
+
+   /** Messages and their bytes on the wire, header and padding included */
+   struct message_traffic
+   {
+      uint64_t messages = 0;
+      uint64_t bytes = 0;
+
+      void record( uint64_t message_bytes ) { ++messages; bytes += message_bytes; }
+   };
+
+   /** Traffic in each direction, by message type */
+   struct traffic_counters
+   {
+      std::map< uint32_t, message_traffic > received;
+      std::map< uint32_t, message_traffic > sent;
+
+      void record_received( const message_header& header );
+      void record_sent( const message_header& header );
+   };
+
+   /** Bytes a message takes on the wire: the header and the body padded to 16 bytes */
+   inline uint64_t wire_size( const message_header& header )
+   {
+      return 16 * ( ( sizeof( message_header ) + header.size + 15 ) / 16 );
+   }
+
+   /**
+    *  Counts of observations by upper bound, in milliseconds.  counts has one entry per
+    *  bound plus one for everything above the last bound; the counts are not cumulative.
+    */
+   struct latency_histogram
+   {
+      std::vector< uint32_t > bucket_bounds_ms;
+      std::vector< uint64_t > counts;
+      uint64_t                count = 0;
+      uint64_t                sum_ms = 0;
+
+      latency_histogram() : counts( 1, 0 ) {}
+      explicit latency_histogram( std::vector< uint32_t > bounds_ms );
+
+      void record( int64_t ms );
+   };
+
+   /** Execution time of calls from the p2p code into the node delegate, in microseconds */
+   struct delegate_call_metrics
+   {
+      uint64_t calls = 0;
+      int64_t  total_us = 0;
+      int64_t  max_us = 0;
+      double   recent_mean_us = 0;
+   };
+
+   struct peer_traffic_metrics
+   {
+      fc::ip::endpoint                          endpoint;
+      std::string                               direction;
+      uint64_t                                  bytes_received = 0;
+      uint64_t                                  bytes_sent = 0;
+      uint64_t                                  messages_received = 0;
+      uint64_t                                  messages_sent = 0;
+      std::map< std::string, message_traffic >  received_by_type;
+      std::map< std::string, message_traffic >  sent_by_type;
+      uint32_t                                  queued_messages = 0;
+      uint64_t                                  queued_bytes = 0;
+      bool                                      syncing_from_peer = false;
+   };
+
+   struct sync_metrics
+   {
+      bool     synchronizing = false;
+      uint32_t peers_syncing_from = 0;
+      uint32_t head_block_number = 0;
+      uint32_t items_to_fetch = 0;          ///< block ids we know of but have not requested yet
+      uint32_t blocks_requested = 0;        ///< requested from peers and not yet received
+      uint32_t blocks_waiting = 0;          ///< received, waiting for an earlier block or to be pushed
+   };
+
+   /**
+    *  Traffic since the node started, including peers no longer connected, the traffic
+    *  of each connected peer, sync progress and where block handling time goes.
+    */
+   struct network_metrics
+   {
+      uint64_t                                  bytes_received = 0;
+      uint64_t                                  bytes_sent = 0;
+      uint64_t                                  messages_received = 0;
+      uint64_t                                  messages_sent = 0;
+      std::map< std::string, message_traffic >  received_by_type;
+      std::map< std::string, message_traffic >  sent_by_type;
+      std::vector< peer_traffic_metrics >       peers;
+      sync_metrics                              sync;
+      delegate_call_metrics                     handle_block;
+      delegate_call_metrics                     handle_transaction;
+      /// from a block's timestamp to when we received it, for blocks received outside of sync
+      latency_histogram                         block_propagation_ms;
+      /// from receiving a block to having it accepted by the delegate
+      latency_histogram                         block_validation_ms;
+   };
+
+   /// Sums the traffic by type into totals and name-keyed maps
+   void summarize_traffic( const traffic_counters& counters,
+                           uint64_t& bytes_received, uint64_t& bytes_sent,
+                           uint64_t& messages_received, uint64_t& messages_sent,
+                           std::map< std::string, message_traffic >& received_by_type,
+                           std::map< std::string, message_traffic >& sent_by_type );
+
+   /** Formats the metrics in the Prometheus text exposition format, names prefixed "p2p_" */
+   std::string to_prometheus_text( const network_metrics& metrics );
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::message_traffic, (messages)(bytes) )
+FC_REFLECT( graphene::net::latency_histogram, (bucket_bounds_ms)(counts)(count)(sum_ms) )
+FC_REFLECT( graphene::net::delegate_call_metrics, (calls)(total_us)(max_us)(recent_mean_us) )
+FC_REFLECT( graphene::net::peer_traffic_metrics,
+            (endpoint)(direction)(bytes_received)(bytes_sent)(messages_received)(messages_sent)
+            (received_by_type)(sent_by_type)(queued_messages)(queued_bytes)(syncing_from_peer) )
+FC_REFLECT( graphene::net::sync_metrics,
+            (synchronizing)(peers_syncing_from)(head_block_number)(items_to_fetch)(blocks_requested)(blocks_waiting) )
+FC_REFLECT( graphene::net::network_metrics,
+            (bytes_received)(bytes_sent)(messages_received)(messages_sent)(received_by_type)(sent_by_type)
+            (peers)(sync)(handle_block)(handle_transaction)(block_propagation_ms)(block_validation_ms) )
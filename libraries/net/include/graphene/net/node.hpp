@@ -25,6 +25,7 @@
 
 #include <graphene/net/core_messages.hpp>
 #include <graphene/net/message.hpp>
+#include <graphene/net/network_metrics.hpp>
 #include <graphene/net/peer_database.hpp>
 
 #include <sigmaengine/protocol/types.hpp>
@@ -290,6 +291,8 @@ namespace graphene { namespace net {
 
         void disable_peer_advertising();
         fc::variant_object get_call_statistics() const;
+        /** Traffic by message type and peer, sync progress and block timings */
+        network_metrics get_network_metrics() const;
       private:
         std::unique_ptr<detail::node_impl, detail::node_impl_deleter> my;
    };
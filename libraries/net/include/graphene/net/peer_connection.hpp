@@ -40,6 +40,8 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <list>
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -68,7 +70,9 @@ namespace graphene { namespace net
       virtual void on_message(peer_connection* originating_peer,
                               const message& received_message) = 0;
       virtual void on_connection_closed(peer_connection* originating_peer) = 0;
-      virtual message get_message_for_item(const item_id& item) = 0;
+      virtual padded_message_ptr get_message_for_item(const item_id& item) = 0;
+      virtual void on_messages_sent(peer_connection* originating_peer,
+                                    const std::vector<padded_message_ptr>& sent_messages) = 0;
     };
 
     class peer_connection;
@@ -118,12 +122,13 @@ namespace graphene { namespace net
         fc::time_point enqueue_time;
         fc::time_point transmission_start_time;
         fc::time_point transmission_finish_time;
+        bool           start_aead_send_after = false; // switch the connection to AES-GCM once this is sent
 
         queued_message(fc::time_point enqueue_time = fc::time_point::now()) :
           enqueue_time(enqueue_time)
         {}
 
-        virtual message get_message(peer_connection_delegate* node) = 0;
+        virtual padded_message_ptr get_message(peer_connection_delegate* node) = 0;
         /** returns roughly the number of bytes of memory the message is consuming while
          * it is sitting on the queue
          */
@@ -131,21 +136,34 @@ namespace graphene { namespace net
         virtual ~queued_message() {}
       };
 
-      /* when you queue up a 'real_queued_message', a full copy of the message is
-       * stored on the heap until it is sent
+      /* when you queue up a 'real_queued_message', the padded message is stored on
+       * the heap until it is sent.  The buffer may be shared with the queues of other
+       * peers, except for messages that get the send time patched in, which are
+       * padded when they reach the top of the queue.
        */
       struct real_queued_message : queued_message
       {
-        message        message_to_send;
-        size_t         message_send_time_field_offset;
+        padded_message_ptr padded_message_to_send;
+        message            message_to_send;
+        size_t             message_send_time_field_offset;
 
         real_queued_message(message message_to_send,
                             size_t message_send_time_field_offset = (size_t)-1) :
           message_to_send(std::move(message_to_send)),
           message_send_time_field_offset(message_send_time_field_offset)
+        {
+          if (message_send_time_field_offset == (size_t)-1)
+          {
+            padded_message_to_send = std::make_shared<padded_message>(this->message_to_send);
+            this->message_to_send.data = std::vector<char>();
+          }
+        }
+        real_queued_message(padded_message_ptr padded_message_to_send) :
+          padded_message_to_send(std::move(padded_message_to_send)),
+          message_send_time_field_offset((size_t)-1)
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        padded_message_ptr get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
@@ -161,13 +179,13 @@ namespace graphene { namespace net
           item_to_send(std::move(item_to_send))
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        padded_message_ptr get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
 
       size_t _total_queued_messages_size = 0;
-      std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message> > > _queued_messages;
+      std::list<std::unique_ptr<queued_message> > _queued_messages;
       fc::future<void> _send_queued_messages_done;
     public:
       fc::time_point connection_initiation_time;
@@ -188,6 +206,8 @@ namespace graphene { namespace net
       fc::oexception connection_closed_error;
 
       fc::time_point get_connection_time()const { return _message_connection.get_connection_time(); }
+
+      traffic_counters traffic; /// messages and bytes exchanged with this peer, by message type
       fc::time_point get_connection_terminated_time()const { return connection_terminated_time; }
 
       /// data about the peer node
@@ -204,6 +224,9 @@ namespace graphene { namespace net
       fc::optional<std::string> platform;
       fc::optional<uint32_t> bitness;
       fc::optional<sigmaengine::protocol::chain_id_type> chain_id;
+      bool             supports_compact_blocks = false; /// set by "compact_blocks" in the hello user_data
+      bool             supports_aead_channel = false;   /// set by "aead_channel" in the hello user_data
+      bool             offered_aead_channel = false;    /// whether our hello to this peer had "aead_channel"
 
       // for inbound connections, these fields record what the peer sent us in
       // its hello message.  For outbound, they record what we sent the peer
@@ -251,6 +274,15 @@ namespace graphene { namespace net
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /** a block received as a compact_block_message, waiting for the transactions we asked this peer for */
+      struct compact_block_in_progress
+      {
+        signed_block          block; /// transactions at missing_indexes are still empty
+        std::vector<uint32_t> missing_indexes;
+        fc::time_point        received_time; /// dropped once this is older than the request timeout
+      };
+      std::map<block_id_type, compact_block_in_progress> compact_blocks_in_progress;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -284,12 +316,15 @@ namespace graphene { namespace net
 
       void send_queueable_message(std::unique_ptr<queued_message>&& message_to_send);
       void send_message(const message& message_to_send, size_t message_send_time_field_offset = (size_t)-1);
+      void send_message(const padded_message_ptr& message_to_send);
       void send_item(const item_id& item_to_send);
       void close_connection();
       void destroy_connection();
 
       uint64_t get_total_bytes_sent() const;
       uint64_t get_total_bytes_received() const;
+      size_t get_queued_message_count() const;
+      size_t get_total_queued_messages_size() const;
 
       fc::time_point get_last_message_sent_time() const;
       fc::time_point get_last_message_received_time() const;
@@ -304,6 +339,10 @@ namespace graphene { namespace net
 
       bool is_transaction_fetching_inhibited() const;
       fc::sha512 get_shared_secret() const;
+      /** After the queued messages are sent, everything else we send is AES-GCM encrypted */
+      void start_aead_send_after_queued_messages();
+      /** Called between two messages read from the peer: the next ones are AES-GCM encrypted */
+      void start_aead_receive();
       void clear_old_inventory();
       bool is_inventory_advertised_to_us_list_full_for_transactions() const;
       bool is_inventory_advertised_to_us_list_full() const;
@@ -31,6 +31,12 @@ namespace graphene { namespace net {
 /**
  *  Uses ECDH to negotiate a aes key for communicating
  *  with other nodes on the network.
+ *
+ *  The connection starts out with AES-256-CBC over the raw stream.  Once both peers
+ *  have said they support it, each direction can be switched to AES-256-GCM records:
+ *  a 4 byte little endian length, authenticated but not encrypted, the ciphertext
+ *  and a 16 byte tag.  Each direction has its own key, derived from the shared secret
+ *  and which side connected, and records hold at most max_aead_record_size bytes.
  */
 class stcp_socket : public virtual fc::iostream
 {
@@ -50,14 +56,32 @@ class stcp_socket : public virtual fc::iostream
     virtual size_t   writesome( const char* buffer, size_t len );
     virtual size_t   writesome( const std::shared_ptr<const char>& buf, size_t len, size_t offset );
 
+    /**
+     *  Encrypts the buffers, each a multiple of 16 bytes long, back to back and writes
+     *  them in chunks of up to 64 KiB, so that many small messages take one socket write.
+     */
+    void             write_buffers( const std::vector< std::pair< const char*, size_t > >& buffers );
+
     virtual void     flush();
     virtual void     close();
 
     using istream::get;
     void             get( char& c ) { read( &c, 1 ); }
     fc::sha512       get_shared_secret() const { return _shared_secret; }
+
+    enum { max_aead_record_size = 64 * 1024 };
+
+    /** Everything written after this call is sent as AES-256-GCM records */
+    void             start_aead_send();
+    /** Everything read after this call is expected to be AES-256-GCM records */
+    void             start_aead_receive();
+    bool             is_aead_sending()const { return _aead_sending; }
+    bool             is_aead_receiving()const { return _aead_receiving; }
   private:
     void do_key_exchange();
+    fc::sha256 aead_key( bool for_connector_to_acceptor )const;
+    void write_aead_records( const std::vector< std::pair< const char*, size_t > >& buffers );
+    size_t read_aead( char* buffer, size_t len );
 
     fc::sha512           _shared_secret;
     fc::ecc::private_key _priv_key;
@@ -68,6 +92,19 @@ class stcp_socket : public virtual fc::iostream
     fc::aes_decoder      _recv_aes;
     std::shared_ptr<char> _read_buffer;
     std::shared_ptr<char> _write_buffer;
+    std::shared_ptr<char> _batch_write_buffer;
+
+    bool                  _is_connector = false;
+    bool                  _aead_sending = false;
+    bool                  _aead_receiving = false;
+    fc::aes_gcm_encoder   _send_gcm;
+    fc::aes_gcm_decoder   _recv_gcm;
+    std::shared_ptr<char> _aead_read_buffer;    // ciphertext read ahead of the record being decrypted
+    size_t                _aead_read_begin = 0;
+    size_t                _aead_read_end = 0;
+    std::shared_ptr<char> _record_buffer;       // one decrypted record being handed out to readers
+    size_t                _record_size = 0;
+    size_t                _record_consumed = 0;
 #ifndef NDEBUG
     bool _read_buffer_in_use;
     bool _write_buffer_in_use;
@@ -80,6 +80,7 @@ namespace graphene { namespace net {
       ~message_oriented_connection_impl();
 
       void send_message(const message& message_to_send);
+      void send_messages(const std::vector<padded_message_ptr>& messages_to_send);
       void close_connection();
       void destroy_connection();
 
@@ -90,6 +91,8 @@ namespace graphene { namespace net {
       fc::time_point get_last_message_received_time() const;
       fc::time_point get_connection_time() const { return _connected_time; }
       fc::sha512 get_shared_secret() const;
+      void start_aead_send();
+      void start_aead_receive();
     };
 
     message_oriented_connection_impl::message_oriented_connection_impl(message_oriented_connection* self,
@@ -229,6 +232,14 @@ namespace graphene { namespace net {
     void message_oriented_connection_impl::send_message(const message& message_to_send)
     {
       VERIFY_CORRECT_THREAD();
+      if( message_to_send.size > MAX_MESSAGE_SIZE )
+         elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+      send_messages(std::vector<padded_message_ptr>{std::make_shared<padded_message>(message_to_send)});
+    }
+
+    void message_oriented_connection_impl::send_messages(const std::vector<padded_message_ptr>& messages_to_send)
+    {
+      VERIFY_CORRECT_THREAD();
 #if 0 // this gets too verbose
 #ifndef NDEBUG
       fc::optional<fc::ip::endpoint> remote_endpoint;
@@ -255,22 +266,20 @@ namespace graphene { namespace net {
 
       try
       {
-        size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
-        if( message_to_send.size > MAX_MESSAGE_SIZE )
-           elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-        //pad the message we send to a multiple of 16 bytes
-        size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
-        size_t toClean = size_with_padding - size_of_message_and_header;
-        memset(paddingSpace, 0, toClean);
-
-        _sock.write(padded_message.get(), size_with_padding);
+        // the messages are already padded to a multiple of 16 bytes and may be shared
+        // with other connections, so they are encrypted straight out of their buffers
+        std::vector<std::pair<const char*, size_t> > buffers;
+        buffers.reserve(messages_to_send.size());
+        size_t total_size = 0;
+        for (const padded_message_ptr& padded : messages_to_send)
+        {
+          buffers.emplace_back(padded->data(), padded->size());
+          total_size += padded->size();
+        }
+
+        _sock.write_buffers(buffers);
         _sock.flush();
-        _bytes_sent += size_with_padding;
+        _bytes_sent += total_size;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
@@ -339,6 +348,20 @@ namespace graphene { namespace net {
       return _sock.get_shared_secret();
     }
 
+    void message_oriented_connection_impl::start_aead_send()
+    {
+      VERIFY_CORRECT_THREAD();
+      // callers switch between messages, never while one is being written
+      assert(!_send_message_in_progress);
+      _sock.start_aead_send();
+    }
+
+    void message_oriented_connection_impl::start_aead_receive()
+    {
+      VERIFY_CORRECT_THREAD();
+      _sock.start_aead_receive();
+    }
+
   } // end namespace graphene::net::detail
 
 
@@ -376,6 +399,11 @@ namespace graphene { namespace net {
     my->send_message(message_to_send);
   }
 
+  void message_oriented_connection::send_messages(const std::vector<padded_message_ptr>& messages_to_send)
+  {
+    my->send_messages(messages_to_send);
+  }
+
   void message_oriented_connection::close_connection()
   {
     my->close_connection();
@@ -413,5 +441,13 @@ namespace graphene { namespace net {
   {
     return my->get_shared_secret();
   }
+  void message_oriented_connection::start_aead_send()
+  {
+    my->start_aead_send();
+  }
+  void message_oriented_connection::start_aead_receive()
+  {
+    my->start_aead_receive();
+  }
 
 } } // end namespace graphene::net
@@ -0,0 +1,173 @@
+#include <graphene/net/network_metrics.hpp>
+
+#include <fc/string.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace graphene { namespace net {
+
+   namespace {
+
+      /// "trx_message_type" -> "trx", and the number for types this build does not know
+      std::string message_type_name( uint32_t msg_type )
+      {
+         std::string name = fc::reflector< core_message_type_enum >::to_fc_string( msg_type );
+         const std::string suffix = "_message_type";
+         if( name.size() > suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+            name.erase( name.size() - suffix.size() );
+         return name;
+      }
+
+      void add_traffic( const std::map< uint32_t, message_traffic >& by_type, uint64_t& bytes, uint64_t& messages,
+                        std::map< std::string, message_traffic >& by_name )
+      {
+         for( const auto& entry : by_type )
+         {
+            bytes += entry.second.bytes;
+            messages += entry.second.messages;
+            message_traffic& named = by_name[ message_type_name( entry.first ) ];
+            named.bytes += entry.second.bytes;
+            named.messages += entry.second.messages;
+         }
+      }
+
+      std::string escape_label( const std::string& value )
+      {
+         std::string escaped;
+         for( char c : value )
+         {
+            if( c == '\\' || c == '"' )
+               escaped += '\\';
+            if( c == '\n' )
+            {
+               escaped += "\\n";
+               continue;
+            }
+            escaped += c;
+         }
+         return escaped;
+      }
+
+      void write_header( std::ostream& out, const char* name, const char* type, const char* help )
+      {
+         out << "# HELP " << name << ' ' << help << "\n"
+             << "# TYPE " << name << ' ' << type << "\n";
+      }
+
+      void write_traffic( std::ostream& out, const char* name,
+                          const std::map< std::string, message_traffic >& by_type, bool bytes )
+      {
+         for( const auto& entry : by_type )
+            out << name << "{type=\"" << escape_label( entry.first ) << "\"} "
+                << ( bytes ? entry.second.bytes : entry.second.messages ) << "\n";
+      }
+
+      void write_histogram( std::ostream& out, const char* name, const char* help, const latency_histogram& histogram )
+      {
+         write_header( out, name, "histogram", help );
+         uint64_t cumulative = 0;
+         for( size_t i = 0; i < histogram.bucket_bounds_ms.size(); ++i )
+         {
+            cumulative += histogram.counts[i];
+            out << name << "_bucket{le=\"" << double( histogram.bucket_bounds_ms[i] ) / 1000 << "\"} " << cumulative << "\n";
+         }
+         out << name << "_bucket{le=\"+Inf\"} " << histogram.count << "\n"
+             << name << "_sum " << double( histogram.sum_ms ) / 1000 << "\n"
+             << name << "_count " << histogram.count << "\n";
+      }
+
+      void write_delegate_calls( std::ostream& out, const char* name, const char* help, const delegate_call_metrics& calls )
+      {
+         write_header( out, name, "summary", help );
+         out << name << "_sum " << double( calls.total_us ) / 1000000 << "\n"
+             << name << "_count " << calls.calls << "\n";
+      }
+
+   }
+
+   void traffic_counters::record_received( const message_header& header )
+   {
+      received[ header.msg_type ].record( wire_size( header ) );
+   }
+
+   void traffic_counters::record_sent( const message_header& header )
+   {
+      sent[ header.msg_type ].record( wire_size( header ) );
+   }
+
+   latency_histogram::latency_histogram( std::vector< uint32_t > bounds_ms )
+   :bucket_bounds_ms( std::move( bounds_ms ) ), counts( bucket_bounds_ms.size() + 1, 0 )
+   {}
+
+   void latency_histogram::record( int64_t ms )
+   {
+      ms = std::max< int64_t >( ms, 0 );
+      auto bucket = std::lower_bound( bucket_bounds_ms.begin(), bucket_bounds_ms.end(), uint64_t( ms ) );
+      ++counts[ bucket - bucket_bounds_ms.begin() ];
+      ++count;
+      sum_ms += ms;
+   }
+
+   void summarize_traffic( const traffic_counters& counters,
+                           uint64_t& bytes_received, uint64_t& bytes_sent,
+                           uint64_t& messages_received, uint64_t& messages_sent,
+                           std::map< std::string, message_traffic >& received_by_type,
+                           std::map< std::string, message_traffic >& sent_by_type )
+   {
+      add_traffic( counters.received, bytes_received, messages_received, received_by_type );
+      add_traffic( counters.sent, bytes_sent, messages_sent, sent_by_type );
+   }
+
+   std::string to_prometheus_text( const network_metrics& metrics )
+   {
+      std::ostringstream out;
+
+      write_header( out, "p2p_received_bytes_total", "counter", "Bytes received from peers, by message type" );
+      write_traffic( out, "p2p_received_bytes_total", metrics.received_by_type, true );
+      write_header( out, "p2p_sent_bytes_total", "counter", "Bytes sent to peers, by message type" );
+      write_traffic( out, "p2p_sent_bytes_total", metrics.sent_by_type, true );
+      write_header( out, "p2p_received_messages_total", "counter", "Messages received from peers, by message type" );
+      write_traffic( out, "p2p_received_messages_total", metrics.received_by_type, false );
+      write_header( out, "p2p_sent_messages_total", "counter", "Messages sent to peers, by message type" );
+      write_traffic( out, "p2p_sent_messages_total", metrics.sent_by_type, false );
+
+      write_header( out, "p2p_connected_peers", "gauge", "Peers with an open connection" );
+      out << "p2p_connected_peers " << metrics.peers.size() << "\n";
+
+      write_header( out, "p2p_peer_received_bytes_total", "counter", "Bytes received from each connected peer" );
+      for( const peer_traffic_metrics& peer : metrics.peers )
+         out << "p2p_peer_received_bytes_total{peer=\"" << escape_label( std::string( peer.endpoint ) ) << "\"} " << peer.bytes_received << "\n";
+      write_header( out, "p2p_peer_sent_bytes_total", "counter", "Bytes sent to each connected peer" );
+      for( const peer_traffic_metrics& peer : metrics.peers )
+         out << "p2p_peer_sent_bytes_total{peer=\"" << escape_label( std::string( peer.endpoint ) ) << "\"} " << peer.bytes_sent << "\n";
+      write_header( out, "p2p_peer_queued_messages", "gauge", "Messages waiting in each peer's send queue" );
+      for( const peer_traffic_metrics& peer : metrics.peers )
+         out << "p2p_peer_queued_messages{peer=\"" << escape_label( std::string( peer.endpoint ) ) << "\"} " << peer.queued_messages << "\n";
+      write_header( out, "p2p_peer_queued_bytes", "gauge", "Bytes waiting in each peer's send queue" );
+      for( const peer_traffic_metrics& peer : metrics.peers )
+         out << "p2p_peer_queued_bytes{peer=\"" << escape_label( std::string( peer.endpoint ) ) << "\"} " << peer.queued_bytes << "\n";
+
+      write_header( out, "p2p_synchronizing", "gauge", "1 while fetching blocks from peers that are ahead of us" );
+      out << "p2p_synchronizing " << ( metrics.sync.synchronizing ? 1 : 0 ) << "\n";
+      write_header( out, "p2p_head_block_number", "gauge", "Head block number of the local chain" );
+      out << "p2p_head_block_number " << metrics.sync.head_block_number << "\n";
+      write_header( out, "p2p_sync_items_to_fetch", "gauge", "Blocks known from peers and not yet requested" );
+      out << "p2p_sync_items_to_fetch " << metrics.sync.items_to_fetch << "\n";
+      write_header( out, "p2p_sync_blocks_requested", "gauge", "Sync blocks requested and not yet received" );
+      out << "p2p_sync_blocks_requested " << metrics.sync.blocks_requested << "\n";
+      write_header( out, "p2p_sync_blocks_waiting", "gauge", "Sync blocks received and not yet pushed" );
+      out << "p2p_sync_blocks_waiting " << metrics.sync.blocks_waiting << "\n";
+
+      write_delegate_calls( out, "p2p_handle_block_seconds", "Time spent pushing blocks to the chain", metrics.handle_block );
+      write_delegate_calls( out, "p2p_handle_transaction_seconds", "Time spent pushing transactions to the chain", metrics.handle_transaction );
+
+      write_histogram( out, "p2p_block_propagation_seconds", "From a block's timestamp to its arrival, outside of sync",
+                       metrics.block_propagation_ms );
+      write_histogram( out, "p2p_block_validation_seconds", "From a block's arrival to its acceptance by the chain",
+                       metrics.block_validation_ms );
+
+      return out.str();
+   }
+
+} } // graphene::net
@@ -132,7 +132,7 @@ namespace graphene { namespace net {
       struct message_info
       {
         message_hash_type message_hash;
-        message           message_body;
+        padded_message_ptr padded_message_body; // padded once, shared by the send queues of every peer
         uint32_t          block_clock_when_received;
 
         // for network performance stats
@@ -145,7 +145,7 @@ namespace graphene { namespace net {
                       const message_propagation_data& propagation_data,
                       fc::uint160_t            message_contents_hash ) :
           message_hash( message_hash ),
-          message_body( message_body ),
+          padded_message_body( std::make_shared<padded_message>( message_body ) ),
           block_clock_when_received( block_clock_when_received ),
           propagation_data( propagation_data ),
           message_contents_hash( message_contents_hash )
@@ -172,8 +172,12 @@ namespace graphene { namespace net {
       void block_accepted();
       void cache_message( const message& message_to_cache, const message_hash_type& hash_of_message_to_cache,
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
-      message get_message( const message_hash_type& hash_of_message_to_lookup );
+      padded_message_ptr get_message( const message_hash_type& hash_of_message_to_lookup,
+                                      fc::uint160_t* hash_of_message_contents = nullptr );
+      padded_message_ptr find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup,
+                                                        uint32_t msg_type ) const;
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<signed_transaction> find_transaction_by_short_id( uint64_t short_id ) const;
       size_t size() const { return _message_cache.size(); }
     };
 
@@ -197,15 +201,31 @@ namespace graphene { namespace net {
                                          message_content_hash ) );
     }
 
-    message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
+    padded_message_ptr blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup,
+                                                                   fc::uint160_t* hash_of_message_contents )
     {
       message_cache_container::index<message_hash_index>::type::const_iterator iter =
          _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
       if( iter != _message_cache.get<message_hash_index>().end() )
-        return iter->message_body;
+      {
+        if( hash_of_message_contents )
+          *hash_of_message_contents = iter->message_contents_hash;
+        return iter->padded_message_body;
+      }
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    padded_message_ptr blockchain_tied_message_cache::find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup,
+                                                                                     uint32_t msg_type ) const
+    {
+      const auto& contents_index = _message_cache.get<message_contents_hash_index>();
+      for( auto iter = contents_index.find( hash_of_message_contents_to_lookup );
+           iter != contents_index.end() && iter->message_contents_hash == hash_of_message_contents_to_lookup; ++iter )
+        if( iter->padded_message_body->header().msg_type == msg_type )
+          return iter->padded_message_body;
+      return padded_message_ptr();
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
@@ -218,6 +238,20 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction_by_short_id( uint64_t short_id ) const
+    {
+      // short ids are the leading bytes of the transaction id, and the contents hash index
+      // orders ids bytewise, so every candidate sits right after the zero-padded short id
+      fc::uint160_t lowest_matching_id;
+      memcpy( lowest_matching_id.data(), &short_id, sizeof(short_id) );
+      const auto& contents_index = _message_cache.get<message_contents_hash_index>();
+      for( auto iter = contents_index.lower_bound( lowest_matching_id );
+           iter != contents_index.end() && compact_short_id( iter->message_contents_hash ) == short_id; ++iter )
+        if( iter->padded_message_body->header().msg_type == trx_message_type )
+          return iter->padded_message_body->as<trx_message>().trx;
+      return fc::optional<signed_transaction>();
+    }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // This specifies configuration info for the local node.  It's stored as JSON
@@ -304,6 +338,8 @@ namespace graphene { namespace net { namespace detail {
       BOOST_PP_SEQ_FOR_EACH(DECLARE_ACCUMULATOR, unused, NODE_DELEGATE_METHOD_NAMES)
 #undef DECLARE_ACCUMULATOR
 
+      static delegate_call_metrics summarize_calls(const call_stats_accumulator& execution_accumulator);
+
       class call_statistics_collector
       {
       private:
@@ -374,6 +410,8 @@ namespace graphene { namespace net { namespace detail {
       statistics_gathering_node_delegate_wrapper(node_delegate* delegate, fc::thread* thread_for_delegate_calls);
 
       fc::variant_object get_call_statistics();
+      delegate_call_metrics get_handle_block_metrics() const;
+      delegate_call_metrics get_handle_transaction_metrics() const;
 
       bool has_item( const net::item_id& id ) override;
       void handle_message( const message& ) override;
@@ -566,6 +604,12 @@ namespace graphene { namespace net { namespace detail {
       unsigned _maximum_number_of_blocks_to_handle_at_one_time;
       unsigned _maximum_number_of_sync_blocks_to_prefetch;
       unsigned _maximum_blocks_per_peer_during_syncing;
+      bool _compact_blocks_enabled;
+      bool _aead_channel_enabled;  // offer peers to switch the connection from AES-CBC to AES-GCM
+
+      traffic_counters _traffic; /// all messages exchanged since startup, including with peers we are no longer connected to
+      latency_histogram _block_propagation_histogram;
+      latency_histogram _block_validation_histogram;
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
       std::set<message_hash_type> _message_ids_currently_being_processed;
@@ -643,6 +687,19 @@ namespace graphene { namespace net { namespace detail {
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
+      void send_compact_blocks( peer_connection* originating_peer, const std::vector<item_hash_t>& block_message_hashes );
+
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+
+      void on_get_block_transactions_message( peer_connection* originating_peer,
+                                              const get_block_transactions_message& get_block_transactions_message_received );
+
+      void on_block_transactions_message( peer_connection* originating_peer,
+                                          const block_transactions_message& block_transactions_message_received );
+
+      void process_compact_block( peer_connection* originating_peer, peer_connection::compact_block_in_progress&& compact_block );
+
       void on_item_ids_inventory_message( peer_connection* originating_peer,
                                           const item_ids_inventory_message& item_ids_inventory_message_received );
 
@@ -742,7 +799,10 @@ namespace graphene { namespace net { namespace detail {
       void                       set_total_bandwidth_limit( uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second );
       void                       disable_peer_advertising();
       fc::variant_object         get_call_statistics() const;
-      message                    get_message_for_item(const item_id& item) override;
+      network_metrics            get_network_metrics() const;
+      padded_message_ptr         get_message_for_item(const item_id& item) override;
+      void                       on_messages_sent(peer_connection* originating_peer,
+                                                  const std::vector<padded_message_ptr>& sent_messages) override;
 
       fc::variant_object         network_get_info() const;
       fc::variant_object         network_get_usage_stats() const;
@@ -816,7 +876,11 @@ namespace graphene { namespace net { namespace detail {
       _node_is_shutting_down(false),
       _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
       _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING)
+      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+      _compact_blocks_enabled(true),
+      _aead_channel_enabled(true),
+      _block_propagation_histogram({ 100, 250, 500, 1000, 2000, 3000, 5000, 10000, 30000 }),
+      _block_validation_histogram({ 5, 10, 25, 50, 100, 250, 500, 1000, 2500 })
     {
       _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
       fc::rand_bytes(&_node_id.data[0], (int)_node_id.size());
@@ -1200,7 +1264,14 @@ namespace graphene { namespace net { namespace detail {
                         ("endpoint", peer_and_items.peer->get_remote_endpoint())("id", id));
               }
 
-            peer_and_items.peer->send_message(fetch_items_message(items_by_type.first,
+            // blocks are still tracked in items_requested_from_peer as block_message_type, the
+            // compact block is turned back into a block_message when it arrives
+            uint32_t item_type_to_fetch = items_by_type.first;
+            if (item_type_to_fetch == core_message_type_enum::block_message_type &&
+                _compact_blocks_enabled && peer_and_items.peer->supports_compact_blocks)
+              item_type_to_fetch = core_message_type_enum::compact_block_message_type;
+
+            peer_and_items.peer->send_message(fetch_items_message(item_type_to_fetch,
                                                                   items_by_type.second));
           }
         }
@@ -1406,6 +1477,15 @@ namespace graphene { namespace net { namespace detail {
                       ("synopsis", active_peer->item_ids_requested_from_peer->get<0>()));
                 disconnect_due_to_request_timeout = true;
               }
+            for (auto iter = active_peer->compact_blocks_in_progress.begin(); iter != active_peer->compact_blocks_in_progress.end();)
+              if (iter->second.received_time < active_ignored_request_threshold)
+              {
+                wlog("Peer ${peer} didn't send the transactions of compact block ${id} in time, dropping it",
+                     ("peer", active_peer->get_remote_endpoint())("id", iter->first));
+                iter = active_peer->compact_blocks_in_progress.erase(iter);
+              }
+              else
+                ++iter;
             if (!disconnect_due_to_request_timeout)
               for (const peer_connection::item_to_time_map_type::value_type& item_and_time : active_peer->items_requested_from_peer)
                 if (item_and_time.second < active_ignored_request_threshold)
@@ -1768,6 +1848,7 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::on_message( peer_connection* originating_peer, const message& received_message )
     {
       VERIFY_CORRECT_THREAD();
+      _traffic.record_received(received_message);
       message_hash_type message_hash = received_message.id();
       dlog("handling message ${type} ${hash} size ${size} from peer ${endpoint}",
            ("type", graphene::net::core_message_type_enum(received_message.msg_type))("hash", message_hash)
@@ -1811,6 +1892,15 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::block_message_type:
         process_block_message(originating_peer, received_message, message_hash);
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::get_block_transactions_message_type:
+        on_get_block_transactions_message(originating_peer, received_message.as<get_block_transactions_message>());
+        break;
+      case core_message_type_enum::block_transactions_message_type:
+        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+        break;
       case core_message_type_enum::current_time_request_message_type:
         on_current_time_request_message(originating_peer, received_message.as<current_time_request_message>());
         break;
@@ -1872,6 +1962,11 @@ namespace graphene { namespace net { namespace detail {
 
       user_data["chain_id"] = SIGMAENGINE_CHAIN_ID;
 
+      if (_compact_blocks_enabled)
+        user_data["compact_blocks"] = true;
+      if (_aead_channel_enabled)
+        user_data["aead_channel"] = true;
+
       return user_data;
     }
     void node_impl::parse_hello_user_data_for_peer(peer_connection* originating_peer, const fc::variant_object& user_data)
@@ -1888,6 +1983,10 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
       if (user_data.contains("chain_id"))
         originating_peer->chain_id = user_data["chain_id"].as<sigmaengine::protocol::chain_id_type>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
+      if (user_data.contains("aead_channel"))
+        originating_peer->supports_aead_channel = user_data["aead_channel"].as_bool();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2071,6 +2170,10 @@ namespace graphene { namespace net { namespace detail {
           {
             originating_peer->their_state = peer_connection::their_connection_state::connection_accepted;
             originating_peer->send_message(message(connection_accepted_message()));
+            // both hellos are on the wire before this point, so each side knows whether the
+            // other switches its sending side right after its connection_accepted_message
+            if (originating_peer->offered_aead_channel && originating_peer->supports_aead_channel)
+              originating_peer->start_aead_send_after_queued_messages();
             dlog("Received a hello_message from peer ${peer}, sending reply to accept connection",
                  ("peer", originating_peer->get_remote_endpoint()));
           }
@@ -2100,6 +2203,8 @@ namespace graphene { namespace net { namespace detail {
       dlog("Received a connection_accepted in response to my \"hello\" from ${peer}", ("peer", originating_peer->get_remote_endpoint()));
       originating_peer->negotiation_status = peer_connection::connection_negotiation_status::peer_connection_accepted;
       originating_peer->our_state = peer_connection::our_connection_state::connection_accepted;
+      if (originating_peer->offered_aead_channel && originating_peer->supports_aead_channel)
+        originating_peer->start_aead_receive();
       originating_peer->send_message(address_request_message());
       fc::time_point now = fc::time_point::now();
       if (_is_firewalled == firewalled_state::unknown &&
@@ -2727,7 +2832,7 @@ namespace graphene { namespace net { namespace detail {
       }
     }
 
-    message node_impl::get_message_for_item(const item_id& item)
+    padded_message_ptr node_impl::get_message_for_item(const item_id& item)
     {
       try
       {
@@ -2735,13 +2840,17 @@ namespace graphene { namespace net { namespace detail {
       }
       catch (fc::key_not_found_exception&)
       {}
+      // blocks are queued by block id, which is the contents hash of a cached block message
+      if (item.item_type == block_message_type)
+        if (padded_message_ptr cached_block = _message_cache.find_message_by_contents_hash(item.item_hash, block_message_type))
+          return cached_block;
       try
       {
-        return _delegate->get_item(item);
+        return std::make_shared<padded_message>(_delegate->get_item(item));
       }
       catch (fc::key_not_found_exception&)
       {}
-      return item_not_available_message(item);
+      return std::make_shared<padded_message>(item_not_available_message(item));
     }
 
     void node_impl::on_fetch_items_message(peer_connection* originating_peer, const fetch_items_message& fetch_items_message_received)
@@ -2752,20 +2861,34 @@ namespace graphene { namespace net { namespace detail {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
-      fc::optional<message> last_block_message_sent;
+      if (fetch_items_message_received.item_type == compact_block_message_type)
+      {
+        send_compact_blocks(originating_peer, fetch_items_message_received.items_to_fetch);
+        return;
+      }
+
+      fc::optional<block_id_type> last_block_id_sent;
 
-      std::list<message> reply_messages;
+      // a reply is either a message from the cache, sent from its padded buffer that is shared
+      // with every other peer the message goes to, or a block the delegate had, queued by id
+      struct reply
+      {
+        padded_message_ptr message;
+        fc::optional<item_id> block_item;
+      };
+      std::list<reply> reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
         {
-          message requested_message = _message_cache.get_message(item_hash);
+          fc::uint160_t contents_hash;
+          padded_message_ptr requested_message = _message_cache.get_message(item_hash, &contents_hash);
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
-               ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+               ("id", item_hash));
+          reply_messages.push_back(reply{requested_message, fc::optional<item_id>()});
+          if (requested_message->header().msg_type == block_message_type)
+            last_block_id_sent = block_id_type(contents_hash);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2781,34 +2904,206 @@ namespace graphene { namespace net { namespace detail {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+          if (requested_message.msg_type == block_message_type)
+          {
+            // the block is loaded again when it reaches the top of the send queue
+            last_block_id_sent = requested_message.as<graphene::net::block_message>().block_id;
+            reply_messages.push_back(reply{padded_message_ptr(), item_id(block_message_type, *last_block_id_sent)});
+          }
+          else
+            reply_messages.push_back(reply{std::make_shared<padded_message>(requested_message), fc::optional<item_id>()});
           continue;
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.push_back(reply{std::make_shared<padded_message>(item_not_available_message(item_to_fetch)), fc::optional<item_id>()});
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
       }
 
       // if we sent them a block, update our record of the last block they've seen accordingly
-      if (last_block_message_sent)
+      if (last_block_id_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
+        originating_peer->last_block_delegate_has_seen = *last_block_id_sent;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_id_sent);
+      }
+
+      for (const reply& reply_message : reply_messages)
+      {
+        if (reply_message.block_item)
+          originating_peer->send_item(*reply_message.block_item);
+        else
+          originating_peer->send_message(reply_message.message);
+      }
+    }
+
+    void node_impl::send_compact_blocks(peer_connection* originating_peer, const std::vector<item_hash_t>& block_message_hashes)
+    {
+      VERIFY_CORRECT_THREAD();
+      for (const item_hash_t& item_hash : block_message_hashes)
+      {
+        // item_not_available_message carries the block_message_type item the peer is tracking
+        padded_message_ptr requested_message = get_message_for_item(item_id(block_message_type, item_hash));
+        if (requested_message->header().msg_type != block_message_type)
+        {
+          originating_peer->send_message(requested_message);
+          continue;
+        }
+
+        graphene::net::block_message block = requested_message->as<graphene::net::block_message>();
         originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        originating_peer->last_block_time_delegate_has_seen = block.block.timestamp;
+        originating_peer->send_message(compact_block_message(block.block));
+      }
+    }
+
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      // compact blocks are only sent in answer to a block request, which is tracked by the hash of
+      // the full block_message; until the block is rebuilt, all we can check is that one is outstanding
+      bool block_requested = std::any_of(originating_peer->items_requested_from_peer.begin(),
+                                         originating_peer->items_requested_from_peer.end(),
+                                         [](const peer_connection::item_to_time_map_type::value_type& item_and_time) {
+                                           return item_and_time.first.item_type == graphene::net::block_message_type;
+                                         }) ||
+                             originating_peer->sync_items_requested_from_peer.count(compact_block_message_received.header.id()) != 0;
+      if (!block_requested)
+      {
+        wlog("received compact block ${id} I didn't ask for from peer ${endpoint}, ignoring it",
+             ("id", compact_block_message_received.header.id())("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      static const size_t max_transactions_in_block = SIGMAENGINE_MAX_BLOCK_SIZE / fc::raw::pack_size(signed_transaction());
+      if (compact_block_message_received.short_ids.size() > max_transactions_in_block)
+      {
+        wlog("compact block ${id} from peer ${endpoint} claims ${count} transactions, more than a block can hold",
+             ("id", compact_block_message_received.header.id())("endpoint", originating_peer->get_remote_endpoint())
+             ("count", compact_block_message_received.short_ids.size()));
+        disconnect_from_peer(originating_peer, "You sent a compact block with more transactions than a block can hold");
+        return;
       }
 
-      for (const message& reply : reply_messages)
+      peer_connection::compact_block_in_progress compact_block;
+      static_cast<signed_block_header&>(compact_block.block) = compact_block_message_received.header;
+      compact_block.received_time = fc::time_point::now();
+      compact_block.block.transactions.resize(compact_block_message_received.short_ids.size());
+      for (uint32_t i = 0; i < compact_block_message_received.short_ids.size(); ++i)
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        fc::optional<signed_transaction> trx = _message_cache.find_transaction_by_short_id(compact_block_message_received.short_ids[i]);
+        if (trx)
+          compact_block.block.transactions[i] = std::move(*trx);
         else
-          originating_peer->send_message(reply);
+          compact_block.missing_indexes.push_back(i);
+      }
+
+      dlog("received compact block ${id} from peer ${endpoint}, missing ${missing} of ${count} transactions",
+           ("id", compact_block.block.id())("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", compact_block.missing_indexes.size())("count", compact_block.block.transactions.size()));
+      process_compact_block(originating_peer, std::move(compact_block));
+    }
+
+    void node_impl::process_compact_block(peer_connection* originating_peer, peer_connection::compact_block_in_progress&& compact_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      block_id_type block_id = compact_block.block.id();
+      if (compact_block.missing_indexes.empty() &&
+          compact_block.block.calculate_merkle_root() != compact_block.block.transaction_merkle_root)
+      {
+        // a short id matched the wrong transaction; ask for all of them
+        wlog("compact block ${id} from peer ${endpoint} does not match its merkle root, fetching all its transactions",
+             ("id", block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        for (uint32_t i = 0; i < compact_block.block.transactions.size(); ++i)
+          compact_block.missing_indexes.push_back(i);
+      }
+
+      if (!compact_block.missing_indexes.empty())
+      {
+        if (originating_peer->compact_blocks_in_progress.size() >= GRAPHENE_NET_MAX_COMPACT_BLOCKS_IN_PROGRESS &&
+            originating_peer->compact_blocks_in_progress.find(block_id) == originating_peer->compact_blocks_in_progress.end())
+        {
+          // leave the block request outstanding; it times out and is fetched from another peer
+          wlog("peer ${endpoint} has too many compact blocks waiting for transactions, dropping ${id}",
+               ("endpoint", originating_peer->get_remote_endpoint())("id", block_id));
+          return;
+        }
+        originating_peer->send_message(get_block_transactions_message(block_id, compact_block.missing_indexes));
+        originating_peer->compact_blocks_in_progress[block_id] = std::move(compact_block);
+        return;
+      }
+
+      // the rebuilt block packs to the same bytes as the block_message we asked for, so it
+      // has the message hash we are tracking in items_requested_from_peer
+      message block_message_to_process(graphene::net::block_message(compact_block.block));
+      process_block_message(originating_peer, block_message_to_process, block_message_to_process.id());
+    }
+
+    void node_impl::on_get_block_transactions_message(peer_connection* originating_peer,
+                                                      const get_block_transactions_message& get_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      block_transactions_message reply(get_block_transactions_message_received.block_id);
+      try
+      {
+        message block = _delegate->get_item(item_id(block_message_type, get_block_transactions_message_received.block_id));
+        std::vector<signed_transaction> transactions = block.as<graphene::net::block_message>().block.transactions;
+        for (uint32_t index : get_block_transactions_message_received.indexes)
+        {
+          if (index >= transactions.size())
+          {
+            reply.transactions.clear();
+            break;
+          }
+          reply.transactions.push_back(std::move(transactions[index]));
+        }
+      }
+      catch (fc::key_not_found_exception&)
+      {
+        dlog("peer ${endpoint} asked for transactions of block ${id}, which we don't have",
+             ("endpoint", originating_peer->get_remote_endpoint())("id", get_block_transactions_message_received.block_id));
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_block_transactions_message(peer_connection* originating_peer,
+                                                  const block_transactions_message& block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto iter = originating_peer->compact_blocks_in_progress.find(block_transactions_message_received.block_id);
+      if (iter == originating_peer->compact_blocks_in_progress.end())
+      {
+        wlog("received transactions for block ${id} I didn't ask for from peer ${endpoint}",
+             ("id", block_transactions_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+      peer_connection::compact_block_in_progress compact_block = std::move(iter->second);
+      originating_peer->compact_blocks_in_progress.erase(iter);
+
+      if (block_transactions_message_received.transactions.size() != compact_block.missing_indexes.size())
+      {
+        // leave the block request outstanding; if the peer can't complete it the request
+        // times out and the block is fetched from another peer
+        wlog("peer ${endpoint} did not send the transactions I asked for in block ${id}",
+             ("endpoint", originating_peer->get_remote_endpoint())("id", block_transactions_message_received.block_id));
+        return;
+      }
+
+      bool requested_all = compact_block.missing_indexes.size() == compact_block.block.transactions.size();
+      for (uint32_t i = 0; i < compact_block.missing_indexes.size(); ++i)
+        compact_block.block.transactions[compact_block.missing_indexes[i]] = block_transactions_message_received.transactions[i];
+      compact_block.missing_indexes.clear();
+
+      if (requested_all)
+      {
+        // nothing left to refetch; a block that still doesn't match is rejected as one we didn't ask for
+        message block_message_to_process(graphene::net::block_message(compact_block.block));
+        process_block_message(originating_peer, block_message_to_process, block_message_to_process.id());
       }
+      else
+        process_compact_block(originating_peer, std::move(compact_block));
     }
 
     void node_impl::on_item_not_available_message( peer_connection* originating_peer, const item_not_available_message& item_not_available_message_received )
@@ -3416,6 +3711,8 @@ namespace graphene { namespace net { namespace detail {
           _delegate->handle_block(block_message_to_process, false, contained_transaction_message_ids);
           _message_ids_currently_being_processed.erase(message_hash);
           message_validated_time = fc::time_point::now();
+          _block_propagation_histogram.record((message_receive_time - fc::time_point(block_message_to_process.block.timestamp)).count() / 1000);
+          _block_validation_histogram.record((message_validated_time - message_receive_time).count() / 1000);
           ilog("Successfully pushed block ${num} (id:${id})",
                 ("num", block_message_to_process.block.block_num())
                 ("id", block_message_to_process.block_id));
@@ -4293,6 +4590,7 @@ namespace graphene { namespace net { namespace detail {
     {
       VERIFY_CORRECT_THREAD();
       peer->negotiation_status = peer_connection::connection_negotiation_status::hello_sent;
+      peer->offered_aead_channel = _aead_channel_enabled;
 
       fc::sha256::encoder shared_secret_encoder;
       fc::sha512 shared_secret = peer->get_shared_secret();
@@ -5000,6 +5298,10 @@ namespace graphene { namespace net { namespace detail {
         _maximum_number_of_sync_blocks_to_prefetch = params["maximum_number_of_sync_blocks_to_prefetch"].as<uint32_t>();
       if (params.contains("maximum_blocks_per_peer_during_syncing"))
         _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
+      if (params.contains("enable_compact_blocks"))
+        _compact_blocks_enabled = params["enable_compact_blocks"].as_bool();
+      if (params.contains("enable_aead_channel"))
+        _aead_channel_enabled = params["enable_aead_channel"].as_bool();
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -5019,6 +5321,8 @@ namespace graphene { namespace net { namespace detail {
       result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
       result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
       result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+      result["enable_compact_blocks"] = _compact_blocks_enabled;
+      result["enable_aead_channel"] = _aead_channel_enabled;
       return result;
     }
 
@@ -5079,6 +5383,52 @@ namespace graphene { namespace net { namespace detail {
       return _delegate->get_call_statistics();
     }
 
+    void node_impl::on_messages_sent(peer_connection* originating_peer, const std::vector<padded_message_ptr>& sent_messages)
+    {
+      VERIFY_CORRECT_THREAD();
+      for (const padded_message_ptr& sent : sent_messages)
+        _traffic.record_sent(sent->header());
+    }
+
+    network_metrics node_impl::get_network_metrics() const
+    {
+      VERIFY_CORRECT_THREAD();
+      network_metrics metrics;
+      summarize_traffic(_traffic, metrics.bytes_received, metrics.bytes_sent,
+                        metrics.messages_received, metrics.messages_sent,
+                        metrics.received_by_type, metrics.sent_by_type);
+
+      for (const peer_connection_ptr& peer : _active_connections)
+      {
+        peer_traffic_metrics peer_metrics;
+        fc::optional<fc::ip::endpoint> endpoint = peer->get_remote_endpoint();
+        if (endpoint)
+          peer_metrics.endpoint = *endpoint;
+        peer_metrics.direction = fc::reflector<peer_connection_direction>::to_string(peer->direction);
+        summarize_traffic(peer->traffic, peer_metrics.bytes_received, peer_metrics.bytes_sent,
+                          peer_metrics.messages_received, peer_metrics.messages_sent,
+                          peer_metrics.received_by_type, peer_metrics.sent_by_type);
+        peer_metrics.queued_messages = peer->get_queued_message_count();
+        peer_metrics.queued_bytes = peer->get_total_queued_messages_size();
+        peer_metrics.syncing_from_peer = peer->we_need_sync_items_from_peer;
+        if (peer->we_need_sync_items_from_peer)
+          ++metrics.sync.peers_syncing_from;
+        metrics.peers.push_back(std::move(peer_metrics));
+      }
+
+      metrics.sync.synchronizing = metrics.sync.peers_syncing_from > 0;
+      metrics.sync.head_block_number = _delegate->get_block_number(_delegate->get_head_block_id());
+      metrics.sync.items_to_fetch = _total_number_of_unfetched_items;
+      metrics.sync.blocks_requested = _active_sync_requests.size();
+      metrics.sync.blocks_waiting = _received_sync_items.size() + _new_received_sync_items.size();
+
+      metrics.handle_block = _delegate->get_handle_block_metrics();
+      metrics.handle_transaction = _delegate->get_handle_transaction_metrics();
+      metrics.block_propagation_ms = _block_propagation_histogram;
+      metrics.block_validation_ms = _block_validation_histogram;
+      return metrics;
+    }
+
     fc::variant_object node_impl::network_get_info() const
     {
       VERIFY_CORRECT_THREAD();
@@ -5287,6 +5637,11 @@ namespace graphene { namespace net { namespace detail {
     INVOKE_IN_IMPL(get_call_statistics);
   }
 
+  network_metrics node::get_network_metrics() const
+  {
+    INVOKE_IN_IMPL(get_network_metrics);
+  }
+
   fc::variant_object node::network_get_info() const
   {
     INVOKE_IN_IMPL(network_get_info);
@@ -5405,6 +5760,28 @@ namespace graphene { namespace net { namespace detail {
       return statistics;
     }
 
+    delegate_call_metrics statistics_gathering_node_delegate_wrapper::summarize_calls(const call_stats_accumulator& execution_accumulator)
+    {
+      delegate_call_metrics metrics;
+      metrics.calls = boost::accumulators::count(execution_accumulator);
+      if (metrics.calls == 0)
+        return metrics; // min, max and mean are undefined until the first call
+      metrics.total_us = boost::accumulators::sum(execution_accumulator);
+      metrics.max_us = boost::accumulators::max(execution_accumulator);
+      metrics.recent_mean_us = boost::accumulators::rolling_mean(execution_accumulator);
+      return metrics;
+    }
+
+    delegate_call_metrics statistics_gathering_node_delegate_wrapper::get_handle_block_metrics() const
+    {
+      return summarize_calls(_handle_block_execution_accumulator);
+    }
+
+    delegate_call_metrics statistics_gathering_node_delegate_wrapper::get_handle_transaction_metrics() const
+    {
+      return summarize_calls(_handle_transaction_execution_accumulator);
+    }
+
 // define VERBOSE_NODE_DELEGATE_LOGGING to log whenever the node delegate throws exceptions
 //#define VERBOSE_NODE_DELEGATE_LOGGING
 #ifdef VERBOSE_NODE_DELEGATE_LOGGING
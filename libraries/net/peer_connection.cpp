@@ -43,7 +43,7 @@
 
 namespace graphene { namespace net
   {
-    message peer_connection::real_queued_message::get_message(peer_connection_delegate*)
+    padded_message_ptr peer_connection::real_queued_message::get_message(peer_connection_delegate*)
     {
       if (message_send_time_field_offset != (size_t)-1)
       {
@@ -53,14 +53,15 @@ namespace graphene { namespace net
         assert(message_send_time_field_offset + packed_current_time.size() <= message_to_send.data.size());
         memcpy(message_to_send.data.data() + message_send_time_field_offset,
                packed_current_time.data(), packed_current_time.size());
+        return std::make_shared<padded_message>(message_to_send);
       }
-      return message_to_send;
+      return padded_message_to_send;
     }
     size_t peer_connection::real_queued_message::get_size_in_queue()
     {
-      return message_to_send.data.size();
+      return padded_message_to_send ? padded_message_to_send->size() : message_to_send.data.size();
     }
-    message peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
+    padded_message_ptr peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
     {
       return node->get_message_for_item(item_to_send);
     }
@@ -271,6 +272,7 @@ namespace graphene { namespace net
       BOOST_SCOPE_EXIT(this_) {
         this_->_currently_handling_message = false;
       } BOOST_SCOPE_EXIT_END
+      traffic.record_received( received_message );
       _node->on_message( this, received_message );
     }
 
@@ -293,14 +295,29 @@ namespace graphene { namespace net
 #endif
       while (!_queued_messages.empty())
       {
-        _queued_messages.front()->transmission_start_time = fc::time_point::now();
-        message message_to_send = _queued_messages.front()->get_message(_node);
+        // take messages off the front of the queue until the batch is full; they are
+        // encrypted together and go out in as few socket writes as possible
+        std::vector<queued_message*> batch;
+        std::vector<padded_message_ptr> messages_to_send;
+        size_t batch_size = 0;
+        fc::time_point transmission_start_time = fc::time_point::now();
+        for (const std::unique_ptr<queued_message>& queued : _queued_messages)
+        {
+          if (batch_size >= GRAPHENE_NET_MAX_SEND_BATCH_SIZE)
+            break;
+          queued->transmission_start_time = transmission_start_time;
+          messages_to_send.push_back(queued->get_message(_node));
+          batch_size += messages_to_send.back()->size();
+          batch.push_back(queued.get());
+          if (queued->start_aead_send_after)
+            break;
+        }
         try
         {
-          //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
-          //     "to send message of type ${type} for peer ${endpoint}",
-          //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
-          _message_connection.send_message(message_to_send);
+          //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_messages() "
+          //     "to send ${count} messages for peer ${endpoint}",
+          //     ("count", messages_to_send.size())("endpoint", get_remote_endpoint()));
+          _message_connection.send_messages(messages_to_send);
           //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
           //     ("endpoint", get_remote_endpoint()));
         }
@@ -330,9 +347,19 @@ namespace graphene { namespace net
         {
           elog("message_oriented_exception::send_message() threw an unhandled exception");
         }
-        _queued_messages.front()->transmission_finish_time = fc::time_point::now();
-        _total_queued_messages_size -= _queued_messages.front()->get_size_in_queue();
-        _queued_messages.pop();
+        for (const padded_message_ptr& sent : messages_to_send)
+          traffic.record_sent(sent->header());
+        _node->on_messages_sent(this, messages_to_send);
+        if (batch.back()->start_aead_send_after)
+          _message_connection.start_aead_send();
+        fc::time_point transmission_finish_time = fc::time_point::now();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+          assert(_queued_messages.front().get() == batch[i]);
+          _queued_messages.front()->transmission_finish_time = transmission_finish_time;
+          _total_queued_messages_size -= _queued_messages.front()->get_size_in_queue();
+          _queued_messages.pop_front();
+        }
       }
       //dlog("leaving peer_connection::send_queued_messages_task() due to queue exhaustion");
     }
@@ -341,7 +368,7 @@ namespace graphene { namespace net
     {
       VERIFY_CORRECT_THREAD();
       _total_queued_messages_size += message_to_send->get_size_in_queue();
-      _queued_messages.emplace(std::move(message_to_send));
+      _queued_messages.emplace_back(std::move(message_to_send));
       if (_total_queued_messages_size > GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES)
       {
         elog("send queue exceeded maximum size of ${max} bytes (current size ${current} bytes)",
@@ -378,6 +405,13 @@ namespace graphene { namespace net
       send_queueable_message(std::move(message_to_enqueue));
     }
 
+    void peer_connection::send_message(const padded_message_ptr& message_to_send)
+    {
+      VERIFY_CORRECT_THREAD();
+      std::unique_ptr<queued_message> message_to_enqueue(new real_queued_message(message_to_send));
+      send_queueable_message(std::move(message_to_enqueue));
+    }
+
     void peer_connection::send_item(const item_id& item_to_send)
     {
       VERIFY_CORRECT_THREAD();
@@ -415,6 +449,18 @@ namespace graphene { namespace net
       return _message_connection.get_total_bytes_received();
     }
 
+    size_t peer_connection::get_queued_message_count() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _queued_messages.size();
+    }
+
+    size_t peer_connection::get_total_queued_messages_size() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _total_queued_messages_size;
+    }
+
     fc::time_point peer_connection::get_last_message_sent_time() const
     {
       VERIFY_CORRECT_THREAD();
@@ -474,6 +520,21 @@ namespace graphene { namespace net
       return _message_connection.get_shared_secret();
     }
 
+    void peer_connection::start_aead_send_after_queued_messages()
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_queued_messages.empty())
+        _message_connection.start_aead_send();
+      else
+        _queued_messages.back()->start_aead_send_after = true;
+    }
+
+    void peer_connection::start_aead_receive()
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.start_aead_receive();
+    }
+
     void peer_connection::clear_old_inventory()
     {
       VERIFY_CORRECT_THREAD();
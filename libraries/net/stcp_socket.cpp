@@ -36,6 +36,11 @@
 
 namespace graphene { namespace net {
 
+namespace {
+  // big enough for 64 KiB of CBC stream or one GCM record with its length and tag
+  const size_t batch_write_buffer_size = 4 + stcp_socket::max_aead_record_size + fc::aes_gcm_encoder::tag_size;
+}
+
 stcp_socket::stcp_socket()
 //:_buf_len(0)
 #ifndef NDEBUG
@@ -69,8 +74,30 @@ void stcp_socket::do_key_exchange()
 }
 
 
+fc::sha256 stcp_socket::aead_key( bool for_connector_to_acceptor )const
+{
+  fc::sha256::encoder enc;
+  const char* direction = for_connector_to_acceptor ? "stcp aead connector to acceptor" : "stcp aead acceptor to connector";
+  enc.write( direction, strlen(direction) );
+  enc.write( (const char*)&_shared_secret, sizeof(_shared_secret) );
+  return enc.result();
+}
+
+void stcp_socket::start_aead_send()
+{
+  _send_gcm.init( aead_key( _is_connector ) );
+  _aead_sending = true;
+}
+
+void stcp_socket::start_aead_receive()
+{
+  _recv_gcm.init( aead_key( !_is_connector ) );
+  _aead_receiving = true;
+}
+
 void stcp_socket::connect_to( const fc::ip::endpoint& remote_endpoint )
 {
+  _is_connector = true;
   _sock.connect_to( remote_endpoint );
   do_key_exchange();
 }
@@ -87,6 +114,9 @@ void stcp_socket::bind( const fc::ip::endpoint& local_endpoint )
  */
 size_t stcp_socket::readsome( char* buffer, size_t len )
 { try {
+    if (_aead_receiving)
+      return read_aead( buffer, len );
+
     assert( len > 0 && (len % 16) == 0 );
 
 #ifndef NDEBUG
@@ -116,6 +146,54 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
     return s;
 } FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
 
+size_t stcp_socket::read_aead( char* buffer, size_t len )
+{
+  if (_record_consumed == _record_size)
+  {
+    // read as much ciphertext as the socket has, up to two records, so that a stream
+    // of small records takes few socket reads
+    const size_t max_record_length = 4 + max_aead_record_size + fc::aes_gcm_decoder::tag_size;
+    const size_t aead_read_buffer_length = 2 * max_record_length;
+    if (!_aead_read_buffer)
+    {
+      _aead_read_buffer.reset(new char[aead_read_buffer_length], [](char* p){ delete[] p; });
+      _record_buffer.reset(new char[max_aead_record_size], [](char* p){ delete[] p; });
+    }
+
+    auto fill = [&]( size_t needed ) {
+      if (_aead_read_begin + needed > aead_read_buffer_length)
+      {
+        memmove(_aead_read_buffer.get(), _aead_read_buffer.get() + _aead_read_begin, _aead_read_end - _aead_read_begin);
+        _aead_read_end -= _aead_read_begin;
+        _aead_read_begin = 0;
+      }
+      while (_aead_read_end - _aead_read_begin < needed)
+        _aead_read_end += _sock.readsome(_aead_read_buffer, aead_read_buffer_length - _aead_read_end, _aead_read_end);
+    };
+
+    fill(4);
+    const char* length_bytes = _aead_read_buffer.get() + _aead_read_begin;
+    uint32_t record_size = uint32_t((unsigned char)length_bytes[0])       | uint32_t((unsigned char)length_bytes[1]) << 8 |
+                           uint32_t((unsigned char)length_bytes[2]) << 16 | uint32_t((unsigned char)length_bytes[3]) << 24;
+    FC_ASSERT( record_size > 0 && record_size <= max_aead_record_size, "invalid record size ${s}", ("s", record_size) );
+
+    fill(4 + record_size + fc::aes_gcm_decoder::tag_size);
+    const char* record = _aead_read_buffer.get() + _aead_read_begin;
+    _record_size = 0;
+    _record_consumed = 0;
+    _recv_gcm.begin_record( record, 4 );
+    _recv_gcm.decode( record + 4, record_size, _record_buffer.get() );
+    _recv_gcm.end_record( record + 4 + record_size );
+    _aead_read_begin += 4 + record_size + fc::aes_gcm_decoder::tag_size;
+    _record_size = record_size;
+  }
+
+  len = std::min( len, _record_size - _record_consumed );
+  memcpy( buffer, _record_buffer.get() + _record_consumed, len );
+  _record_consumed += len;
+  return len;
+}
+
 size_t stcp_socket::readsome( const std::shared_ptr<char>& buf, size_t len, size_t offset ) 
 {
   return readsome(buf.get() + offset, len);
@@ -128,6 +206,13 @@ bool stcp_socket::eof()const
 
 size_t stcp_socket::writesome( const char* buffer, size_t len )
 { try {
+    if (_aead_sending)
+    {
+      len = std::min<size_t>(max_aead_record_size, len);
+      write_aead_records( std::vector< std::pair< const char*, size_t > >{ { buffer, len } } );
+      return len;
+    }
+
     assert( len > 0 && (len % 16) == 0 );
 
 #ifndef NDEBUG
@@ -145,13 +230,6 @@ size_t stcp_socket::writesome( const char* buffer, size_t len )
     if (!_write_buffer)
       _write_buffer.reset(new char[write_buffer_length], [](char* p){ delete[] p; });
     len = std::min<size_t>(write_buffer_length, len);
-    memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
-    /**
-     * every sizeof(crypt_buf) bytes the aes channel
-     * has an error and doesn't decrypt properly...  disable
-     * for now because we are going to upgrade to something
-     * better.
-     */
     uint32_t ciphertext_len = _send_aes.encode( buffer, len, _write_buffer.get() );
     assert(ciphertext_len == len);
     _sock.write( _write_buffer, ciphertext_len );
@@ -163,6 +241,84 @@ size_t stcp_socket::writesome( const std::shared_ptr<const char>& buf, size_t le
   return writesome(buf.get() + offset, len);
 }
 
+void stcp_socket::write_buffers( const std::vector< std::pair< const char*, size_t > >& buffers )
+{ try {
+    if (_aead_sending)
+    {
+      write_aead_records( buffers );
+      return;
+    }
+
+    const size_t batch_write_buffer_length = 64 * 1024;
+    if (!_batch_write_buffer)
+      _batch_write_buffer.reset(new char[batch_write_buffer_size], [](char* p){ delete[] p; });
+
+    size_t filled = 0;
+    for (const auto& buffer : buffers)
+    {
+      assert( (buffer.second % 16) == 0 );
+      for (size_t offset = 0; offset < buffer.second;)
+      {
+        size_t len = std::min(batch_write_buffer_length - filled, buffer.second - offset);
+        uint32_t ciphertext_len = _send_aes.encode( buffer.first + offset, len, _batch_write_buffer.get() + filled );
+        assert(ciphertext_len == len);
+        filled += ciphertext_len;
+        offset += ciphertext_len;
+        if (filled == batch_write_buffer_length)
+        {
+          _sock.write( _batch_write_buffer, filled );
+          filled = 0;
+        }
+      }
+    }
+    if (filled)
+      _sock.write( _batch_write_buffer, filled );
+} FC_RETHROW_EXCEPTIONS( warn, "", ("buffers", buffers.size()) ) }
+
+void stcp_socket::write_aead_records( const std::vector< std::pair< const char*, size_t > >& buffers )
+{
+  // the buffers are encrypted straight into records of up to max_aead_record_size bytes,
+  // a record may take the end of one buffer and the start of the next
+  if (!_batch_write_buffer)
+    _batch_write_buffer.reset(new char[batch_write_buffer_size], [](char* p){ delete[] p; });
+
+  size_t remaining = 0;
+  for (const auto& buffer : buffers)
+    remaining += buffer.second;
+
+  auto buffer_iter = buffers.begin();
+  size_t offset = 0;
+  while (remaining)
+  {
+    uint32_t record_size = std::min<size_t>(max_aead_record_size, remaining);
+    char* record = _batch_write_buffer.get();
+    record[0] = char(record_size);
+    record[1] = char(record_size >> 8);
+    record[2] = char(record_size >> 16);
+    record[3] = char(record_size >> 24);
+    _send_gcm.begin_record( record, 4 );
+
+    size_t filled = 0;
+    while (filled < record_size)
+    {
+      if (offset == buffer_iter->second)
+      {
+        ++buffer_iter;
+        offset = 0;
+        continue;
+      }
+      size_t len = std::min<size_t>(record_size - filled, buffer_iter->second - offset);
+      _send_gcm.encode( buffer_iter->first + offset, len, record + 4 + filled );
+      filled += len;
+      offset += len;
+    }
+    _send_gcm.end_record( record + 4 + record_size );
+
+    _sock.write( _batch_write_buffer, 4 + record_size + fc::aes_gcm_encoder::tag_size );
+    remaining -= record_size;
+  }
+}
+
 void stcp_socket::flush()
 {
   _sock.flush();
@@ -74,14 +74,21 @@ block_info_api::block_info_api( const sigmaengine::app::api_context& ctx )
 std::vector< block_info > block_info_api::get_block_info( get_block_info_args args )
 {
    std::vector< block_info > result;
-   my->get_block_info( args, result );
+   // the plugin appends to its block info while applying blocks under the write lock
+   my->app.chain_database()->with_read_lock( [&]()
+   {
+      my->get_block_info( args, result );
+   });
    return result;
 }
 
 std::vector< block_with_info > block_info_api::get_blocks_with_info( get_block_info_args args )
 {
    std::vector< block_with_info > result;
-   my->get_blocks_with_info( args, result );
+   my->app.chain_database()->with_read_lock( [&]()
+   {
+      my->get_blocks_with_info( args, result );
+   });
    return result;
 }
 
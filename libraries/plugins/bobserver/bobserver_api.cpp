@@ -0,0 +1,33 @@
+#include <sigmaengine/app/api_context.hpp>
+#include <sigmaengine/app/application.hpp>
+
+#include <sigmaengine/bobserver/bobserver_api.hpp>
+
+namespace sigmaengine { namespace bobserver {
+
+namespace detail {
+
+class bobserver_api_impl
+{
+   public:
+      bobserver_api_impl( sigmaengine::app::application& _app )
+         :_plugin( _app.get_plugin< bobserver_plugin >( "bobserver" ) ) {}
+
+      std::shared_ptr< bobserver_plugin > _plugin;
+};
+
+} // detail
+
+bobserver_api::bobserver_api( const sigmaengine::app::api_context& ctx )
+{
+   my = std::make_shared< detail::bobserver_api_impl >( ctx.app );
+}
+
+void bobserver_api::on_api_startup() {}
+
+block_production_metrics bobserver_api::get_production_metrics()const
+{
+   return my->_plugin->get_production_metrics();
+}
+
+} } // sigmaengine::bobserver
@@ -21,6 +21,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <sigmaengine/bobserver/bobserver_api.hpp>
 #include <sigmaengine/bobserver/bobserver_plugin.hpp>
 #include <sigmaengine/bobserver/bobserver_objects.hpp>
 #include <sigmaengine/bobserver/bobserver_operations.hpp>
@@ -345,6 +346,7 @@ void bobserver_plugin::plugin_set_program_options(
          ("bobserver,b", bpo::value<vector<string>>()->composing()->multitoken(),
           ("name of bobserver controlled by this node (e.g. " + bobserver_id_example+" )" ).c_str())
          ("private-key", bpo::value<vector<string>>()->composing()->multitoken(), "WIF PRIVATE KEY to be used by one or more bobservers or miners" )
+         ("production-lead-time-ms", bpo::value<uint32_t>()->default_value(200), "Start assembling our block this many milliseconds before its slot; it is signed and broadcast at the slot time")
          ;
    config_file_options.add(command_line_options);
 }
@@ -374,6 +376,11 @@ void bobserver_plugin::plugin_initialize(const boost::program_options::variables
       }
    }
 
+   _production_lead_time = fc::milliseconds( options.at("production-lead-time-ms").as<uint32_t>() );
+   FC_ASSERT( _production_lead_time < fc::seconds( SIGMAENGINE_BLOCK_INTERVAL ), "production-lead-time-ms must be less than the block interval" );
+   _production_metrics.lateness_ms = graphene::net::latency_histogram( { 5, 10, 25, 50, 100, 250, 500, 1000 } );
+   _production_metrics.assembly_ms = graphene::net::latency_histogram( { 5, 10, 25, 50, 100, 250, 500, 1000 } );
+
    chain::database& db = database();
 
    db.post_apply_operation.connect( [&]( const operation_notification& note ){ _my->post_operation( note ); } );
@@ -390,6 +397,8 @@ void bobserver_plugin::plugin_startup()
    ilog("bobserver plugin:  plugin_startup() begin");
    chain::database& d = database();
 
+   app().register_api_factory< bobserver_api >( "bobserver_api" );
+
    if( !_bobservers.empty() )
    {
       ilog("Launching block production for ${n} bobservers.", ("n", _bobservers.size()));
@@ -417,14 +426,14 @@ void bobserver_plugin::plugin_shutdown()
 
 void bobserver_plugin::schedule_production_loop()
 {
-   //Schedule for the next second's tick regardless of chain state
-   // If we would wait less than 50ms, wait for the whole second.
-   fc::time_point fc_now = fc::time_point::now();
-   int64_t time_to_next_second = 1000000 - (fc_now.time_since_epoch().count() % 1000000);
-   if( time_to_next_second < 50000 )      // we must sleep for at least 50ms
-       time_to_next_second += 1000000;
+   // Wake up the lead time before the next slot regardless of chain state.  Slots
+   // are at fixed times, so a block arriving before then does not move the slot.
+   // The slot must be after the one we last woke up for, in case the timer fired early.
+   chain::database& db = database();
+   fc::time_point_sec earliest = std::max( fc::time_point_sec( fc::time_point::now() + _production_lead_time ), _next_slot_time );
+   _next_slot_time = db.get_slot_time( db.get_slot_at_time( earliest ) + 1 );
 
-   fc::time_point next_wakeup( fc_now + fc::microseconds( time_to_next_second ) );
+   fc::time_point next_wakeup( fc::time_point( _next_slot_time ) - _production_lead_time );
 
    //wdump( (now.time_since_epoch().count())(next_wakeup.time_since_epoch().count()) );
    _block_production_task = fc::schedule([this]{block_production_loop();},
@@ -466,7 +475,7 @@ block_production_condition::block_production_condition_enum bobserver_plugin::bl
    switch( result )
    {
       case block_production_condition::produced:
-         ilog("Generated block #${n} (Transication : ${m}) with timestamp ${t} at time ${c} by ${w}", (capture));
+         ilog("Generated block #${n} (Transication : ${m}) with timestamp ${t} at time ${c} by ${w}, ${l}ms late, assembled in ${a}ms", (capture));
          break;
       case block_production_condition::not_synced:
          //ilog("Not producing block because production is disabled until we receive a recent block (see: --enable-stale-production)");
@@ -484,7 +493,7 @@ block_production_condition::block_production_condition_enum bobserver_plugin::bl
          elog("Not producing block because node appears to be on a minority fork with only ${pct}% bobserver participation", (capture) );
          break;
       case block_production_condition::lag:
-         elog("Not producing block because node didn't wake up within 500ms of the slot time.");
+         elog("Not producing block because node didn't wake up within 500ms of the slot time ${scheduled_time}, woke up at ${now}.", (capture) );
          break;
       case block_production_condition::consecutive:
          elog("Not producing block because the last block was generated by the same bobserver.\nThis node is probably disconnected from the network so block production has been disabled.\nDisable this check with --allow-consecutive option.");
@@ -503,8 +512,8 @@ block_production_condition::block_production_condition_enum bobserver_plugin::bl
 block_production_condition::block_production_condition_enum bobserver_plugin::maybe_produce_block( fc::mutable_variant_object& capture )
 {
    chain::database& db = database();
-   fc::time_point now_fine = fc::time_point::now();
-   fc::time_point_sec now = now_fine + fc::microseconds( 500000 );
+   // the slot we woke up for, normally a little ahead of now
+   fc::time_point_sec now = _next_slot_time;
 
    // If the next block production opportunity is in the present or future, we're synced.
    if( !_production_enabled )
@@ -515,7 +524,7 @@ block_production_condition::block_production_condition_enum bobserver_plugin::ma
          return block_production_condition::not_synced;
    }
 
-   // is anyone scheduled to produce now or one second in the future?
+   // is anyone scheduled to produce in the slot?
    uint32_t slot = db.get_slot_at_time( now );
    if( slot == 0 )
    {
@@ -562,9 +571,10 @@ block_production_condition::block_production_condition_enum bobserver_plugin::ma
       return block_production_condition::low_participation;
    }
 
-   if( llabs((scheduled_time - now).count()) > fc::milliseconds( 500 ).count() )
+   fc::time_point now_fine = fc::time_point::now();
+   if( now_fine - fc::time_point( scheduled_time ) > fc::milliseconds( 500 ) )
    {
-      capture("scheduled_time", scheduled_time)("now", now);
+      capture("scheduled_time", scheduled_time)("now", now_fine);
       return block_production_condition::lag;
    }
 
@@ -573,12 +583,29 @@ block_production_condition::block_production_condition_enum bobserver_plugin::ma
    {
       try
       {
-      auto block = db.generate_block(
-         scheduled_time,
-         scheduled_bobserver,
-         private_key_itr->second,
-         _production_skip_flags
-         );
+         fc::time_point assembly_start = fc::time_point::now();
+         auto block = db.assemble_block( scheduled_time, scheduled_bobserver, _production_skip_flags );
+         fc::microseconds assembly_time = fc::time_point::now() - assembly_start;
+
+         // sign at the slot boundary; blocks handled while we wait may replace the head
+         fc::microseconds until_slot = fc::time_point( scheduled_time ) - fc::time_point::now();
+         if( until_slot.count() > 0 )
+            fc::usleep( until_slot );
+         if( block.previous != db.head_block_id() )
+         {
+            ++_production_metrics.blocks_reassembled;
+            assembly_start = fc::time_point::now();
+            block = db.assemble_block( scheduled_time, scheduled_bobserver, _production_skip_flags );
+            assembly_time = fc::time_point::now() - assembly_start;
+         }
+
+         db.sign_and_push_block( block, private_key_itr->second, _production_skip_flags );
+         fc::time_point pushed = fc::time_point::now();
+         fc::microseconds lateness = pushed - fc::time_point( scheduled_time );
+
+         ++_production_metrics.blocks_produced;
+         _production_metrics.lateness_ms.record( lateness.count() / 1000 );
+         _production_metrics.assembly_ms.record( assembly_time.count() / 1000 );
 
          int trans_num = 0;
          if ( block.transactions.size() > 0 )
@@ -587,11 +614,16 @@ block_production_condition::block_production_condition_enum bobserver_plugin::ma
             trans_num = temp.operations.size();
          }
 
-         capture("n", block.block_num())("t", block.timestamp)("c", now)("w",scheduled_bobserver)("m", trans_num);
+         capture("n", block.block_num())("t", block.timestamp)("c", pushed)("w",scheduled_bobserver)("m", trans_num)
+                ("l", lateness.count() / 1000)("a", assembly_time.count() / 1000);
          fc::async( [this,block](){ p2p_node().broadcast(graphene::net::block_message(block)); } );
 
          return block_production_condition::produced;
       }
+      catch( const fc::canceled_exception& )
+      {
+         throw;
+      }
       catch( fc::exception& e )
       {
          elog( "${e}", ("e",e.to_detail_string()) );
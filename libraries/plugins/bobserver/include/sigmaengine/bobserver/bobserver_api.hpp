@@ -0,0 +1,38 @@
+#pragma once
+
+#include <sigmaengine/bobserver/bobserver_plugin.hpp>
+
+#include <fc/api.hpp>
+
+namespace sigmaengine { namespace app {
+   struct api_context;
+} }
+
+namespace sigmaengine { namespace bobserver {
+
+namespace detail {
+class bobserver_api_impl;
+}
+
+class bobserver_api
+{
+   public:
+      bobserver_api( const sigmaengine::app::api_context& ctx );
+
+      void on_api_startup();
+
+      /**
+       *  Timing of the blocks this node produced since it started.  Runs on the RPC server
+       *  thread, which is the one producing blocks, so it must not be listed in rpc-worker-api.
+       */
+      block_production_metrics get_production_metrics()const;
+
+   private:
+      std::shared_ptr< detail::bobserver_api_impl > my;
+};
+
+} } // sigmaengine::bobserver
+
+FC_API( sigmaengine::bobserver::bobserver_api,
+   (get_production_metrics)
+   )
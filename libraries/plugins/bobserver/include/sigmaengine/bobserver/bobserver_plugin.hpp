@@ -26,6 +26,8 @@
 #include <sigmaengine/app/plugin.hpp>
 #include <sigmaengine/chain/database.hpp>
 
+#include <graphene/net/network_metrics.hpp>
+
 #include <fc/thread/future.hpp>
 
 #define RESERVE_RATIO_PRECISION ((int64_t)10000)
@@ -55,6 +57,15 @@ namespace block_production_condition
    };
 }
 
+/** Timing of the blocks this node produced */
+struct block_production_metrics
+{
+   uint64_t                          blocks_produced = 0;
+   uint64_t                          blocks_reassembled = 0;  ///< rebuilt because a block arrived while we waited for the slot
+   graphene::net::latency_histogram  lateness_ms;             ///< from the slot time to pushing the signed block
+   graphene::net::latency_histogram  assembly_ms;             ///< applying the pending transactions to build the block
+};
+
 namespace detail
 {
    class bobserver_plugin_impl;
@@ -74,6 +85,7 @@ public:
       ) override;
 
    void set_block_production(bool allow) { _production_enabled = allow; }
+   const block_production_metrics& get_production_metrics()const { return _production_metrics; }
 
    virtual void plugin_initialize( const boost::program_options::variables_map& options ) override;
    virtual void plugin_startup() override;
@@ -92,6 +104,10 @@ private:
    block_id_type    _head_block_id        = block_id_type();
    fc::time_point   _hash_start_time;
 
+   fc::microseconds         _production_lead_time = fc::milliseconds( 200 );
+   fc::time_point_sec       _next_slot_time;        ///< the slot the production task wakes up for
+   block_production_metrics _production_metrics;
+
    std::map<public_key_type, fc::ecc::private_key> _private_keys;
    std::set<string>                                _bobservers;
    fc::future<void>                                _block_production_task;
@@ -101,3 +117,5 @@ private:
 };
 
 } } //sigmaengine::bobserver
+
+FC_REFLECT( sigmaengine::bobserver::block_production_metrics, (blocks_produced)(blocks_reassembled)(lateness_ms)(assembly_ms) )
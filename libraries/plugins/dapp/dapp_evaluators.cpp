@@ -565,17 +565,35 @@ namespace sigmaengine { namespace dapp {
          
          const auto& vote_idx = _db.get_index< dapp_vote_index >().indices().get< by_dapp_voter >();
          auto vote_itr = vote_idx.find( std::make_tuple( op.dapp_name, op.voter ) );
+         const auto new_vote = static_cast<dapp_state_type>( op.vote );
+
+         // keep the dapp's tally in step with its votes so the aggregation does not have to count them
+         auto adjust_tally = [&]( dapp_state_type vote, int32_t delta ) {
+            if( vote != dapp_state_type::APPROVAL && vote != dapp_state_type::REJECTION )
+               return;
+            _db.modify( *dapp_name_itr, [&]( dapp_object& object ) {
+               if( vote == dapp_state_type::APPROVAL )
+                  object.approval_count += delta;
+               else
+                  object.rejection_count += delta;
+            });
+         };
 
          if(vote_itr == vote_idx.end()) {
             _db.create< dapp_vote_object >( [&]( dapp_vote_object& object ) {
                object.dapp_name = op.dapp_name;
                object.voter = op.voter;
-               object.vote = static_cast<dapp_state_type>( op.vote );
+               object.vote = new_vote;
                object.last_update = _db.head_block_time();
             });
+            adjust_tally( new_vote, 1 );
          } else {
+            if( vote_itr->vote != new_vote ) {
+               adjust_tally( vote_itr->vote, -1 );
+               adjust_tally( new_vote, 1 );
+            }
             _db.modify( *vote_itr, [&]( dapp_vote_object& object ) {
-               object.vote = static_cast<dapp_state_type>( op.vote );
+               object.vote = new_vote;
                object.last_update = _db.head_block_time();
             });
          }
@@ -605,6 +623,7 @@ namespace sigmaengine { namespace dapp {
             _db.modify( *vote_itr, [&]( dapp_trx_fee_vote_object& object ) {
                object.trx_fee = op.trx_fee;
                object.last_update = _db.head_block_time();
+               object.expired = false;
             });
          }
       } FC_CAPTURE_AND_RETHROW( ( op ) )
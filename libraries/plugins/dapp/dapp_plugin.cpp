@@ -23,11 +23,11 @@ namespace sigmaengine { namespace dapp {
             }
 
             void on_apply_hardfork( const uint32_t hardfork );
-            void on_apply_block( const signed_block& b );
+            uint32_t aggregate_votes();
 
          private:
-            void aggregate_dapp_approve_vote( sigmaengine::chain::database& _db );
-            void aggregate_trx_fee_vote( sigmaengine::chain::database& _db );
+            uint32_t aggregate_dapp_approve_vote( sigmaengine::chain::database& _db );
+            uint32_t aggregate_trx_fee_vote( sigmaengine::chain::database& _db );
 
             dapp_plugin&  _self;
             std::shared_ptr< generic_custom_operation_interpreter< sigmaengine::dapp::dapp_operation > > _custom_op_interpreter;
@@ -51,6 +51,14 @@ namespace sigmaengine { namespace dapp {
          _custom_op_interpreter->register_evaluator< nsta602_approve_evaluator >( &_self );
 
          database().set_custom_operation_interpreter( _self.plugin_name(), _custom_op_interpreter );
+
+         database().register_due_processor( "dapp_vote_aggregation",
+            [this]() -> fc::optional< time_point_sec > {
+               // due once the cycle has fully passed
+               const dynamic_global_property_object& _dgp = database().get_dynamic_global_properties();
+               return time_point_sec( _dgp.last_dapp_voting_aggregation_time + SIGMAENGINE_CHECK_DAPP_CYCLE ) + 1;
+            },
+            [this]( time_point_sec ) { return aggregate_votes(); } );
       }
 
       void dapp_plugin_impl::on_apply_hardfork( const uint32_t hardfork ) {
@@ -98,87 +106,86 @@ namespace sigmaengine { namespace dapp {
          */
       }
 
-      void dapp_plugin_impl::aggregate_dapp_approve_vote( sigmaengine::chain::database& _db ) {
+      uint32_t dapp_plugin_impl::aggregate_dapp_approve_vote( sigmaengine::chain::database& _db ) {
          auto now = _db.head_block_time();
+         uint32_t pending_count = 0;
          
-         const auto& dapp_idx = _db.get_index < dapp_index >().indices().get < by_id >();
+         // votes are only cast on pending dapps and are removed once a dapp is decided,
+         // so only the pending dapps and their tallies need to be looked at
+         const auto& dapp_idx = _db.get_index < dapp_index >().indices().get < by_dapp_state >();
          const auto& vote_idx = _db.get_index < dapp_vote_index >().indices().get < by_dapp_voter >();
 
-         auto dapp_itr = dapp_idx.begin();
-         while( dapp_itr != dapp_idx.end() ) {
-            // aggregate dapp voting
-            if( dapp_itr->dapp_state == dapp_state_type::PENDING ) { 
-               auto vote_itr = vote_idx.lower_bound( dapp_itr->dapp_name );
-               int approval_count = 0, rejection_count = 0;
-               while( vote_itr != vote_idx.end() && vote_itr->dapp_name == dapp_itr->dapp_name ) {
-                  if( vote_itr->vote == dapp_state_type::APPROVAL )
-                     approval_count++;
-                  else if( vote_itr->vote == dapp_state_type::REJECTION )
-                     rejection_count++;
-                  vote_itr++;
-               }
+         auto dapp_itr = dapp_idx.lower_bound( std::make_tuple( dapp_state_type::PENDING ) );
+         while( dapp_itr != dapp_idx.end() && dapp_itr->dapp_state == dapp_state_type::PENDING ) {
+            const auto& dapp = *dapp_itr;
+            dapp_itr++;
+            pending_count++;
 
-               if( approval_count >= SIGMAENGINE_HARDFORK_REQUIRED_BOBSERVERS_HF2 ){
-                  _db.modify( *dapp_itr, [&]( dapp_object& object ) {
-                     object.dapp_state = dapp_state_type::APPROVAL;
-                     object.last_updated = now;
-                  });
-               } else if( rejection_count >= SIGMAENGINE_HARDFORK_REQUIRED_BOBSERVERS_HF2 ){
-                  _db.modify( *dapp_itr, [&]( dapp_object& object ) {
-                     object.dapp_state = dapp_state_type::REJECTION;
-                     object.last_updated = now;
-                  });
-               }
+            if( dapp.approval_count >= SIGMAENGINE_HARDFORK_REQUIRED_BOBSERVERS_HF2 ){
+               _db.modify( dapp, [&]( dapp_object& object ) {
+                  object.dapp_state = dapp_state_type::APPROVAL;
+                  object.last_updated = now;
+               });
+            } else if( dapp.rejection_count >= SIGMAENGINE_HARDFORK_REQUIRED_BOBSERVERS_HF2 ){
+               _db.modify( dapp, [&]( dapp_object& object ) {
+                  object.dapp_state = dapp_state_type::REJECTION;
+                  object.last_updated = now;
+               });
+            } else {
+               continue;
             }
 
             // remove approved or rejected dapp voting
-            if( dapp_itr->dapp_state != dapp_state_type::PENDING ) {
-               auto itr = vote_idx.lower_bound( dapp_itr->dapp_name );
-               while( itr != vote_idx.end() && itr->dapp_name == dapp_itr->dapp_name ) {
-                  auto old_itr = itr; 
-                  itr++;
-                  _db.remove( *old_itr );
-               }
+            auto itr = vote_idx.lower_bound( dapp.dapp_name );
+            while( itr != vote_idx.end() && itr->dapp_name == dapp.dapp_name ) {
+               auto old_itr = itr; 
+               itr++;
+               _db.remove( *old_itr );
             }
+            _db.modify( dapp, [&]( dapp_object& object ) {
+               object.approval_count = 0;
+               object.rejection_count = 0;
+            });
 
             // remove rejected dapp and users 
-            if( dapp_itr->dapp_state == dapp_state_type::REJECTION ) {
-               auto old_itr = dapp_itr; 
+            if( dapp.dapp_state == dapp_state_type::REJECTION ) {
                const auto& user_idx = _db.get_index < dapp_user_index >().indices().get < by_name >();
-               auto user_itr = user_idx.lower_bound( old_itr->dapp_name );
-               while( user_itr != user_idx.end() && user_itr->dapp_name == old_itr->dapp_name ) {
+               auto user_itr = user_idx.lower_bound( dapp.dapp_name );
+               while( user_itr != user_idx.end() && user_itr->dapp_name == dapp.dapp_name ) {
                   auto old_user_itr = user_itr; 
                   user_itr++;
                   _db.remove( *old_user_itr );
                }
 
-               dapp_itr++;
-               _db.remove( *old_itr );
-            } else {
-               dapp_itr++;
+               _db.remove( dapp );
             }
          }
+         return pending_count;
       }
 
-      void dapp_plugin_impl::aggregate_trx_fee_vote ( sigmaengine::chain::database& _db ) {
+      uint32_t dapp_plugin_impl::aggregate_trx_fee_vote ( sigmaengine::chain::database& _db ) {
          auto now = _db.head_block_time();
          const dynamic_global_property_object& dgp = _db.get_dynamic_global_properties();
 
-         const auto& vote_idx = _db.get_index< dapp_trx_fee_vote_index >().indicies().get< by_voter >();
-         auto vote_itr = vote_idx.begin();
-         vector< asset > trx_fee_list;
-         while( vote_itr != vote_idx.end() ) {
-            if( now < vote_itr->last_update + SIGMAENGINE_MAX_FEED_AGE_SECONDS ){
-               trx_fee_list.push_back( vote_itr->trx_fee );
-            }
-            vote_itr++;
+         // votes leave the count as they age out; each vote is visited once until it is cast again
+         const auto& expire_idx = _db.get_index< dapp_trx_fee_vote_index >().indicies().get< by_expired_last_update >();
+         auto expire_itr = expire_idx.begin();
+         while( expire_itr != expire_idx.end() && !expire_itr->expired
+            && now >= expire_itr->last_update + SIGMAENGINE_MAX_FEED_AGE_SECONDS ) {
+            _db.modify( *expire_itr, []( dapp_trx_fee_vote_object& object ) {
+               object.expired = true;
+            });
+            expire_itr = expire_idx.begin();
          }
 
-         //ilog( "aggregate_trx_fee_vote : trx_fee_list.size() = ${s}", ( "s", trx_fee_list.size() ) );
+         // unexpired votes come first, ordered by fee, so the median is found by rank
+         const auto& fee_idx = _db.get_index< dapp_trx_fee_vote_index >().indicies().get< by_expired_fee >();
+         uint32_t vote_count = fee_idx.rank( fee_idx.lower_bound( std::make_tuple( true ) ) );
+
+         //ilog( "aggregate_trx_fee_vote : vote_count = ${s}", ( "s", vote_count ) );
 
-         if( trx_fee_list.size() >= SIGMAENGINE_MIN_FEEDS ) {
-            std::sort( trx_fee_list.begin(), trx_fee_list.end() );
-            auto median_value = trx_fee_list[ trx_fee_list.size()/2 ];
+         if( vote_count >= SIGMAENGINE_MIN_FEEDS ) {
+            auto median_value = fee_idx.nth( vote_count/2 )->trx_fee;
 
             _db.modify( dgp, [&]( dynamic_global_property_object& object ) {
                object.dapp_transaction_fee = median_value;
@@ -186,24 +193,24 @@ namespace sigmaengine { namespace dapp {
 
             //ilog( "aggregate_trx_fee_vote : median_value = ${med}", ( "med", median_value ) );
          }
+         return vote_count;
       }
 
-      void dapp_plugin_impl::on_apply_block( const signed_block& b ) {
+      uint32_t dapp_plugin_impl::aggregate_votes() {
          auto& _db = database();
          auto now = _db.head_block_time();
          const dynamic_global_property_object& _dgp = _db.get_dynamic_global_properties();
 
-         if( now > _dgp.last_dapp_voting_aggregation_time + SIGMAENGINE_CHECK_DAPP_CYCLE ) {
-            dlog( "dapp_plugin_impl::on_apply_block : block_no = ${no}, now/dapp voting time = ${now}/${dapp_vote_time}"
-               , ( "no", b.block_num() )( "now", now )( "dapp_vote_time", _dgp.last_dapp_voting_aggregation_time ) );
-               
-            aggregate_dapp_approve_vote( _db );
-            aggregate_trx_fee_vote( _db );
+         dlog( "dapp_plugin_impl::aggregate_votes : block_no = ${no}, now/dapp voting time = ${now}/${dapp_vote_time}"
+            , ( "no", _db.head_block_num() )( "now", now )( "dapp_vote_time", _dgp.last_dapp_voting_aggregation_time ) );
 
-            _db.modify( _dgp, [&]( dynamic_global_property_object& dgp ) {
-               dgp.last_dapp_voting_aggregation_time = now;
-            });
-         }
+         uint32_t processed = aggregate_dapp_approve_vote( _db );
+         processed += aggregate_trx_fee_vote( _db );
+
+         _db.modify( _dgp, [&]( dynamic_global_property_object& dgp ) {
+            dgp.last_dapp_voting_aggregation_time = now;
+         });
+         return processed;
       }
 
    } //namespace detail
@@ -233,10 +240,6 @@ namespace sigmaengine { namespace dapp {
             _my->on_apply_hardfork( hardfork ); 
          });
 
-         db.applied_block.connect( [&]( const signed_block& b ){ 
-            _my->on_apply_block( b ); 
-         });
-
       } FC_CAPTURE_AND_RETHROW()
    }
 
@@ -4,6 +4,7 @@
 #include <sigmaengine/chain/sigmaengine_object_types.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 namespace sigmaengine { namespace dapp {
    using namespace std;
@@ -72,6 +73,10 @@ namespace sigmaengine { namespace dapp {
          dapp_state_type         dapp_state = dapp_state_type::PENDING;    
          time_point_sec          created;
          time_point_sec          last_updated;
+
+         /// votes currently cast on this dapp while it is pending, kept up to date by vote_dapp_evaluator
+         uint32_t                approval_count = 0;
+         uint32_t                rejection_count = 0;
    };
 
    typedef oid< dapp_object > dapp_id_type;
@@ -193,6 +198,10 @@ namespace sigmaengine { namespace dapp {
          account_name_type       voter;
          asset                   trx_fee = asset(0, SGT_SYMBOL);
          time_point_sec          last_update;
+         /// set by the aggregation once last_update is older than SIGMAENGINE_MAX_FEED_AGE_SECONDS, cleared by a new vote
+         bool                    expired = false;
+
+         share_type fee_amount()const { return trx_fee.amount; }
    };
    typedef oid< dapp_trx_fee_vote_object > dapp_trx_fee_vote_id_type;
 
@@ -265,6 +274,9 @@ namespace sigmaengine { namespace dapp {
    struct by_user_name;
 
    struct by_dapp_voter;
+   struct by_dapp_state;
+   struct by_expired_fee;
+   struct by_expired_last_update;
 
    struct by_voter;
 
@@ -289,6 +301,12 @@ namespace sigmaengine { namespace dapp {
          >,
          ordered_non_unique < tag < by_owner >,
             member < dapp_object, account_name_type, &dapp_object::owner >
+         >,
+         ordered_unique < tag < by_dapp_state >,
+            composite_key< dapp_object,
+               member < dapp_object, dapp_state_type, &dapp_object::dapp_state >,
+               member < dapp_object, dapp_id_type, &dapp_object::id >
+            >
          >
       >,
       allocator < dapp_object >
@@ -454,6 +472,20 @@ namespace sigmaengine { namespace dapp {
             composite_key< dapp_trx_fee_vote_object,
                member < dapp_trx_fee_vote_object, account_name_type, &dapp_trx_fee_vote_object::voter >
             >
+         >,
+         ranked_unique < tag < by_expired_fee >,
+            composite_key< dapp_trx_fee_vote_object,
+               member < dapp_trx_fee_vote_object, bool, &dapp_trx_fee_vote_object::expired >,
+               const_mem_fun < dapp_trx_fee_vote_object, share_type, &dapp_trx_fee_vote_object::fee_amount >,
+               member < dapp_trx_fee_vote_object, dapp_trx_fee_vote_id_type, &dapp_trx_fee_vote_object::id >
+            >
+         >,
+         ordered_unique < tag < by_expired_last_update >,
+            composite_key< dapp_trx_fee_vote_object,
+               member < dapp_trx_fee_vote_object, bool, &dapp_trx_fee_vote_object::expired >,
+               member < dapp_trx_fee_vote_object, time_point_sec, &dapp_trx_fee_vote_object::last_update >,
+               member < dapp_trx_fee_vote_object, dapp_trx_fee_vote_id_type, &dapp_trx_fee_vote_object::id >
+            >
          >
       >,
       allocator < dapp_trx_fee_vote_object >
@@ -586,6 +618,8 @@ FC_REFLECT( sigmaengine::dapp::dapp_object,
    ( dapp_state )
    ( created )
    ( last_updated )
+   ( approval_count )
+   ( rejection_count )
 )
 
 FC_REFLECT(sigmaengine::dapp::dapp_comment_object,
@@ -644,6 +678,7 @@ FC_REFLECT( sigmaengine::dapp::dapp_trx_fee_vote_object,
    ( voter )
    ( trx_fee )
    ( last_update )
+   ( expired )
 )
 
 FC_REFLECT( sigmaengine::dapp::dapp_nsta602_object,
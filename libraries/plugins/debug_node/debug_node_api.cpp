@@ -47,6 +47,7 @@ class debug_node_api_impl
       uint32_t debug_generate_blocks( const std::string& debug_key, uint32_t count );
       uint32_t debug_generate_blocks_until( const std::string& debug_key, const fc::time_point_sec& head_block_time, bool generate_sparsely );
       fc::optional< sigmaengine::chain::signed_block > debug_pop_block();
+      debug_fork_storm_result debug_fork_storm( uint32_t rounds, uint32_t depth );
       //void debug_push_block( const sigmaengine::chain::signed_block& block );
       sigmaengine::chain::bobserver_schedule_object debug_get_bobserver_schedule();
       sigmaengine::chain::hardfork_property_object debug_get_hardfork_property_object();
@@ -188,6 +189,11 @@ fc::optional< sigmaengine::chain::signed_block > debug_node_api_impl::debug_pop_
    return db->fetch_block_by_number( db->head_block_num() );
 }
 
+debug_fork_storm_result debug_node_api_impl::debug_fork_storm( uint32_t rounds, uint32_t depth )
+{
+   return get_plugin()->debug_fork_storm( rounds, depth );
+}
+
 /*void debug_node_api_impl::debug_push_block( const sigmaengine::chain::signed_block& block )
 {
    app.chain_database()->push_block( block );
@@ -287,6 +293,11 @@ fc::optional< sigmaengine::chain::signed_block > debug_node_api::debug_pop_block
    return my->debug_pop_block();
 }
 
+debug_fork_storm_result debug_node_api::debug_fork_storm( uint32_t rounds, uint32_t depth )
+{
+   return my->debug_fork_storm( rounds, depth );
+}
+
 /*void debug_node_api::debug_push_block( sigmaengine::chain::signed_block& block )
 {
    my->debug_push_block( block );
@@ -286,6 +286,64 @@ uint32_t debug_node_plugin::debug_generate_blocks_until(
    return new_blocks;
 }
 
+debug_fork_storm_result debug_node_plugin::debug_fork_storm( uint32_t rounds, uint32_t depth )
+{
+   FC_ASSERT( depth > 0, "Fork depth must be positive" );
+
+   // Blocks are produced unsigned for whichever bobserver is scheduled, so no debug keys are needed.
+   // The forks must stay within the reversible window, so depth is limited by the irreversibility lag.
+   const uint32_t skip = sigmaengine::chain::database::skip_bobserver_signature;
+   const fc::ecc::private_key storm_key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "debug_fork_storm" ) ) );
+
+   chain::database& db = database();
+   debug_fork_storm_result result;
+   result.depth = depth;
+
+   auto generate_branch = [&]( uint32_t count, uint32_t first_slot ) -> std::vector< chain::signed_block >
+   {
+      std::vector< chain::signed_block > branch;
+      branch.reserve( count );
+      uint32_t slot = first_slot;
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         branch.push_back( db.generate_block( db.get_slot_time( slot ), db.get_scheduled_bobserver( slot ), storm_key, skip ) );
+         slot = 1;
+      }
+      return branch;
+   };
+
+   for( uint32_t round = 0; round < rounds; ++round )
+   {
+      // Build the longer branch first, skipping a slot so its blocks differ from the shorter one
+      std::vector< chain::signed_block > long_branch = generate_branch( depth + 1, 2 );
+      db.with_write_lock( [&]()
+      {
+         for( uint32_t i = 0; i <= depth; ++i )
+            db.pop_block();
+      });
+
+      // Build the shorter branch on top of the same fork point, then make the longer one win
+      generate_branch( depth, 1 );
+
+      fc::time_point start = fc::time_point::now();
+      db.push_block( long_branch.back(), skip );
+      int64_t elapsed = ( fc::time_point::now() - start ).count();
+
+      FC_ASSERT( db.head_block_id() == long_branch.back().id(), "Fork switch did not happen",
+         ("round", round)("head", db.head_block_id())("expected", long_branch.back().id()) );
+
+      result.total_switch_us += elapsed;
+      result.max_switch_us = std::max( result.max_switch_us, elapsed );
+      ++result.rounds;
+   }
+
+   if( result.rounds > 0 )
+      result.avg_switch_us = result.total_switch_us / result.rounds;
+
+   if( logging ) ilog( "Fork storm: ${r}", ("r", result) );
+   return result;
+}
+
 void debug_node_plugin::apply_debug_updates()
 {
    // this was a method on database in Graphene
@@ -12,6 +12,8 @@
 
 #include <sigmaengine/chain/bobserver_objects.hpp>
 
+#include <sigmaengine/plugins/debug_node/debug_node_plugin.hpp>
+
 namespace sigmaengine { namespace app {
    struct api_context;
 } }
@@ -66,6 +68,11 @@ class debug_node_api
       // not implemented
       //void debug_push_block( sigmaengine::chain::signed_block& block );
 
+      /*
+       * Switch forks repeatedly between competing branches of the given depth and report push_block timings.
+       */
+      debug_fork_storm_result debug_fork_storm( uint32_t rounds, uint32_t depth );
+
       sigmaengine::chain::bobserver_schedule_object debug_get_bobserver_schedule();
 
       sigmaengine::chain::hardfork_property_object debug_get_hardfork_property_object();
@@ -143,6 +150,7 @@ FC_API(sigmaengine::plugin::debug_node::debug_node_api,
        (debug_generate_blocks)
        (debug_generate_blocks_until)
        (debug_pop_block)
+       (debug_fork_storm)
        //(debug_push_block)
        //(debug_update_object)
        //(debug_get_edits)
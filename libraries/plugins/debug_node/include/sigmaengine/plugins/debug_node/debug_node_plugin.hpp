@@ -22,6 +22,15 @@ using app::application;
 
 namespace detail { class debug_node_plugin_impl; }
 
+struct debug_fork_storm_result
+{
+   uint32_t                                rounds = 0;
+   uint32_t                                depth = 0;
+   int64_t                                 total_switch_us = 0;
+   int64_t                                 max_switch_us = 0;
+   int64_t                                 avg_switch_us = 0;
+};
+
 class private_key_storage
 {
    public:
@@ -83,6 +92,12 @@ class debug_node_plugin : public sigmaengine::app::plugin
          private_key_storage* key_storage = nullptr
          );
 
+      /**
+       * Repeatedly builds two competing branches of the given depth and measures
+       * the time taken by push_block to switch from one to the other.
+       */
+      debug_fork_storm_result debug_fork_storm( uint32_t rounds, uint32_t depth );
+
       void set_json_object_stream( const std::string& filename );
       void flush_json_object_stream();
 
@@ -113,3 +128,11 @@ class debug_node_plugin : public sigmaengine::app::plugin
 };
 
 } } }
+
+FC_REFLECT( sigmaengine::plugin::debug_node::debug_fork_storm_result,
+   (rounds)
+   (depth)
+   (total_switch_us)
+   (max_switch_us)
+   (avg_switch_us)
+   )
@@ -29,22 +29,45 @@
 #include <sigmaengine/chain/database.hpp>
 #include <sigmaengine/app/api.hpp>
 #include <sigmaengine/app/database_api.hpp>
+#include <sigmaengine/plugins/raw_block/raw_block_api.hpp>
 
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <fc/crypto/base64.hpp>
+
+#include <deque>
 
 
 namespace sigmaengine { namespace delayed_node {
 namespace bpo = boost::program_options;
 
+/**
+ * Blocks come from the trusted node's irreversible chain, so they get the checks a
+ * reindex skips.  They are still written to the block log.
+ */
+static const uint32_t trusted_block_skip_flags =
+   sigmaengine::chain::database::skip_bobserver_signature |
+   sigmaengine::chain::database::skip_transaction_signatures |
+   sigmaengine::chain::database::skip_transaction_dupe_check |
+   sigmaengine::chain::database::skip_tapos_check |
+   sigmaengine::chain::database::skip_merkle_check |
+   sigmaengine::chain::database::skip_bobserver_schedule_check |
+   sigmaengine::chain::database::skip_authority_check |
+   sigmaengine::chain::database::skip_validate |
+   sigmaengine::chain::database::skip_validate_invariants;
+
 namespace detail {
 struct delayed_node_plugin_impl {
    std::string remote_endpoint;
    fc::http::websocket_client client;
    std::shared_ptr<fc::rpc::websocket_api_connection> client_connection;
    fc::api<sigmaengine::app::database_api> database_api;
+   /// Set when the trusted node serves raw_block_api, which lets blocks be fetched in ranges
+   fc::optional< fc::api<sigmaengine::plugin::raw_block::raw_block_api> > raw_block_api;
+   uint32_t batch_size = 500;
+   uint32_t pipeline_depth = 4;
    boost::signals2::scoped_connection client_connection_closed;
    sigmaengine::chain::block_id_type last_received_remote_head;
    sigmaengine::chain::block_id_type last_processed_remote_head;
@@ -62,6 +85,8 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
 {
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>(), "RPC endpoint of a trusted validating node (required)")
+         ("trusted-node-batch-size", boost::program_options::value<uint32_t>()->default_value(500), "Blocks fetched from the trusted node per request, at most 1000")
+         ("trusted-node-pipeline", boost::program_options::value<uint32_t>()->default_value(4), "Block requests to the trusted node kept in flight while blocks are applied")
          ;
    cfg.add(cli);
 }
@@ -73,12 +98,26 @@ void delayed_node_plugin::connect()
    my->client_connection_closed = my->client_connection->closed.connect([this] {
       connection_failed();
    });
+
+   my->raw_block_api.reset();
+   try
+   {
+      auto login = my->client_connection->get_remote_api<sigmaengine::app::login_api>(1);
+      login->login( "", "" );
+      my->raw_block_api = login->get_api_by_name( "raw_block_api" )->as<sigmaengine::plugin::raw_block::raw_block_api>();
+   }
+   catch( const fc::exception& )
+   {
+      wlog( "Trusted node does not serve raw_block_api, syncing one block at a time" );
+   }
 }
 
 void delayed_node_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    FC_ASSERT( options.count( "trusted-node" ) > 0 );
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   my->batch_size = std::min< uint32_t >( std::max< uint32_t >( options.at("trusted-node-batch-size").as<uint32_t>(), 1 ), 1000 );
+   my->pipeline_depth = std::max< uint32_t >( options.at("trusted-node-pipeline").as<uint32_t>(), 1 );
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -102,15 +141,73 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
+      if( my->raw_block_api.valid() )
+      {
+         synced_blocks += sync_block_range( remote_dpo.last_irreversible_block_num );
+         continue;
+      }
       while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
       {
          fc::optional<sigmaengine::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
          FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
          ilog("Pushing block #${n}", ("n", block->block_num()));
-         db.push_block(*block);
+         db.push_block(*block, trusted_block_skip_flags);
+         synced_blocks++;
+      }
+   }
+}
+
+/**
+ * Fetches the blocks up to last_block_num in ranges, keeping several requests in
+ * flight so the trusted node and the network work while earlier ranges are applied.
+ */
+uint32_t delayed_node_plugin::sync_block_range( uint32_t last_block_num )
+{
+   auto& db = database();
+   auto raw_block_api = *my->raw_block_api;
+   std::deque< fc::future< sigmaengine::plugin::raw_block::get_raw_block_range_result > > requests;
+   uint32_t next_block_num = db.head_block_num() + 1;
+
+   auto request_more = [&]()
+   {
+      while( requests.size() < my->pipeline_depth && next_block_num <= last_block_num )
+      {
+         sigmaengine::plugin::raw_block::get_raw_block_range_args args;
+         args.start_block_num = next_block_num;
+         args.count = std::min( my->batch_size, last_block_num - next_block_num + 1 );
+         next_block_num += args.count;
+         requests.push_back( fc::async( [raw_block_api, args]()
+         {
+            return raw_block_api->get_raw_block_range( args );
+         }, "delayed_node get_raw_block_range" ) );
+      }
+      // let the new requests go out before blocking on push_block
+      fc::yield();
+   };
+
+   uint32_t synced_blocks = 0;
+   request_more();
+   while( requests.size() )
+   {
+      auto range = requests.front().wait();
+      requests.pop_front();
+      request_more();
+
+      FC_ASSERT( range.count > 0, "Trusted node claims it has blocks it doesn't actually have." );
+      std::string raw_blocks = fc::base64_decode( range.raw_blocks );
+      fc::datastream<const char*> ds( raw_blocks.data(), raw_blocks.size() );
+      for( uint32_t i = 0; i < range.count; ++i )
+      {
+         sigmaengine::chain::signed_block block;
+         fc::raw::unpack( ds, block );
+         FC_ASSERT( block.block_num() == db.head_block_num() + 1, "Trusted node sent block #${n} instead of #${e}",
+                    ("n", block.block_num())("e", db.head_block_num() + 1) );
+         db.push_block( block, trusted_block_skip_flags );
          synced_blocks++;
       }
+      ilog( "Pushed blocks to #${n}", ("n", db.head_block_num()) );
    }
+   return synced_blocks;
 }
 
 void delayed_node_plugin::mainloop()
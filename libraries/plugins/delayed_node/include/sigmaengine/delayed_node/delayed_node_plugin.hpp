@@ -49,6 +49,7 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   uint32_t sync_block_range( uint32_t last_block_num );
 };
 
 } } //sigmaengine::account_history
@@ -0,0 +1,55 @@
+#include <sigmaengine/app/api_context.hpp>
+
+#include <sigmaengine/event_subscription/event_subscription_api.hpp>
+
+namespace sigmaengine { namespace event_subscription {
+
+namespace detail
+{
+
+class event_subscription_api_impl
+{
+   public:
+      event_subscription_api_impl( const sigmaengine::app::api_context& ctx )
+         :_plugin( ctx.app.get_plugin< event_subscription_plugin >( EVENT_SUBSCRIPTION_PLUGIN_NAME ) )
+      {
+         auto session = ctx.session.lock();
+         _stateless = !session || session->stateless;
+      }
+
+      std::shared_ptr< event_subscription_plugin > _plugin;
+      /// Events can only be pushed over a websocket, and the HTTP session is never closed
+      bool                                         _stateless = false;
+};
+
+} // detail
+
+event_subscription_api::event_subscription_api( const sigmaengine::app::api_context& ctx )
+{
+   _my = std::make_shared< detail::event_subscription_api_impl >( ctx );
+}
+
+event_subscription_api::~event_subscription_api()
+{
+   _my->_plugin->unsubscribe_owner( this );
+}
+
+void event_subscription_api::on_api_startup() {}
+
+uint32_t event_subscription_api::subscribe( std::function< void( const fc::variant& ) > cb, event_filter filter )
+{
+   FC_ASSERT( !_my->_stateless, "subscribe needs a websocket connection" );
+   return _my->_plugin->subscribe( this, cb, filter );
+}
+
+void event_subscription_api::unsubscribe( uint32_t subscription_id )
+{
+   _my->_plugin->unsubscribe( this, subscription_id );
+}
+
+vector< subscription_info > event_subscription_api::get_subscriptions()const
+{
+   return _my->_plugin->get_subscriptions( this );
+}
+
+} } // sigmaengine::event_subscription
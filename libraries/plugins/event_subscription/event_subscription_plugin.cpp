@@ -0,0 +1,508 @@
+#include <sigmaengine/event_subscription/event_subscription_plugin.hpp>
+#include <sigmaengine/event_subscription/event_subscription_api.hpp>
+
+#include <sigmaengine/app/impacted.hpp>
+#include <sigmaengine/chain/operation_notification.hpp>
+#include <sigmaengine/dapp_history/dapp_impacted.hpp>
+#include <sigmaengine/token/token_objects.hpp>
+#include <sigmaengine/token/token_operations.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <algorithm>
+#include <deque>
+
+namespace sigmaengine { namespace event_subscription {
+
+namespace detail
+{
+   using sigmaengine::chain::operation_notification;
+
+   /// the type name without its namespace, e.g. transfer_operation
+   struct operation_name_visitor
+   {
+      typedef string result_type;
+
+      template< typename T >
+      string operator()( const T& )const
+      {
+         string name = fc::get_typename< T >::name();
+         auto pos = name.rfind( "::" );
+         return pos == string::npos ? name : name.substr( pos + 2 );
+      }
+   };
+
+   /// the tokens an operation touches, including token operations wrapped in custom operations
+   struct token_visitor
+   {
+      typedef void result_type;
+
+      flat_set< token_name_type >& _names;
+      flat_set< asset_symbol_type >& _symbols;
+
+      token_visitor( flat_set< token_name_type >& names, flat_set< asset_symbol_type >& symbols )
+         : _names( names ), _symbols( symbols ) {}
+
+      template< typename T >
+      void operator()( const T& )const {}
+
+      void operator()( const fill_token_staking_fund_operation& op )const { _names.insert( op.token ); }
+      void operator()( const fill_transfer_token_savings_operation& op )const { _names.insert( op.token ); }
+
+      void operator()( const custom_json_operation& op )const { from_json( op.json ); }
+      void operator()( const custom_json_dapp_operation& op )const { from_json( op.json ); }
+
+      void operator()( const custom_binary_operation& op )const
+      {
+         try
+         {
+            vector< token::token_operation > operations;
+            try
+            {
+               operations = fc::raw::unpack< vector< token::token_operation > >( op.data );
+            }
+            catch( const fc::exception& )
+            {
+               operations.push_back( fc::raw::unpack< token::token_operation >( op.data ) );
+            }
+            for( const auto& inner : operations )
+               inner.visit( *this );
+         }
+         catch( const fc::exception& ) {}
+      }
+
+      void operator()( const token::create_token_operation& op )const { _names.insert( op.name ); }
+      void operator()( const token::issue_token_operation& op )const { _names.insert( op.name ); }
+      void operator()( const token::transfer_token_operation& op )const { _symbols.insert( op.amount.symbol ); }
+      void operator()( const token::burn_token_operation& op )const { _symbols.insert( op.amount.symbol ); }
+      void operator()( const token::setup_token_fund_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::set_token_staking_interest_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::transfer_token_fund_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::staking_token_fund_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::transfer_token_savings_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::cancel_transfer_token_savings_operation& op )const { _names.insert( op.token ); }
+      void operator()( const token::conclude_transfer_token_savings_operation& op )const { _names.insert( op.token ); }
+
+      void from_json( const string& json )const
+      {
+         try
+         {
+            auto var = fc::json::from_string( json );
+            vector< token::token_operation > operations;
+            if( var.is_array() && var.size() > 0 && var.get_array()[0].is_array() )
+               from_variant( var, operations );
+            else
+            {
+               operations.emplace_back();
+               from_variant( var, operations[0] );
+            }
+            for( const auto& inner : operations )
+               inner.visit( *this );
+         }
+         catch( const fc::exception& ) {}
+      }
+   };
+
+   struct subscriber
+   {
+      uint32_t                                     id = 0;
+      const void*                                  owner = nullptr;
+      std::function< void( const fc::variant& ) >  callback;
+      event_filter                                 filter;
+      flat_set< int64_t >                          operation_types;
+      uint32_t                                     max_queued_blocks = 0;
+
+      vector< applied_operation >                  block_operations;  ///< matched so far in the block being applied
+      uint64_t                                     last_operation = 0;  ///< sequence of the last operation matched against
+      std::deque< block_event >                    queue;
+      uint32_t                                     missed_since_delivery = 0;
+      uint64_t                                     delivered_blocks = 0;
+      uint64_t                                     missed_blocks = 0;
+      bool                                         delivering = false;
+      bool                                         closed = false;
+   };
+
+   class event_subscription_plugin_impl
+   {
+      public:
+         event_subscription_plugin_impl( event_subscription_plugin& plugin )
+            : _self( plugin ) {}
+
+         chain::database& database() { return _self.database(); }
+
+         void on_pre_apply_block( const signed_block& b );
+         void on_operation( const operation_notification& note );
+         void on_applied_block( const signed_block& b );
+
+         uint32_t subscribe( const void* owner, std::function< void( const fc::variant& ) > cb, const event_filter& filter );
+         void remove( uint32_t id );
+         void reindex();
+         void deliver( const std::shared_ptr< subscriber >& s );
+         void get_tokens( const operation& op, flat_set< string >& tokens );
+
+         /// subscriptions are only touched from the thread blocks are applied on
+         template< typename Lambda >
+         auto on_chain_thread( Lambda&& f ) -> decltype( f() )
+         {
+            if( _thread == nullptr || &fc::thread::current() == _thread )
+               return f();
+            return _thread->async( std::forward< Lambda >( f ), "event subscription" ).wait();
+         }
+
+         event_subscription_plugin&                                _self;
+         fc::thread*                                               _thread = nullptr;
+
+         std::map< uint32_t, std::shared_ptr< subscriber > >      _subscribers;
+         std::map< account_name_type, vector< subscriber* > >     _by_account;
+         vector< subscriber* >                                     _without_account_filter;
+         std::map< string, int64_t >                               _operation_types;
+         uint32_t                                                  _next_id = 1;
+
+         bool                                                      _applying_block = false;
+         fc::time_point_sec                                        _block_time;
+         uint64_t                                                  _operation_sequence = 0;
+
+         uint32_t                                                  _max_queued_blocks = 64;
+         uint32_t                                                  _max_per_connection = 16;
+         uint32_t                                                  _max_filter_entries = 1000;
+   };
+
+   void event_subscription_plugin_impl::on_pre_apply_block( const signed_block& b )
+   {
+      // operations of a pending transaction or of a block that failed to apply are not sent
+      _applying_block = true;
+      _block_time = b.timestamp;
+      for( auto& item : _subscribers )
+         item.second->block_operations.clear();
+   }
+
+   void event_subscription_plugin_impl::on_operation( const operation_notification& note )
+   {
+      if( !_applying_block || _subscribers.empty() )
+         return;
+
+      chain::database& db = database();
+      ++_operation_sequence;
+
+      flat_set< account_name_type > accounts;
+      if( _by_account.size() )
+         app::operation_get_impacted_accounts( note.op, db, accounts );
+
+      // only worked out when a subscription filters on them
+      bool have_dapps = false;
+      flat_set< dapp_name_type > dapps;
+      bool have_tokens = false;
+      flat_set< string > tokens;
+      fc::optional< applied_operation > applied;
+
+      auto match = [&]( subscriber& s )
+      {
+         if( s.last_operation == _operation_sequence )
+            return;
+         s.last_operation = _operation_sequence;
+
+         if( note.virtual_op && !s.filter.virtual_ops )
+            return;
+         if( s.operation_types.size() && s.operation_types.find( note.op.which() ) == s.operation_types.end() )
+            return;
+         if( s.filter.dapps.size() )
+         {
+            if( !have_dapps )
+            {
+               dapp_history::operation_get_impacted_dapp( note.op, db, dapps );
+               have_dapps = true;
+            }
+            if( std::none_of( dapps.begin(), dapps.end(), [&]( const dapp_name_type& d ){ return s.filter.dapps.count( d ); } ) )
+               return;
+         }
+         if( s.filter.tokens.size() )
+         {
+            if( !have_tokens )
+            {
+               get_tokens( note.op, tokens );
+               have_tokens = true;
+            }
+            if( std::none_of( tokens.begin(), tokens.end(), [&]( const string& t ){ return s.filter.tokens.count( t ); } ) )
+               return;
+         }
+
+         if( !applied.valid() )
+         {
+            applied = applied_operation();
+            applied->trx_id       = note.trx_id;
+            applied->block        = note.block;
+            applied->trx_in_block = note.trx_in_block;
+            applied->op_in_trx    = note.op_in_trx;
+            applied->virtual_op   = note.virtual_op;
+            applied->timestamp    = _block_time;
+            applied->op           = note.op;
+         }
+         s.block_operations.push_back( *applied );
+      };
+
+      for( const auto& account : accounts )
+      {
+         auto itr = _by_account.find( account );
+         if( itr != _by_account.end() )
+            for( subscriber* s : itr->second )
+               match( *s );
+      }
+      for( subscriber* s : _without_account_filter )
+         match( *s );
+   }
+
+   void event_subscription_plugin_impl::on_applied_block( const signed_block& b )
+   {
+      _applying_block = false;
+
+      block_event event;
+      event.block_num = b.block_num();
+      event.block_id  = b.id();
+      event.timestamp = b.timestamp;
+
+      for( auto& item : _subscribers )
+      {
+         const auto& s = item.second;
+         if( s->block_operations.empty() && !s->filter.empty_blocks )
+            continue;
+
+         if( s->queue.size() >= s->max_queued_blocks )
+         {
+            s->queue.pop_front();
+            ++s->missed_since_delivery;
+            ++s->missed_blocks;
+         }
+         s->queue.push_back( event );
+         s->queue.back().operations = std::move( s->block_operations );
+         s->block_operations.clear();
+
+         if( !s->delivering )
+            deliver( s );
+      }
+   }
+
+   /**
+    *  Sends the queued blocks of a subscription one at a time, so a connection that is slow
+    *  to take them only holds up its own queue.
+    */
+   void event_subscription_plugin_impl::deliver( const std::shared_ptr< subscriber >& s )
+   {
+      s->delivering = true;
+      fc::async( [this,s]()
+      {
+         while( !s->closed && s->queue.size() )
+         {
+            block_event event = std::move( s->queue.front() );
+            s->queue.pop_front();
+            event.missed_blocks = s->missed_since_delivery;
+            s->missed_since_delivery = 0;
+            try
+            {
+               s->callback( fc::variant( event ) );
+               ++s->delivered_blocks;
+            }
+            catch( ... )
+            {
+               // the connection is gone
+               remove( s->id );
+            }
+         }
+         s->delivering = false;
+      }, "event subscription delivery" );
+   }
+
+   void event_subscription_plugin_impl::get_tokens( const operation& op, flat_set< string >& tokens )
+   {
+      flat_set< token_name_type > names;
+      flat_set< asset_symbol_type > symbols;
+      op.visit( token_visitor( names, symbols ) );
+      if( names.empty() && symbols.empty() )
+         return;
+
+      const auto& by_name = database().get_index< token::token_index >().indices().get< token::by_name >();
+      const auto& by_symbol = database().get_index< token::token_index >().indices().get< token::by_symbol >();
+      for( const auto& name : names )
+      {
+         tokens.insert( string( name ) );
+         auto itr = by_name.find( name );
+         if( itr != by_name.end() )
+            tokens.insert( asset( 0, itr->symbol ).symbol_name() );
+      }
+      for( const auto& symbol : symbols )
+      {
+         tokens.insert( asset( 0, symbol ).symbol_name() );
+         auto itr = by_symbol.find( symbol );
+         if( itr != by_symbol.end() )
+            tokens.insert( string( itr->name ) );
+      }
+   }
+
+   uint32_t event_subscription_plugin_impl::subscribe( const void* owner, std::function< void( const fc::variant& ) > cb, const event_filter& filter )
+   {
+      FC_ASSERT( filter.accounts.size() <= _max_filter_entries && filter.operations.size() <= _max_filter_entries
+         && filter.tokens.size() <= _max_filter_entries && filter.dapps.size() <= _max_filter_entries,
+         "A filter list may have at most ${max} entries", ("max", _max_filter_entries) );
+
+      uint32_t owned = 0;
+      for( const auto& item : _subscribers )
+         if( item.second->owner == owner )
+            ++owned;
+      FC_ASSERT( owned < _max_per_connection, "A connection may have at most ${max} subscriptions", ("max", _max_per_connection) );
+
+      auto s = std::make_shared< subscriber >();
+      for( const string& name : filter.operations )
+      {
+         auto itr = _operation_types.find( name );
+         FC_ASSERT( itr != _operation_types.end(), "Unknown operation ${name}", ("name", name) );
+         s->operation_types.insert( itr->second );
+      }
+
+      s->id = _next_id++;
+      s->owner = owner;
+      s->callback = cb;
+      s->filter = filter;
+      s->max_queued_blocks = filter.max_queued_blocks ? std::min( filter.max_queued_blocks, _max_queued_blocks ) : _max_queued_blocks;
+      _subscribers[ s->id ] = s;
+      reindex();
+      return s->id;
+   }
+
+   void event_subscription_plugin_impl::remove( uint32_t id )
+   {
+      auto itr = _subscribers.find( id );
+      if( itr == _subscribers.end() )
+         return;
+      itr->second->closed = true;
+      _subscribers.erase( itr );
+      reindex();
+   }
+
+   /// subscriptions change rarely next to operations, so the account lookup is rebuilt whole
+   void event_subscription_plugin_impl::reindex()
+   {
+      _by_account.clear();
+      _without_account_filter.clear();
+      for( const auto& item : _subscribers )
+      {
+         subscriber* s = item.second.get();
+         if( s->filter.accounts.empty() )
+            _without_account_filter.push_back( s );
+         for( const auto& account : s->filter.accounts )
+            _by_account[ account ].push_back( s );
+      }
+   }
+
+} // detail
+
+event_subscription_plugin::event_subscription_plugin( application* app )
+   : plugin( app ), _my( new detail::event_subscription_plugin_impl( *this ) ) {}
+
+event_subscription_plugin::~event_subscription_plugin() {}
+
+void event_subscription_plugin::plugin_set_program_options(
+   boost::program_options::options_description& cli,
+   boost::program_options::options_description& cfg
+)
+{
+   cli.add_options()
+         ("event-subscription-max-queued-blocks", boost::program_options::value< uint32_t >()->default_value( 64 ),
+           "Blocks queued for a subscription that is slow to take them before the oldest are dropped")
+         ("event-subscription-max-per-connection", boost::program_options::value< uint32_t >()->default_value( 16 ),
+           "Event subscriptions a connection may have at a time")
+         ("event-subscription-max-filter-entries", boost::program_options::value< uint32_t >()->default_value( 1000 ),
+           "Entries each list of an event subscription filter may have")
+         ;
+   cfg.add( cli );
+}
+
+void event_subscription_plugin::plugin_initialize( const boost::program_options::variables_map& options )
+{
+   try
+   {
+      ilog( "Initializing event subscription plugin" );
+      chain::database& db = database();
+
+      _my->_thread = &fc::thread::current();
+      _my->_max_queued_blocks = std::max( 1u, options.at( "event-subscription-max-queued-blocks" ).as< uint32_t >() );
+      _my->_max_per_connection = options.at( "event-subscription-max-per-connection" ).as< uint32_t >();
+      _my->_max_filter_entries = options.at( "event-subscription-max-filter-entries" ).as< uint32_t >();
+
+      operation op;
+      for( int64_t i = 0; i < operation::count(); ++i )
+      {
+         op.set_which( i );
+         _my->_operation_types[ op.visit( detail::operation_name_visitor() ) ] = i;
+      }
+
+      db.pre_apply_block.connect( [&]( const signed_block& b ){ _my->on_pre_apply_block( b ); } );
+      db.post_apply_operation.connect( [&]( const detail::operation_notification& note ){ _my->on_operation( note ); } );
+      db.applied_block.connect( [&]( const signed_block& b ){ _my->on_applied_block( b ); } );
+   } FC_CAPTURE_AND_RETHROW()
+}
+
+void event_subscription_plugin::plugin_startup()
+{
+   app().register_api_factory< event_subscription_api >( "event_subscription_api" );
+}
+
+uint32_t event_subscription_plugin::subscribe( const void* owner, std::function< void( const fc::variant& ) > cb, const event_filter& filter )
+{
+   return _my->on_chain_thread( [&]() { return _my->subscribe( owner, cb, filter ); } );
+}
+
+void event_subscription_plugin::unsubscribe( const void* owner, uint32_t subscription_id )
+{
+   _my->on_chain_thread( [&]()
+   {
+      auto itr = _my->_subscribers.find( subscription_id );
+      FC_ASSERT( itr != _my->_subscribers.end() && itr->second->owner == owner,
+         "No subscription ${id} on this connection", ("id", subscription_id) );
+      _my->remove( subscription_id );
+   });
+}
+
+void event_subscription_plugin::unsubscribe_owner( const void* owner )
+{
+   auto remove_owned = [this,owner]()
+   {
+      vector< uint32_t > owned;
+      for( const auto& item : _my->_subscribers )
+         if( item.second->owner == owner )
+            owned.push_back( item.first );
+      for( uint32_t id : owned )
+         _my->remove( id );
+   };
+
+   // called as connections close, which need not wait for it
+   if( _my->_thread == nullptr || &fc::thread::current() == _my->_thread )
+      remove_owned();
+   else
+      _my->_thread->async( remove_owned, "event subscription" );
+}
+
+vector< subscription_info > event_subscription_plugin::get_subscriptions( const void* owner )const
+{
+   return _my->on_chain_thread( [&]()
+   {
+      vector< subscription_info > result;
+      for( const auto& item : _my->_subscribers )
+      {
+         const auto& s = item.second;
+         if( s->owner != owner )
+            continue;
+         subscription_info info;
+         info.id = s->id;
+         info.filter = s->filter;
+         info.queued_blocks = uint32_t( s->queue.size() );
+         info.delivered_blocks = s->delivered_blocks;
+         info.missed_blocks = s->missed_blocks;
+         result.push_back( info );
+      }
+      return result;
+   });
+}
+
+} } // sigmaengine::event_subscription
+
+SIGMAENGINE_DEFINE_PLUGIN( event_subscription, sigmaengine::event_subscription::event_subscription_plugin )
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sigmaengine/app/application.hpp>
+
+#include <sigmaengine/event_subscription/event_subscription_plugin.hpp>
+
+#include <fc/api.hpp>
+
+namespace sigmaengine { namespace event_subscription {
+
+   namespace detail
+   {
+      class event_subscription_api_impl;
+   }
+
+   /**
+    *  Streams the operations of applied blocks to the connection, filtered on the node.
+    *  Subscriptions end with the connection, so they are refused over plain HTTP.
+    */
+   class event_subscription_api
+   {
+      public:
+         event_subscription_api( const app::api_context& ctx );
+         ~event_subscription_api();
+
+         void on_api_startup();
+
+         /**
+          *  cb is called with a block_event for every applied block that has operations matching
+          *  filter.  Blocks are queued while the connection is slow to take them; when the queue is
+          *  full the oldest block is dropped and counted in the next event's missed_blocks, so the
+          *  client can catch up with get_ops_in_block.  A block that is applied again after a fork
+          *  switch is sent again, with its new block_id.
+          *
+          *  @return the id to unsubscribe with
+          */
+         uint32_t subscribe( std::function< void( const fc::variant& ) > cb, event_filter filter );
+         void unsubscribe( uint32_t subscription_id );
+         vector< subscription_info > get_subscriptions()const;
+
+      private:
+         std::shared_ptr< detail::event_subscription_api_impl > _my;
+   };
+
+} } // sigmaengine::event_subscription
+
+FC_API( sigmaengine::event_subscription::event_subscription_api,
+   (subscribe)
+   (unsubscribe)
+   (get_subscriptions)
+)
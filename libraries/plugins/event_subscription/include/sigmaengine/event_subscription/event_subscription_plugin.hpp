@@ -0,0 +1,106 @@
+#pragma once
+
+#include <sigmaengine/app/plugin.hpp>
+#include <sigmaengine/app/applied_operation.hpp>
+#include <sigmaengine/chain/database.hpp>
+
+#include <fc/container/flat.hpp>
+
+#include <functional>
+
+#define EVENT_SUBSCRIPTION_PLUGIN_NAME "event_subscription"
+
+namespace sigmaengine { namespace event_subscription {
+   using sigmaengine::app::application;
+   using sigmaengine::app::applied_operation;
+   using namespace sigmaengine::protocol;
+
+   namespace detail { class event_subscription_plugin_impl; }
+
+   /**
+    *  Selects the operations a subscription is sent.  An operation is sent when it matches
+    *  every list that is not empty, and any entry within a list.  With all lists empty every
+    *  operation is sent.
+    */
+   struct event_filter
+   {
+      flat_set< account_name_type >  accounts;            ///< accounts impacted by the operation
+      flat_set< string >             operations;          ///< operation type names, e.g. transfer_operation
+      flat_set< string >             tokens;              ///< token names or symbols, including token operations inside custom operations
+      flat_set< dapp_name_type >     dapps;               ///< dapps impacted by the operation
+      bool                           virtual_ops = true;
+      bool                           empty_blocks = false;  ///< also send blocks without matching operations
+      uint32_t                       max_queued_blocks = 0; ///< 0 uses the node's event-subscription-max-queued-blocks
+   };
+
+   /** What a subscription is sent for each applied block */
+   struct block_event
+   {
+      uint32_t                       block_num = 0;
+      block_id_type                  block_id;
+      fc::time_point_sec             timestamp;
+      uint32_t                       missed_blocks = 0;   ///< blocks dropped before this one because the subscriber fell behind
+      vector< applied_operation >    operations;
+   };
+
+   struct subscription_info
+   {
+      uint32_t                       id = 0;
+      event_filter                   filter;
+      uint32_t                       queued_blocks = 0;
+      uint64_t                       delivered_blocks = 0;
+      uint64_t                       missed_blocks = 0;
+   };
+
+   class event_subscription_plugin : public sigmaengine::app::plugin
+   {
+      public:
+         event_subscription_plugin( application* app );
+         virtual ~event_subscription_plugin();
+
+         std::string plugin_name()const override { return EVENT_SUBSCRIPTION_PLUGIN_NAME; }
+         virtual void plugin_set_program_options(
+            boost::program_options::options_description& cli,
+            boost::program_options::options_description& cfg ) override;
+         virtual void plugin_initialize( const boost::program_options::variables_map& options ) override;
+         virtual void plugin_startup() override;
+
+         /** owner is usually the API object of a connection, which may hold a limited number of subscriptions */
+         uint32_t subscribe( const void* owner, std::function< void( const fc::variant& ) > cb, const event_filter& filter );
+         void unsubscribe( const void* owner, uint32_t subscription_id );
+         void unsubscribe_owner( const void* owner );
+         vector< subscription_info > get_subscriptions( const void* owner )const;
+
+         friend class detail::event_subscription_plugin_impl;
+
+      private:
+         std::unique_ptr< detail::event_subscription_plugin_impl > _my;
+   };
+
+} } //namespace sigmaengine::event_subscription
+
+FC_REFLECT( sigmaengine::event_subscription::event_filter,
+   (accounts)
+   (operations)
+   (tokens)
+   (dapps)
+   (virtual_ops)
+   (empty_blocks)
+   (max_queued_blocks)
+   )
+
+FC_REFLECT( sigmaengine::event_subscription::block_event,
+   (block_num)
+   (block_id)
+   (timestamp)
+   (missed_blocks)
+   (operations)
+   )
+
+FC_REFLECT( sigmaengine::event_subscription::subscription_info,
+   (id)
+   (filter)
+   (queued_blocks)
+   (delivered_blocks)
+   (missed_blocks)
+   )
@@ -28,6 +28,20 @@ struct get_raw_block_result
    std::string                   raw_block;
 };
 
+struct get_raw_block_range_args
+{
+   uint32_t start_block_num = 0;
+   uint32_t count = 0;
+};
+
+struct get_raw_block_range_result
+{
+   /// Number of blocks in raw_blocks, fewer than requested past the head block
+   uint32_t                      count = 0;
+   /// base64 of the blocks packed one after another, starting at start_block_num
+   std::string                   raw_blocks;
+};
+
 class raw_block_api
 {
    public:
@@ -36,6 +50,8 @@ class raw_block_api
       void on_api_startup();
 
       get_raw_block_result get_raw_block( get_raw_block_args args );
+      /// Up to 1000 consecutive blocks in one reply, for nodes catching up from a trusted node
+      get_raw_block_range_result get_raw_block_range( get_raw_block_range_args args );
       void push_raw_block( std::string block_b64 );
 
    private:
@@ -55,7 +71,18 @@ FC_REFLECT( sigmaengine::plugin::raw_block::get_raw_block_result,
    (raw_block)
    )
 
+FC_REFLECT( sigmaengine::plugin::raw_block::get_raw_block_range_args,
+   (start_block_num)
+   (count)
+   )
+
+FC_REFLECT( sigmaengine::plugin::raw_block::get_raw_block_range_result,
+   (count)
+   (raw_blocks)
+   )
+
 FC_API( sigmaengine::plugin::raw_block::raw_block_api,
    (get_raw_block)
+   (get_raw_block_range)
    (push_raw_block)
    )
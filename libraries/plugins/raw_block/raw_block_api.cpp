@@ -39,17 +39,42 @@ get_raw_block_result raw_block_api::get_raw_block( get_raw_block_args args )
    get_raw_block_result result;
    std::shared_ptr< sigmaengine::chain::database > db = my->app.chain_database();
 
-   fc::optional<chain::signed_block> block = db->fetch_block_by_number( args.block_num );
-   if( !block.valid() )
+   std::vector<char> serialized_block;
+   // recent blocks come from the fork database, which the main thread changes under the write lock
+   uint32_t found = db->with_read_lock( [&]()
+   {
+      return db->fetch_block_data_by_number( args.block_num, 1, serialized_block );
+   });
+   if( found == 0 )
    {
       return result;
    }
-   std::vector<char> serialized_block = fc::raw::pack( *block );
-   result.raw_block = fc::base64_encode( std::string(
-      &serialized_block[0], &serialized_block[0] + serialized_block.size()) );
-   result.block_id = block->id();
-   result.previous = block->previous;
-   result.timestamp = block->timestamp;
+   // A packed block starts with its packed header
+   chain::signed_block_header header;
+   fc::datastream<const char*> ds( serialized_block.data(), serialized_block.size() );
+   fc::raw::unpack( ds, header );
+
+   result.raw_block = fc::base64_encode( serialized_block.data(), serialized_block.size() );
+   result.block_id = header.id();
+   result.previous = header.previous;
+   result.timestamp = header.timestamp;
+   return result;
+}
+
+get_raw_block_range_result raw_block_api::get_raw_block_range( get_raw_block_range_args args )
+{
+   FC_ASSERT( args.count <= 1000, "count must be at most 1000" );
+
+   get_raw_block_range_result result;
+   std::shared_ptr< sigmaengine::chain::database > db = my->app.chain_database();
+
+   std::vector<char> serialized_blocks;
+   result.count = db->with_read_lock( [&]()
+   {
+      return db->fetch_block_data_by_number( args.start_block_num, args.count, serialized_blocks );
+   });
+   if( serialized_blocks.size() )
+      result.raw_blocks = fc::base64_encode( serialized_blocks.data(), serialized_blocks.size() );
    return result;
 }
 
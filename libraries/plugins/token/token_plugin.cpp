@@ -25,9 +25,8 @@ namespace sigmaengine { namespace token {
                return _self.database();
             }
 
-            void on_apply_block( const signed_block& b );
-            void process_token_fund_withdraw();
-            void process_token_savings_withdraws();
+            uint32_t process_token_fund_withdraw();
+            uint32_t process_token_savings_withdraws();
 
          private:
             token_plugin&  _self;
@@ -50,16 +49,34 @@ namespace sigmaengine { namespace token {
          _custom_operation_interpreter->register_evaluator< conclude_transfer_token_savings_evaluator >( &_self );
 
          database().set_custom_operation_interpreter( _self.plugin_name(), _custom_operation_interpreter );
+
+         database().register_due_processor( "token_fund_withdraws",
+            [this]() -> fc::optional< time_point_sec > {
+               const auto& idx = database().get_index< token_fund_withdraw_index >().indices().get< by_complete >();
+               if( idx.empty() ) return fc::optional< time_point_sec >();
+               return idx.begin()->complete;
+            },
+            [this]( time_point_sec ) { return process_token_fund_withdraw(); } );
+
+         database().register_due_processor( "token_savings_withdraws",
+            [this]() -> fc::optional< time_point_sec > {
+               const auto& idx = database().get_index< token_savings_withdraw_index >().indices().get< by_savings_next_date >();
+               if( idx.empty() ) return fc::optional< time_point_sec >();
+               return idx.begin()->next_date;
+            },
+            [this]( time_point_sec ) { return process_token_savings_withdraws(); } );
       }
 
-      void token_plugin_impl::process_token_fund_withdraw() {
+      uint32_t token_plugin_impl::process_token_fund_withdraw() {
          auto& _db = database();
+         uint32_t processed = 0;
          
          const auto& idx = _db.get_index< token_fund_withdraw_index >().indices().get< by_complete >();
          auto itr = idx.begin();
          while( itr != idx.end() ) {
             if( itr->complete > _db.head_block_time() )
                break;
+            ++processed;
 
             dlog( "process_token_fund_withdraw : from = ${f}, token = ${t}, amount = ${a}, complete = ${c}"
                , ("f", itr->from)("t", itr->token)("a", itr->amount)("c", itr->complete) );
@@ -74,10 +91,12 @@ namespace sigmaengine { namespace token {
             _db.remove( *itr );
             itr = idx.begin();
          }
+         return processed;
       }
 
-      void token_plugin_impl::process_token_savings_withdraws() {
+      uint32_t token_plugin_impl::process_token_savings_withdraws() {
          auto& _db = database();
+         uint32_t processed = 0;
 
          const auto& withdraw_idx = _db.get_index< token_savings_withdraw_index >().indices().get< by_savings_next_date >();
          auto withdraw_itr = withdraw_idx.begin();
@@ -88,6 +107,7 @@ namespace sigmaengine { namespace token {
          while( withdraw_itr != withdraw_idx.end() ) {
             if( withdraw_itr->next_date > now )
                break;
+            ++processed;
             
             if ( withdraw_itr->split_pay_order == withdraw_itr->split_pay_month ) { // last month
                utils.adjust_token_savings_balance( withdraw_itr->to, withdraw_itr->token, -( withdraw_itr->amount ) );
@@ -118,11 +138,7 @@ namespace sigmaengine { namespace token {
                withdraw_itr++;
             }
          }
-      }
-
-      void token_plugin_impl::on_apply_block( const signed_block& b ){
-         process_token_fund_withdraw();
-         process_token_savings_withdraws();
+         return processed;
       }
 
    } //namespace detail
@@ -146,10 +162,6 @@ namespace sigmaengine { namespace token {
          add_plugin_index< token_fund_withdraw_index >( db );
          add_plugin_index< token_savings_withdraw_index >( db );
 
-         db.applied_block.connect( [&]( const signed_block& b ){ 
-            _my->on_apply_block( b ); 
-         });
-
       } FC_CAPTURE_AND_RETHROW()
    }
 
@@ -7,6 +7,9 @@
 #define SIGMAENGINE_BLOCKCHAIN_VERSION                              ( version(0, 1, 0) )
 #define SIGMAENGINE_BLOCKCHAIN_HARDFORK_VERSION                     ( hardfork_version( SIGMAENGINE_BLOCKCHAIN_VERSION ) )
 
+/// Bump whenever an object or index kept in shared memory changes, including plugin ones, so nodes reindex
+#define SIGMAENGINE_SHARED_MEMORY_LAYOUT_VERSION                    1
+
 #define SIGMAENGINE_BLOCKCHAIN_PRECISION_DIGITS                     6
 
 #define SIGMAENGINE_INIT_PUBLIC_KEY_STR                             "PHK6tAnSH52vnszMcbnT1YK6D3qPa1dMcLtvxznjJUUyGkRYgiftZ" // 5HsG6FJRQC7jGL99nwzAqS1Q1t9cuJGMvzhL9P8SQubG17bXgt9
@@ -37,6 +40,7 @@
 #define SIGMAENGINE_HARDFORK_REQUIRED_BOBSERVERS                    17
 
 #define SIGMAENGINE_MAX_TIME_UNTIL_EXPIRATION                       (60*60) // seconds,  aka: 1 hour
+#define SIGMAENGINE_TRANSACTION_PRUNE_INTERVAL                      (60) // seconds, expired transactions leave the duplicate check in batches on this boundary
 #define SIGMAENGINE_MAX_MEMO_SIZE                                   2048
 
 #define SIGMAENGINE_100_PERCENT                                     10000
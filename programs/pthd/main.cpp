@@ -254,7 +254,13 @@ void write_default_logging_config_to_stream(std::ostream& out)
           "[log.file_appender.p2p]\n"
           "filename=logs/p2p/p2p.log\n"
           "# filename can be absolute or relative to this config file\n"
-          "limit_days=7\n\n"
+          "limit_days=7\n"
+          "# write on a background thread; when it falls behind, messages are dropped and counted\n"
+          "async=true\n\n"
+          "# declare an appender named \"rpc\" for the RPC requests sampled by rpc-log-sample-rate\n"
+          "#[log.file_appender.rpc]\n"
+          "#filename=logs/rpc/rpc.log\n"
+          "#limit_days=7\n\n"
           "# route any messages logged to the default logger to the \"stderr\" logger we\n"
           "# declared above, if they are info level are higher\n"
           "[logger.default]\n"
@@ -263,7 +269,11 @@ void write_default_logging_config_to_stream(std::ostream& out)
           "# route messages sent to the \"p2p\" logger to the p2p appender declared above\n"
           "[logger.p2p]\n"
           "level=warn\n"
-          "appenders=p2p\n\n";
+          "appenders=p2p\n\n"
+          "# route sampled RPC requests to the rpc appender, they are logged at info level\n"
+          "#[logger.rpc]\n"
+          "#level=info\n"
+          "#appenders=rpc\n\n";
 }
 
 fc::optional<fc::logging_config> load_logging_config_from_ini_file(const fc::path& config_ini_filename)
@@ -302,6 +312,7 @@ fc::optional<fc::logging_config> load_logging_config_from_ini_file(const fc::pat
                fc::console_appender::level_color(fc::log_level::error,
                                                  fc::console_appender::color::cyan));
             console_appender_config.stream = fc::variant(stream_name).as<fc::console_appender::stream::type>();
+            console_appender_config.async = section_tree.get<bool>("async", false);
             logging_config.appenders.push_back(fc::appender_config(console_appender_name, "console", fc::variant(console_appender_config)));
             found_logging_config = true;
          }
@@ -323,6 +334,7 @@ fc::optional<fc::logging_config> load_logging_config_from_ini_file(const fc::pat
             file_appender_config.rotate = true;
             file_appender_config.rotation_interval = fc::hours(1);
             file_appender_config.rotation_limit = fc::days( limit_days ); 
+            file_appender_config.async = section_tree.get<bool>("async", false);
             logging_config.appenders.push_back(fc::appender_config(file_appender_name, "file", fc::variant(file_appender_config)));
             found_logging_config = true;
          }
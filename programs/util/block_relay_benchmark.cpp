@@ -0,0 +1,267 @@
+/**
+ * Simulates how long a block takes to reach every node of a p2p network when it is
+ * relayed as a full block_message and as a compact_block_message.
+ *
+ * Nodes are joined to random peers over links with a fixed latency and bandwidth.  A
+ * node relays the block once it has validated it: it advertises the block, the peer
+ * asks for it, and it sends the block.  With compact blocks the peer then asks for the
+ * transactions it has not seen, which every node has independently with probability
+ * --mempool-coverage.  Message sizes are those of the real p2p messages for a block of
+ * --transactions transactions of about --transaction-size bytes.  Links do not share
+ * bandwidth, so the times are a lower bound for a busy node.  e.g.
+ *
+ *   block_relay_benchmark --nodes 500 --transactions 5000 --mempool-coverage 0.98
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
+
+namespace bpo = boost::program_options;
+using namespace graphene::net;
+
+struct relay_mode_result
+{
+   uint64_t             block_bytes = 0;        // bytes of the block message sent over each hop
+   double               avg_hop_bytes = 0;      // including transactions fetched after a compact block
+   double               avg_missing_transactions = 0;
+   double               median_ms = 0;
+   double               p95_ms = 0;
+   double               max_ms = 0;
+};
+
+struct block_relay_benchmark_result
+{
+   uint32_t             nodes = 0;
+   uint32_t             peers_per_node = 0;
+   uint32_t             transactions = 0;
+   double               mempool_coverage = 0;
+   relay_mode_result    full;
+   relay_mode_result    compact;
+};
+
+FC_REFLECT( relay_mode_result,
+            (block_bytes)(avg_hop_bytes)(avg_missing_transactions)(median_ms)(p95_ms)(max_ms) )
+FC_REFLECT( block_relay_benchmark_result,
+            (nodes)(peers_per_node)(transactions)(mempool_coverage)(full)(compact) )
+
+namespace {
+
+   struct peer_link
+   {
+      uint32_t    peer;
+      double      latency_ms;
+   };
+
+   /// Bytes on the wire, with the message header
+   uint64_t wire_size( const message& m )
+   {
+      return sizeof( message_header ) + m.size;
+   }
+
+   signed_block make_block( uint32_t transactions, uint32_t transaction_size, std::mt19937_64& rng )
+   {
+      signed_block block;
+      block.timestamp = fc::time_point_sec( fc::time_point::now() );
+      block.bobserver = "benchmark";
+      for( uint32_t i = 0; i < transactions; ++i )
+      {
+         signed_transaction trx;
+         trx.ref_block_num = uint16_t( rng() );
+         trx.ref_block_prefix = uint32_t( rng() );
+         trx.expiration = block.timestamp + 60;
+         // signatures stand in for operations: random bytes of roughly the right size
+         while( fc::raw::pack_size( trx ) < transaction_size )
+         {
+            sigmaengine::protocol::signature_type sig;
+            for( size_t b = 0; b < sig.size(); ++b )
+               sig.data[b] = (unsigned char)rng();
+            trx.signatures.push_back( sig );
+         }
+         block.transactions.push_back( std::move( trx ) );
+      }
+      block.transaction_merkle_root = block.calculate_merkle_root();
+      return block;
+   }
+
+   /// What it costs a node to get the block from a peer
+   struct hop
+   {
+      uint32_t    one_way_trips = 0;
+      double      transfer_ms = 0;
+   };
+
+   /** Arrival time of the block at every node when node 0 produces it at time 0 */
+   std::vector< double > propagate( const std::vector< std::vector< peer_link > >& graph,
+                                    const std::vector< hop >& hops, double validation_ms )
+   {
+      std::vector< double > arrival( graph.size(), std::numeric_limits< double >::infinity() );
+      typedef std::pair< double, uint32_t > event;
+      std::priority_queue< event, std::vector< event >, std::greater< event > > events;
+      arrival[0] = 0;
+      events.push( event( 0, 0 ) );
+      while( !events.empty() )
+      {
+         event e = events.top();
+         events.pop();
+         if( e.first > arrival[ e.second ] )
+            continue;
+         double relay_time = e.second == 0 ? e.first : e.first + validation_ms;
+         for( const peer_link& l : graph[ e.second ] )
+         {
+            const hop& h = hops[ l.peer ];
+            double t = relay_time + h.one_way_trips * l.latency_ms + h.transfer_ms;
+            if( t < arrival[ l.peer ] )
+            {
+               arrival[ l.peer ] = t;
+               events.push( event( t, l.peer ) );
+            }
+         }
+      }
+      return arrival;
+   }
+
+   void summarize( std::vector< double > arrival, relay_mode_result& result )
+   {
+      std::sort( arrival.begin(), arrival.end() );
+      result.median_ms = arrival[ arrival.size() / 2 ];
+      result.p95_ms = arrival[ arrival.size() * 95 / 100 ];
+      result.max_ms = arrival.back();
+   }
+
+}
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "block_relay_benchmark options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("nodes", bpo::value< uint32_t >()->default_value( 200 ), "Number of nodes")
+         ("peers-per-node", bpo::value< uint32_t >()->default_value( 8 ), "Random outbound connections of each node")
+         ("latency-ms", bpo::value< double >()->default_value( 50 ), "Mean one way latency of a link; each link gets 50% to 150% of it")
+         ("bandwidth-mbit", bpo::value< double >()->default_value( 20 ), "Bandwidth of a link in Mbit/s")
+         ("validation-ms", bpo::value< double >()->default_value( 20 ), "Time a node takes to validate the block before relaying it")
+         ("transactions", bpo::value< uint32_t >()->default_value( 2000 ), "Transactions in the block")
+         ("transaction-size", bpo::value< uint32_t >()->default_value( 250 ), "Approximate packed size of a transaction in bytes")
+         ("mempool-coverage", bpo::value< double >()->default_value( 0.95 ), "Probability that a node has already received a given transaction")
+         ("seed", bpo::value< uint64_t >()->default_value( 1 ), "Random seed")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      block_relay_benchmark_result result;
+      result.nodes = options.at( "nodes" ).as< uint32_t >();
+      result.peers_per_node = options.at( "peers-per-node" ).as< uint32_t >();
+      result.transactions = options.at( "transactions" ).as< uint32_t >();
+      result.mempool_coverage = options.at( "mempool-coverage" ).as< double >();
+      double latency_ms = options.at( "latency-ms" ).as< double >();
+      double bytes_per_ms = options.at( "bandwidth-mbit" ).as< double >() * 1000000 / 8 / 1000;
+      double validation_ms = options.at( "validation-ms" ).as< double >();
+      FC_ASSERT( result.nodes > result.peers_per_node, "nodes must be more than peers-per-node" );
+
+      std::mt19937_64 rng( options.at( "seed" ).as< uint64_t >() );
+
+      std::vector< std::vector< peer_link > > graph( result.nodes );
+      std::uniform_int_distribution< uint32_t > pick_node( 0, result.nodes - 1 );
+      std::uniform_real_distribution< double > jitter( 0.5, 1.5 );
+      for( uint32_t n = 0; n < result.nodes; ++n )
+      {
+         std::set< uint32_t > peers;
+         while( peers.size() < result.peers_per_node )
+         {
+            uint32_t peer = pick_node( rng );
+            if( peer != n )
+               peers.insert( peer );
+         }
+         for( uint32_t peer : peers )
+         {
+            double l = latency_ms * jitter( rng );
+            graph[ n ].push_back( peer_link{ peer, l } );
+            graph[ peer ].push_back( peer_link{ n, l } );
+         }
+      }
+
+      signed_block block = make_block( result.transactions, options.at( "transaction-size" ).as< uint32_t >(), rng );
+      block_id_type block_id = block.id();
+      message full_message{ block_message( block ) };
+      message compact_message{ compact_block_message( block ) };
+
+      result.full.block_bytes = wire_size( full_message );
+      result.compact.block_bytes = wire_size( compact_message );
+
+      // advertise, fetch and the block; a compact block may add a request and its reply
+      std::vector< hop > full_hops( result.nodes );
+      std::vector< hop > compact_hops( result.nodes );
+      std::bernoulli_distribution has_transaction( result.mempool_coverage );
+      uint64_t missing_total = 0;
+      uint64_t compact_bytes_total = 0;
+      for( uint32_t n = 0; n < result.nodes; ++n )
+      {
+         full_hops[ n ].one_way_trips = 3;
+         full_hops[ n ].transfer_ms = result.full.block_bytes / bytes_per_ms;
+
+         get_block_transactions_message request( block_id, std::vector< uint32_t >() );
+         block_transactions_message reply( block_id );
+         for( uint32_t i = 0; i < block.transactions.size(); ++i )
+            if( !has_transaction( rng ) )
+            {
+               request.indexes.push_back( i );
+               reply.transactions.push_back( block.transactions[i] );
+            }
+
+         uint64_t bytes = result.compact.block_bytes;
+         compact_hops[ n ].one_way_trips = 3;
+         compact_hops[ n ].transfer_ms = result.compact.block_bytes / bytes_per_ms;
+         if( !request.indexes.empty() )
+         {
+            uint64_t reply_bytes = wire_size( message( reply ) );
+            bytes += wire_size( message( request ) ) + reply_bytes;
+            compact_hops[ n ].one_way_trips += 2;
+            compact_hops[ n ].transfer_ms += reply_bytes / bytes_per_ms;
+         }
+         missing_total += request.indexes.size();
+         compact_bytes_total += bytes;
+      }
+
+      result.full.avg_hop_bytes = result.full.block_bytes;
+      result.compact.avg_hop_bytes = double( compact_bytes_total ) / result.nodes;
+      result.compact.avg_missing_transactions = double( missing_total ) / result.nodes;
+      summarize( propagate( graph, full_hops, validation_ms ), result.full );
+      summarize( propagate( graph, compact_hops, validation_ms ), result.compact );
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}
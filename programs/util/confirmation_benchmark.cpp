@@ -0,0 +1,180 @@
+/**
+ * Load test for the transaction confirmation callbacks behind
+ * network_broadcast_api::broadcast_transaction_synchronous.
+ *
+ * --waiters calls, spread over --connections connections, each register a callback
+ * and block their task on a promise the way broadcast_transaction_synchronous does.
+ * Blocks of --block-transactions transactions, a --confirmed-fraction of them being
+ * waited on, are then applied until every waiter has returned.  The time taken to
+ * match a block against the callbacks is also measured for the per-connection maps
+ * used before, where every connection hashed every transaction of every block.  e.g.
+ *
+ *   confirmation_benchmark --waiters 50000 --connections 500 --block-transactions 2000
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <sigmaengine/app/transaction_confirmations.hpp>
+
+namespace bpo = boost::program_options;
+using sigmaengine::app::transaction_confirmations;
+using sigmaengine::protocol::signed_block;
+using sigmaengine::protocol::signed_transaction;
+using sigmaengine::protocol::transaction_id_type;
+
+struct confirmation_benchmark_result
+{
+   uint32_t             waiters = 0;
+   uint32_t             connections = 0;
+   uint32_t             block_transactions = 0;
+   uint32_t             blocks = 0;
+   uint32_t             max_concurrent_waiters = 0;
+   double               register_ms = 0;
+   double               until_all_confirmed_ms = 0;
+   double               avg_block_match_us = 0;
+   double               avg_legacy_block_match_us = 0;
+};
+
+FC_REFLECT( confirmation_benchmark_result,
+            (waiters)(connections)(block_transactions)(blocks)(max_concurrent_waiters)
+            (register_ms)(until_all_confirmed_ms)(avg_block_match_us)(avg_legacy_block_match_us) )
+
+namespace {
+
+   signed_transaction make_transaction( uint32_t n, fc::time_point_sec expiration )
+   {
+      signed_transaction trx;
+      trx.ref_block_num = uint16_t( n );
+      trx.ref_block_prefix = n;
+      trx.expiration = expiration;
+      return trx;
+   }
+
+}
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "confirmation_benchmark options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("waiters", bpo::value< uint32_t >()->default_value( 20000 ), "Concurrent synchronous broadcasts")
+         ("connections", bpo::value< uint32_t >()->default_value( 200 ), "Connections the broadcasts are spread over")
+         ("block-transactions", bpo::value< uint32_t >()->default_value( 1000 ), "Transactions in each block")
+         ("confirmed-fraction", bpo::value< double >()->default_value( 0.5 ), "Fraction of a block's transactions that someone waits on")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      confirmation_benchmark_result result;
+      result.waiters = options.at( "waiters" ).as< uint32_t >();
+      result.connections = options.at( "connections" ).as< uint32_t >();
+      result.block_transactions = options.at( "block-transactions" ).as< uint32_t >();
+      double confirmed_fraction = options.at( "confirmed-fraction" ).as< double >();
+      FC_ASSERT( result.connections > 0 && result.block_transactions > 0 );
+      FC_ASSERT( confirmed_fraction > 0 && confirmed_fraction <= 1 );
+
+      fc::time_point_sec expiration = fc::time_point_sec( fc::time_point::now() ) + 3600;
+      std::vector< signed_transaction > transactions;
+      for( uint32_t i = 0; i < result.waiters; ++i )
+         transactions.push_back( make_transaction( i, expiration ) );
+
+      uint32_t per_connection = ( result.waiters + result.connections - 1 ) / result.connections;
+      transaction_confirmations confirmations( per_connection, result.waiters );
+      std::vector< char > connections( result.connections );
+
+      // what every connection's network_broadcast_api kept before
+      std::vector< std::map< transaction_id_type, int > > legacy_callbacks( result.connections );
+
+      uint32_t waiting = 0;
+      std::vector< fc::future< void > > waiters;
+      fc::time_point start = fc::time_point::now();
+      for( uint32_t i = 0; i < result.waiters; ++i )
+      {
+         const void* owner = &connections[ i % result.connections ];
+         transaction_id_type id = transactions[i].id();
+         legacy_callbacks[ i % result.connections ][ id ] = 0;
+         waiters.push_back( fc::async( [&confirmations, &waiting, &result, owner, id]()
+         {
+            fc::promise< bool >::ptr prom( new fc::promise< bool >() );
+            confirmations.add( owner, id, fc::time_point_sec::maximum(), [prom]( int32_t, int32_t, bool expired ) {
+               prom->set_value( expired );
+            } );
+            result.max_concurrent_waiters = std::max( result.max_concurrent_waiters, ++waiting );
+            fc::future< bool >( prom ).wait();
+            --waiting;
+         }, "confirmation waiter" ) );
+      }
+      // let every waiter register and block
+      while( confirmations.size() < result.waiters )
+         fc::yield();
+      result.register_ms = double( ( fc::time_point::now() - start ).count() ) / 1000;
+
+      uint32_t confirmed_per_block = std::max< uint32_t >( 1, uint32_t( result.block_transactions * confirmed_fraction ) );
+      uint64_t match_us = 0;
+      uint64_t legacy_match_us = 0;
+      uint32_t filler = result.waiters;
+      for( uint32_t next = 0; next < result.waiters; )
+      {
+         signed_block block;
+         block.timestamp = fc::time_point_sec( fc::time_point::now() );
+         for( uint32_t i = 0; i < result.block_transactions; ++i )
+         {
+            if( i < confirmed_per_block && next < result.waiters )
+               block.transactions.push_back( transactions[ next++ ] );
+            else
+               block.transactions.push_back( make_transaction( filler++, expiration ) );
+         }
+
+         fc::time_point legacy_start = fc::time_point::now();
+         for( auto& callbacks : legacy_callbacks )
+            for( const signed_transaction& trx : block.transactions )
+               callbacks.erase( trx.id() );
+         legacy_match_us += ( fc::time_point::now() - legacy_start ).count();
+
+         fc::time_point match_start = fc::time_point::now();
+         confirmations.on_applied_block( block );
+         match_us += ( fc::time_point::now() - match_start ).count();
+         ++result.blocks;
+         fc::yield();
+      }
+
+      for( auto& waiter : waiters )
+         waiter.wait();
+      result.until_all_confirmed_ms = double( ( fc::time_point::now() - start ).count() ) / 1000;
+      result.avg_block_match_us = double( match_us ) / result.blocks;
+      result.avg_legacy_block_match_us = double( legacy_match_us ) / result.blocks;
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * Measures fc::json parse and serialize throughput on a captured API response.
+ *
+ * Save a large response from a node, e.g. get_block_range or get_account_history,
+ * and run the benchmark on it before and after a change to fc::json:
+ *
+ *   curl -s -d '{"id":1,"method":"call","params":["database_api","get_block_range",[1,1000]]}' http://127.0.0.1:8090 > blocks.json
+ *   json_benchmark --file blocks.json
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/sstream.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/time.hpp>
+
+namespace bpo = boost::program_options;
+
+struct json_benchmark_result
+{
+   uint64_t             bytes = 0;
+   uint32_t             iterations = 0;
+
+   double               parse_seconds = 0;
+   double               parse_mb_per_second = 0;
+   double               to_string_seconds = 0;
+   double               to_string_mb_per_second = 0;
+   /// The ostream writer, for comparison with to_string
+   double               to_stream_seconds = 0;
+   double               to_stream_mb_per_second = 0;
+};
+
+FC_REFLECT( json_benchmark_result,
+            (bytes)(iterations)
+            (parse_seconds)(parse_mb_per_second)
+            (to_string_seconds)(to_string_mb_per_second)
+            (to_stream_seconds)(to_stream_mb_per_second) )
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "json_benchmark options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("file", bpo::value< std::string >()->required(), "JSON document to parse and serialize")
+         ("iterations", bpo::value< uint32_t >()->default_value( 100 ), "Times each step is repeated")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      std::string text;
+      fc::read_file_contents( fc::path( options.at( "file" ).as< std::string >() ), text );
+
+      json_benchmark_result result;
+      result.bytes = text.size();
+      result.iterations = std::max< uint32_t >( options.at( "iterations" ).as< uint32_t >(), 1 );
+
+      auto seconds = []( const fc::time_point& start )
+      {
+         return double( ( fc::time_point::now() - start ).count() ) / 1000000.0;
+      };
+      const double total_mb = double( result.bytes ) * result.iterations / ( 1024 * 1024 );
+
+      fc::variant doc;
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < result.iterations; ++i )
+         doc = fc::json::from_string( text );
+      result.parse_seconds = seconds( start );
+
+      uint64_t written = 0;
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < result.iterations; ++i )
+         written += fc::json::to_string( doc ).size();
+      result.to_string_seconds = seconds( start );
+
+      start = fc::time_point::now();
+      for( uint32_t i = 0; i < result.iterations; ++i )
+      {
+         fc::stringstream ss;
+         fc::json::to_stream( ss, doc );
+         written -= ss.str().size();
+      }
+      result.to_stream_seconds = seconds( start );
+      FC_ASSERT( written == 0, "to_string and to_stream disagree on the output" );
+
+      result.parse_mb_per_second = result.parse_seconds > 0 ? total_mb / result.parse_seconds : 0;
+      result.to_string_mb_per_second = result.to_string_seconds > 0 ? total_mb / result.to_string_seconds : 0;
+      result.to_stream_mb_per_second = result.to_stream_seconds > 0 ? total_mb / result.to_stream_seconds : 0;
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * Measures replay and random lookup throughput of the shared memory file under
+ * the chainbase mapping options (huge pages, prefault, mlock, NUMA node).
+ *
+ * The shared memory file in --shared-file-dir is wiped and rebuilt from the block
+ * log in --data-dir, so point it at a scratch directory.  Run once per mode and
+ * compare the printed results, e.g.
+ *
+ *   replay_benchmark --data-dir node/blockchain --shared-file-dir /mnt/huge --prefault true
+ */
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <sigmaengine/chain/account_object.hpp>
+#include <sigmaengine/chain/database.hpp>
+
+namespace bpo = boost::program_options;
+
+struct replay_benchmark_result
+{
+   std::string          huge_pages;
+   bool                 prefault = false;
+   bool                 lock = false;
+   int32_t              numa_node = -1;
+
+   uint32_t             blocks = 0;
+   double               replay_seconds = 0;
+   double               blocks_per_second = 0;
+
+   uint64_t             lookups = 0;
+   double               lookup_seconds = 0;
+   double               lookups_per_second = 0;
+};
+
+FC_REFLECT( replay_benchmark_result,
+            (huge_pages)(prefault)(lock)(numa_node)
+            (blocks)(replay_seconds)(blocks_per_second)
+            (lookups)(lookup_seconds)(lookups_per_second) )
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "replay_benchmark options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("data-dir", bpo::value< std::string >()->required(), "Directory containing the block_log to replay")
+         ("shared-file-dir", bpo::value< std::string >()->required(), "Scratch directory for the shared memory file, which is wiped")
+         ("shared-file-size", bpo::value< std::string >()->default_value( "54G" ), "Size of the shared memory file")
+         ("huge-pages", bpo::value< std::string >()->default_value( "none" ), "none or transparent")
+         ("prefault", bpo::value< bool >()->default_value( false ), "Fault the mapping in before replaying")
+         ("lock", bpo::value< bool >()->default_value( false ), "mlock the mapping")
+         ("numa-node", bpo::value< int32_t >()->default_value( -1 ), "Preferred NUMA node, -1 for the default policy")
+         ("lookups", bpo::value< uint64_t >()->default_value( 10000000 ), "Random account lookups by name after the replay")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      replay_benchmark_result result;
+      result.huge_pages = options.at( "huge-pages" ).as< std::string >();
+      result.prefault = options.at( "prefault" ).as< bool >();
+      result.lock = options.at( "lock" ).as< bool >();
+      result.numa_node = options.at( "numa-node" ).as< int32_t >();
+
+      chainbase::mapping_options mapping;
+      if( result.huge_pages == "transparent" )
+         mapping.huge_pages = chainbase::mapping_options::huge_pages_transparent;
+      else
+         FC_ASSERT( result.huge_pages == "none", "huge-pages must be 'none' or 'transparent'" );
+      mapping.prefault = result.prefault;
+      mapping.lock = result.lock;
+      mapping.numa_node = result.numa_node;
+
+      sigmaengine::chain::database db;
+      db.set_mapping_options( mapping );
+
+      auto start = fc::time_point::now();
+      db.reindex( fc::path( options.at( "data-dir" ).as< std::string >() ),
+                  fc::path( options.at( "shared-file-dir" ).as< std::string >() ),
+                  fc::parse_size( options.at( "shared-file-size" ).as< std::string >() ) );
+      auto end = fc::time_point::now();
+
+      result.blocks = db.head_block_num();
+      result.replay_seconds = double( ( end - start ).count() ) / 1000000.0;
+      result.blocks_per_second = result.replay_seconds > 0 ? result.blocks / result.replay_seconds : 0;
+
+      result.lookups = options.at( "lookups" ).as< uint64_t >();
+      db.with_read_lock( [&]()
+      {
+         std::vector< sigmaengine::protocol::account_name_type > names;
+         for( const auto& a : db.get_index< sigmaengine::chain::account_index >().indices() )
+            names.push_back( a.name );
+         FC_ASSERT( !names.empty(), "Replayed chain has no accounts to look up" );
+
+         std::mt19937_64 rng( 0 );
+         std::uniform_int_distribution< size_t > pick( 0, names.size() - 1 );
+         uint64_t found = 0;
+
+         auto lookup_start = fc::time_point::now();
+         for( uint64_t i = 0; i < result.lookups; ++i )
+            found += db.find< sigmaengine::chain::account_object, sigmaengine::chain::by_name >( names[ pick( rng ) ] ) != nullptr;
+         auto lookup_end = fc::time_point::now();
+
+         FC_ASSERT( found == result.lookups );
+         result.lookup_seconds = double( ( lookup_end - lookup_start ).count() ) / 1000000.0;
+         result.lookups_per_second = result.lookup_seconds > 0 ? result.lookups / result.lookup_seconds : 0;
+      });
+
+      db.close();
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}
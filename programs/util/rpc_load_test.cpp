@@ -0,0 +1,166 @@
+/**
+ * Measures RPC throughput of a running node, with and without JSON-RPC batching.
+ *
+ * Every request is the same API call.  With --batch-size 0 each call is sent as
+ * its own message, keeping --window of them in flight; otherwise the calls are
+ * grouped into batch arrays, one batch in flight at a time.  Run once per mode
+ * and compare the printed results, e.g.
+ *
+ *   rpc_load_test --server ws://127.0.0.1:8090 --method get_block --params '[1]' --batch-size 50
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/network/http/websocket.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+namespace bpo = boost::program_options;
+
+struct rpc_load_test_result
+{
+   std::string          method;
+   uint32_t             batch_size = 0;
+   uint32_t             window = 0;
+
+   uint64_t             calls = 0;
+   uint64_t             errors = 0;
+   uint64_t             messages = 0;
+   double               seconds = 0;
+   double               calls_per_second = 0;
+};
+
+FC_REFLECT( rpc_load_test_result,
+            (method)(batch_size)(window)
+            (calls)(errors)(messages)(seconds)(calls_per_second) )
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "rpc_load_test options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("server,s", bpo::value< std::string >()->default_value( "ws://127.0.0.1:8090" ), "Websocket RPC endpoint of the node")
+         ("api", bpo::value< std::string >()->default_value( "database_api" ), "API to call")
+         ("method", bpo::value< std::string >()->default_value( "get_dynamic_global_properties" ), "Method to call")
+         ("params", bpo::value< std::string >()->default_value( "[]" ), "JSON array of call parameters")
+         ("calls", bpo::value< uint64_t >()->default_value( 100000 ), "Total number of calls")
+         ("batch-size", bpo::value< uint32_t >()->default_value( 0 ), "Calls per batch request, 0 sends each call as its own message")
+         ("window", bpo::value< uint32_t >()->default_value( 1 ), "Unbatched calls kept in flight")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      rpc_load_test_result result;
+      result.method = options.at( "api" ).as< std::string >() + "." + options.at( "method" ).as< std::string >();
+      result.batch_size = options.at( "batch-size" ).as< uint32_t >();
+      result.window = result.batch_size ? 1 : std::max< uint32_t >( options.at( "window" ).as< uint32_t >(), 1 );
+      result.calls = options.at( "calls" ).as< uint64_t >();
+
+      fc::variants call_params{ options.at( "api" ).as< std::string >(),
+                                options.at( "method" ).as< std::string >(),
+                                fc::json::from_string( options.at( "params" ).as< std::string >() ).get_array() };
+      auto make_call = [&]( uint64_t id )
+      {
+         return fc::json::to_string( fc::mutable_variant_object( "jsonrpc", "2.0" )( "id", id )( "method", "call" )( "params", call_params ) );
+      };
+
+      fc::http::websocket_client client;
+      auto con = client.connect( options.at( "server" ).as< std::string >() );
+
+      // Replies still expected, and the count below which the sender is woken
+      uint64_t outstanding = 0;
+      uint64_t wake_below = result.window;
+      fc::promise< void >::ptr drained;
+      con->on_message_handler( [&]( const std::string& msg )
+      {
+         auto reply = fc::json::from_string( msg );
+         fc::variants replies = reply.is_array() ? reply.get_array() : fc::variants{ reply };
+         for( const auto& r : replies )
+            if( !r.is_object() || r.get_object().contains( "error" ) )
+               ++result.errors;
+         outstanding -= std::min< uint64_t >( outstanding, replies.size() );
+         if( outstanding < wake_below && drained )
+         {
+            auto p = drained;
+            drained.reset();
+            p->set_value();
+         }
+      } );
+
+      const uint32_t per_message = std::max< uint32_t >( result.batch_size, 1 );
+      uint64_t next_id = 0;
+      auto start = fc::time_point::now();
+      while( next_id < result.calls )
+      {
+         uint64_t count = std::min< uint64_t >( per_message, result.calls - next_id );
+         if( result.batch_size )
+         {
+            std::string batch = "[";
+            for( uint64_t i = 0; i < count; ++i )
+            {
+               if( i )
+                  batch += ',';
+               batch += make_call( next_id++ );
+            }
+            batch += ']';
+            outstanding += count;
+            con->send_message( batch );
+         }
+         else
+         {
+            outstanding += 1;
+            con->send_message( make_call( next_id++ ) );
+         }
+         ++result.messages;
+
+         if( outstanding >= result.window )
+         {
+            fc::promise< void >::ptr p( new fc::promise< void >( "rpc_load_test drained" ) );
+            drained = p;
+            p->wait();
+         }
+      }
+      wake_below = 1;
+      if( outstanding )
+      {
+         fc::promise< void >::ptr p( new fc::promise< void >( "rpc_load_test drained" ) );
+         drained = p;
+         p->wait();
+      }
+      auto end = fc::time_point::now();
+
+      result.seconds = double( ( end - start ).count() ) / 1000000.0;
+      result.calls_per_second = result.seconds > 0 ? result.calls / result.seconds : 0;
+
+      con->close( 0, "done" );
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * Measures the throughput of the p2p secure channel over loopback, with the original
+ * AES-256-CBC stream and with AES-256-GCM records.
+ *
+ * Two stcp_sockets are connected over 127.0.0.1 and the writer sends --megabytes of
+ * padded messages of --message-size bytes, --batch at a time as the p2p send queue
+ * does, while the reader reads them back.  e.g.
+ *
+ *   stcp_benchmark --megabytes 512 --message-size 1024 --batch 64
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <graphene/net/stcp_socket.hpp>
+
+namespace bpo = boost::program_options;
+using graphene::net::stcp_socket;
+
+struct channel_result
+{
+   double               seconds = 0;
+   double               mb_per_second = 0;
+};
+
+struct stcp_benchmark_result
+{
+   uint64_t             bytes = 0;
+   uint32_t             message_size = 0;
+   uint32_t             batch = 0;
+   channel_result       cbc;
+   channel_result       gcm;
+};
+
+FC_REFLECT( channel_result, (seconds)(mb_per_second) )
+FC_REFLECT( stcp_benchmark_result, (bytes)(message_size)(batch)(cbc)(gcm) )
+
+namespace {
+
+   channel_result run( bool gcm, uint64_t bytes, uint32_t message_size, uint32_t batch )
+   {
+      fc::tcp_server server;
+      server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+
+      stcp_socket acceptor;
+      stcp_socket connector;
+      fc::future< void > accepted = fc::async( [&]() {
+         server.accept( acceptor.get_socket() );
+         acceptor.accept();
+      }, "stcp_benchmark accept" );
+      connector.connect_to( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), server.get_port() ) );
+      accepted.wait();
+
+      if( gcm )
+      {
+         connector.start_aead_send();
+         acceptor.start_aead_receive();
+      }
+
+      std::vector< char > message( message_size, 'x' );
+      std::vector< std::pair< const char*, size_t > > buffers( batch, std::make_pair( message.data(), message.size() ) );
+      uint64_t batches = ( bytes + uint64_t( message_size ) * batch - 1 ) / ( uint64_t( message_size ) * batch );
+
+      fc::time_point start = fc::time_point::now();
+      fc::future< void > written = fc::async( [&]() {
+         for( uint64_t i = 0; i < batches; ++i )
+            connector.write_buffers( buffers );
+         connector.flush();
+      }, "stcp_benchmark write" );
+
+      std::unique_ptr< char[] > read_buffer( new char[ 64 * 1024 ] );
+      for( uint64_t remaining = batches * message_size * batch; remaining; )
+         remaining -= acceptor.readsome( read_buffer.get(), std::min< uint64_t >( remaining, 64 * 1024 ) );
+      written.wait();
+
+      channel_result result;
+      result.seconds = double( ( fc::time_point::now() - start ).count() ) / 1000000;
+      result.mb_per_second = double( batches * message_size * batch ) / ( 1024 * 1024 ) / result.seconds;
+
+      connector.close();
+      acceptor.close();
+      return result;
+   }
+
+}
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description opts( "stcp_benchmark options" );
+      opts.add_options()
+         ("help,h", "Print this help message and exit")
+         ("megabytes", bpo::value< uint32_t >()->default_value( 256 ), "Data sent over each channel")
+         ("message-size", bpo::value< uint32_t >()->default_value( 1024 ), "Padded size of a message, a multiple of 16")
+         ("batch", bpo::value< uint32_t >()->default_value( 64 ), "Messages handed to the socket in one write")
+         ;
+
+      bpo::variables_map options;
+      bpo::store( bpo::parse_command_line( argc, argv, opts ), options );
+      if( options.count( "help" ) )
+      {
+         std::cout << opts << "\n";
+         return 0;
+      }
+      bpo::notify( options );
+
+      stcp_benchmark_result result;
+      result.bytes = uint64_t( options.at( "megabytes" ).as< uint32_t >() ) * 1024 * 1024;
+      result.message_size = options.at( "message-size" ).as< uint32_t >();
+      result.batch = options.at( "batch" ).as< uint32_t >();
+      FC_ASSERT( result.message_size > 0 && result.message_size % 16 == 0, "message-size must be a multiple of 16" );
+      FC_ASSERT( result.batch > 0 );
+
+      result.cbc = run( false, result.bytes, result.message_size, result.batch );
+      result.gcm = run( true, result.bytes, result.message_size, result.batch );
+
+      std::cout << fc::json::to_pretty_string( result ) << std::endl;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+      return 1;
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+      return 1;
+   }
+   return 0;
+}